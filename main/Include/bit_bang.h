@@ -0,0 +1,48 @@
+#ifndef BIT_BANG_H
+#define BIT_BANG_H
+
+#include <stdint.h>
+
+// Clock idles high, HT1632 latches data on the rising WR (clk) edge.
+// Pins are written through the GPIO out set/clear registers, so they must be < 32.
+#define CLK_LO      0
+#define CLK_HI      1
+#define DATA_LO     0
+#define DATA_HI     1
+
+// Default timing (ns). Busy waits are calibrated against the CPU cycle counter.
+#define BIT_BANG_SETUP_NS       500     // Clk low with data valid, before the rising edge
+#define BIT_BANG_HOLD_NS        500     // Clk high after the rising edge
+#define BIT_BANG_CS_SETUP_NS    1000    // CS low to first clk edge
+#define BIT_BANG_CS_HOLD_NS     1000    // Last rising clk edge to CS high
+
+typedef struct {
+    uint32_t setup_ns;
+    uint32_t hold_ns;
+    uint32_t cs_setup_ns;
+    uint32_t cs_hold_ns;
+} bit_bang_timing_t;
+
+void Bit_bang__Setup(uint8_t clk_pin, uint8_t data_pin);
+void Bit_bang__Setup_cs(uint8_t cs_pin);
+void Bit_bang__Set_timing(const bit_bang_timing_t *timing);
+void Bit_bang__Set_cs(uint8_t cs_pin, uint8_t level);
+void Bit_bang__Write(uint8_t clk_pin, uint8_t data_pin, uint8_t *tx_buffer, uint16_t num_bits);
+
+#if CONFIG_IDF_TARGET_LINUX
+// Host mock: pin writes go to a trace instead of GPIO, time is virtual (advanced only by
+// the configured delays) so the waveform can be checked exactly. Bits clocked while a CS
+// is low are handed to the emulated chip when CS goes high.
+#define BIT_BANG_TRACE_LEN      4096
+
+typedef struct {
+    uint32_t t_ns;
+    uint8_t pin;
+    uint8_t level;
+} bit_bang_edge_t;
+
+uint16_t Bit_bang__Get_trace(const bit_bang_edge_t **trace);
+void Bit_bang__Clear_trace(void);
+#endif
+
+#endif
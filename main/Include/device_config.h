@@ -154,4 +154,36 @@ int Device_Config__Set_WiFi_SSID(const char *ssid);
  */
 int Device_Config__Set_WiFi_Password(const char *password);
 
+/**
+ * @brief Get calibrated LED bus clock
+ * 
+ * @param clock_hz Pointer to store clock (Hz)
+ * @return 0 on success, -1 on error or if never calibrated
+ */
+int Device_Config__Get_Led_clock_hz(uint32_t *clock_hz);
+
+/**
+ * @brief Set calibrated LED bus clock (writes to NVS)
+ * 
+ * @param clock_hz Clock (Hz), 0 forces calibration on next boot
+ * @return 0 on success, -1 on error
+ */
+int Device_Config__Set_Led_clock_hz(uint32_t clock_hz);
+
+/**
+ * @brief Get panel orientation of this unit
+ * 
+ * @param orientation Pointer to store orientation (LED_ORIENT_* | LED_ORIENT_MIRROR)
+ * @return 0 on success, -1 on error
+ */
+int Device_Config__Get_Led_orientation(uint8_t *orientation);
+
+/**
+ * @brief Set panel orientation of this unit (writes to NVS)
+ * 
+ * @param orientation LED_ORIENT_0/90/180/270, optionally | LED_ORIENT_MIRROR
+ * @return 0 on success, -1 on error
+ */
+int Device_Config__Set_Led_orientation(uint8_t orientation);
+
 #endif // DEVICE_CONFIG_H
@@ -23,7 +23,7 @@ typedef struct {
     event_type_t type;
     uint32_t data;          // Button number, encoder direction, etc.
     void* payload;          // Optional additional data
-    uint32_t timestamp;     // For debugging/timing
+    uint32_t timestamp;     // esp_timer us (low 32 bits) when the input was detected, for latency tracing
 } system_event_t;
 
 // Event System Configuration
@@ -36,6 +36,7 @@ extern QueueHandle_t systemEventQueue;
 // Public functions
 void EventSystem_Initialize(void);
 void EventSystem_PostEvent(event_type_t type, uint32_t data, void* payload);
+void EventSystem_PostEventAt(event_type_t type, uint32_t data, void* payload, uint32_t timestamp);
 void EventSystem_StartTasks(void);
 void EventSystem_ClearQueue(void);
 
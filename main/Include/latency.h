@@ -0,0 +1,50 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+/* Input-to-photon latency.
+    A UI input is stamped at each stage on its way to the LEDs:
+    detected (button ISR / encoder PCNT poll, carried in system_event_t.timestamp),
+    picked up by the event dispatcher, frame build started, frame handed to the LED driver,
+    and the last bit of that frame leaving the bus. One input is traced at a time; inputs
+    arriving while a trace is in flight ride along in the same frame and are not counted.
+    An input whose frame comes out identical to the one on the LEDs (eg. brightness in the
+    menu) never reaches the bus: it ends the trace and is only counted as unchanged.
+*/
+
+typedef enum {
+    LATENCY_STAGE_QUEUE,        // Detected -> dispatcher (debounce + event queue)
+    LATENCY_STAGE_DISPATCH,     // Dispatcher -> build_new_view starts
+    LATENCY_STAGE_RENDER,       // Build start -> frame handed to the LED driver
+    LATENCY_STAGE_TRANSMIT,     // Handed over -> frame off the bus (driver frame-done)
+    LATENCY_STAGE_TOTAL,        // Detected -> on the LEDs
+    LATENCY_NUM_STAGES
+} latency_stage_t;
+
+// log2 histogram: bucket 0 counts < 2 us, bucket k counts [2^k, 2^(k+1)) us, last bucket is open ended (>= 262 ms)
+#define LATENCY_NUM_BUCKETS     19
+
+// Trace dropped if its frame does not reach the LEDs within this time (eg. input did not change the view)
+#define LATENCY_TRACE_TIMEOUT_US    1000000
+
+typedef struct {
+    uint32_t bucket[LATENCY_NUM_BUCKETS];
+    uint32_t num_samples;
+    uint32_t max_us;
+    uint64_t total_us;
+} latency_histogram_t;
+
+void Latency__Mark_dispatch(uint32_t detect_us);
+void Latency__Mark_build_start(void);
+void Latency__Mark_frame_published(uint32_t frame_seq);
+void Latency__Mark_frame_unchanged(void);
+void Latency__Mark_frame_done(int64_t done_us, uint32_t frame_seq);
+
+void Latency__Get_histogram(latency_stage_t stage, latency_histogram_t *histogram);
+uint32_t Latency__Get_num_unchanged(void);
+void Latency__Reset(void);
+void Latency__Log(void);
+const char *Latency__Stage_name(latency_stage_t stage);
+
+#endif
@@ -2,15 +2,47 @@
 #define LED_DISPLAY_H
 
 #include "view.h"
+#include "led_transport.h"
 
-// To set row LEDs according to bits, either use SPI or bit bang gpio
-#define USE_SPI_BIT_BANG     0
+// Transport that clocks bitstreams into the LED driver chips
+#define LED_TRANSPORT_SPI       0   // SPI peripheral
+#define LED_TRANSPORT_BIT_BANG  1   // Bit bang gpio
+#define LED_TRANSPORT_EMULATOR  2   // No hardware: decode into emulated chip RAM (led_emulator.c)
+
+#ifndef LED_TRANSPORT
+#if CONFIG_IDF_TARGET_LINUX
+#define LED_TRANSPORT   LED_TRANSPORT_EMULATOR
+#else
+#define LED_TRANSPORT   LED_TRANSPORT_SPI
+#endif
+#endif
 
 // define pins for spi protocol
 #define CS_BLUE         7
 #define CS_RED          8
 #define DATA_PIN        9
 #define CLK_PIN         10 
+#define RD_PIN          -1      // HT1632 RD line for read-back, -1 when not wired (no clock calibration)
+
+// Clock calibration reads test patterns back: the emulator always can, SPI only with RD wired
+#if (LED_TRANSPORT == LED_TRANSPORT_EMULATOR) || (LED_TRANSPORT == LED_TRANSPORT_SPI && RD_PIN >= 0)
+#define LED_CLOCK_CALIBRATION   1
+#else
+#define LED_CLOCK_CALIBRATION   0
+#endif
+
+// Panels chained on the shared bus (DATA_PIN, CLK_PIN), in chain order. Each 16x16 module is
+// a red and a blue HT1632 with its own chip selects. Exactly one chip on the chain drives
+// the SYNC line (SET_MASTER), all others follow it (SET_SLAVE).
+// SPI transport: SPI2 has 6 hardware chip selects, so up to 3 panels.
+#ifndef LED_NUM_PANELS
+#define LED_NUM_PANELS  1
+#define LED_PANELS      { \
+    { .cs_red = CS_RED, .cs_blue = CS_BLUE, .sync_red = SET_MASTER, .sync_blue = SET_SLAVE }, \
+}
+// eg. 32x16 wall, second module on gpio 5/6:
+//  { .cs_red = 6, .cs_blue = 5, .sync_red = SET_SLAVE, .sync_blue = SET_SLAVE },
+#endif
 
 #define SPI_MODE        3   // 00: Clk idle low? sample rising edge (OR) 11: Clock idle high, sample on rising edge
 #define CS_ACTIVE       0
@@ -22,6 +54,55 @@
 #define SET_WRITE_MODE  0x0280  // 0000-0010-1000-0000: 101 AAAAAAA
 #define SET_WRITE_LEN   10      // 101 AAAA AAA
 #define WRITE_LEN       4       // DDDD
+#define SET_READ_MODE   0x0300  // 0000-0011-0000-0000: 110 AAAAAAA (same length as write header)
+
+// Bus clock calibration: steps tried in order, each must read back every pattern pass
+#define LED_CLOCK_DEFAULT_HZ        1000
+#define LED_CLOCK_STEPS_HZ          {1000, 10000, 50000, 100000, 200000, 400000, 800000, 1000000}
+#define LED_CLOCK_VERIFY_PASSES     3
+
+// Grayscale (bit-plane) frames: on time of the least significant plane, and the slowest
+// bus clock that can still cycle planes without visible flicker
+#define LED_GRAY_BASE_US            500
+#define LED_GRAY_MIN_CLOCK_HZ       200000
+
+// RAM scrubbing (needs read-back): a low priority task reads chip RAM back LED_SCRUB_WINDOW_ADDR
+// addresses at a time and rewrites nibbles that differ from the shadow. Bus time it may use
+// is LED_SCRUB_BUDGET_US per second of wall time (0 = off), checked every LED_SCRUB_PERIOD_MS.
+#define LED_SCRUB_WINDOW_ADDR       8
+#define LED_SCRUB_PERIOD_MS         250
+#define LED_SCRUB_BUDGET_US         20000   // 2% of the bus
+
+// Current limiting: estimated supply current = lit LEDs * LED_CURRENT_PER_LED_UA * (PWM level + 1) / 16.
+// LEDs are counted per frame (grayscale planes weighted by on time) and the brightness of that
+// frame is capped so the estimate stays within the budget (0 = no cap). Level 0 is the floor.
+// Budget from menuconfig, off by default: eg. 300 mA would dim anything over 240 lit LEDs.
+#define LED_CURRENT_PER_LED_UA      1250    // Average per lit LED at 16/16 duty (1/16 row multiplex)
+#ifdef CONFIG_LED_CURRENT_BUDGET_MA
+#define LED_CURRENT_BUDGET_MA       CONFIG_LED_CURRENT_BUDGET_MA
+#else
+#define LED_CURRENT_BUDGET_MA       0
+#endif
+#define LED_SUPPLY_MV               5000    // For energy accounting
+
+// Brightness fades: one PWM level per step, steps spread evenly over the fade and timed from
+// its start (a late step does not push back the rest). Never closer than LED_FADE_MIN_STEP_MS.
+#define LED_FADE_MIN_STEP_MS        10
+
+// Orientation of the mounted unit, applied to every frame before the wiring tables
+// (Kconfig panel flips still apply after it). Quarter turns of the view (row r, col c):
+//  90: (r, c) -> (c, 15 - r)   180: (r, c) -> (15 - r, 15 - c)   270: (r, c) -> (15 - c, r)
+// LED_ORIENT_MIRROR additionally reverses each row (col c -> 15 - c) after the turn.
+#define LED_ORIENT_0                0
+#define LED_ORIENT_90               1
+#define LED_ORIENT_180              2
+#define LED_ORIENT_270              3
+#define LED_ORIENT_MIRROR           0x04
+#define LED_ORIENT_CYCLE_BUDGET     4000    // CPU cycles per translated frame for the transform
+
+// Differential RAM updates: unchanged gap (in addresses) still merged into one write run.
+// A new run costs SET_WRITE_LEN bits + a CS cycle, each gap address costs WRITE_LEN bits.
+#define RAM_DIFF_MERGE_GAP  2
 
 // following definitions are the 8 most sig bits of the config
 // will need to shift these left one to account for extra bit at LSB
@@ -33,13 +114,92 @@
 #define LED_ON          0x03    // 0000 0011  -enable LED duty
 #define LED_OFF         0x02    // 0000 0010  -disable LED duty
 #define PWM_DUTY        0xA0    // 101X DDDD  - set D to desired duty
+#define BLINK_OFF       0x08    // 0000 1000  -turn off blinking
+#define BLINK_ON        0x09    // 0000 1001  -blink every LED (chip oscillator, no bus traffic)
+
+// One 16x16 module on the chain (see LED_PANELS)
+typedef struct {
+    uint8_t cs_red;
+    uint8_t cs_blue;
+    uint8_t sync_red;       // SET_MASTER or SET_SLAVE
+    uint8_t sync_blue;
+} led_panel_t;
 
+// Frame push statistics, updated by the transmit task for every frame put on the wire.
+// Frame figures cover all LED_NUM_PANELS panels.
+typedef struct {
+    uint32_t num_frames;
+    uint32_t last_frame_ns;     // Time from transmit start until the last frame left the wire (all panels)
+    uint32_t avg_frame_ns;      // Running average over num_frames
+    uint32_t max_frame_ns;
+    uint32_t bytes_per_frame;   // Bytes clocked out (all chips) for the last frame
+    uint32_t bits_per_frame;    // Bits clocked out (all chips) for the last frame, full rewrite = 788 per panel
+    uint32_t avg_bits_per_frame;
+    uint32_t transactions_per_frame;
+    uint32_t num_skipped_frames;    // Frames with no RAM change, nothing sent
+    uint32_t num_replaced_frames;   // Frames replaced by a newer one before being sent
+    uint32_t num_planes_shown;      // Grayscale planes written
+    uint32_t num_gray_cycles;       // Full passes over all planes
+    uint32_t gray_cycle_us;         // Duration of the last pass (effective refresh = 1e6 / this)
+    uint32_t num_commands;          // Commands requested (brightness, on/off)
+    uint32_t num_commands_coalesced;    // Replaced by a newer command of the same kind before being sent
+    uint32_t num_command_streams;   // Command mode transactions sent for them (one per chip per batch)
+    uint32_t num_blink_toggles;     // Region blink phase changes written without a new frame
+    uint32_t blink_bits;            // Bits clocked out for them (all chips)
+    uint32_t num_scrub_windows;     // Read-back windows compared against the shadow
+    uint32_t num_scrub_repairs;     // Corrupted nibbles rewritten
+    uint32_t num_scrub_passes;      // Full passes over every chip's RAM
+    uint64_t scrub_bus_us;          // Bus time used by the scrubber
+    uint16_t lit_leds;              // Lit LEDs (all panels) of the frame on the chips
+    uint8_t pwm_level;              // Brightness level on the chips (requested level, capped)
+    uint32_t current_ma;            // Estimated supply current right now
+    uint32_t peak_current_ma;
+    uint32_t num_capped_frames;     // Frames shown below the requested brightness to fit the budget
+    uint64_t energy_uj;             // Estimated energy since boot
+    uint32_t orient_max_cycles;     // Worst orientation transform (one frame, all channels)
+    uint32_t num_orient_over_budget;    // Transforms above LED_ORIENT_CYCLE_BUDGET
+    uint32_t num_fade_steps;
+    uint32_t fade_max_late_us;      // Worst step lateness against its scheduled time
+} led_driver_stats_t;
 
 void Led_driver__Initialize(void);
 void Led_driver__Setup(void);
 void Led_driver__Update_RAM(view_frame_t*);
+void Led_driver__Update_RAM_panels(view_frame_t*);
+void Led_driver__Update_RAM_gray(view_gray_frame_t*);
 void Led_driver__Clear_RAM(void);
+void Led_driver__Invalidate_RAM(void);
 void Led_driver__Set_brightness(uint8_t);
 void Led_driver__Toggle_LED(uint8_t);
+void Led_driver__Set_blink(uint8_t);
+void Led_driver__Fade_brightness(uint8_t, uint32_t);
+void Led_driver__Fade_LED(uint8_t, uint32_t);
+void Led_driver__Set_blink_region(const view_frame_t*, uint16_t);
+void Led_driver__Set_transport(const led_transport_t*);
+void Led_driver__Get_stats(led_driver_stats_t*);
+
+// Frames are numbered as they are handed over (Update_RAM*), the callback gets the number
+// of the frame that just left the wire. A replaced frame never reaches the callback.
+typedef void (*led_frame_done_cb_t)(int64_t done_us, uint32_t frame_seq);
+void Led_driver__Set_frame_done_callback(led_frame_done_cb_t);
+int64_t Led_driver__Get_frame_done_us(void);
+uint32_t Led_driver__Get_frame_seq(void);
+
+// Grayscale timing report from the host simulator (emulator transport)
+typedef struct {
+    float refresh_hz;           // Full plane cycles per second
+    float mean_duty_error;      // |measured - expected| on time fraction, averaged over all pixels
+    float max_duty_error;
+} led_gray_report_t;
+int Led_driver__Simulate_gray(uint32_t, led_gray_report_t*);
+
+void Led_driver__Set_clock_hz(uint32_t);
+uint32_t Led_driver__Get_clock_hz(void);
+int Led_driver__Calibrate_clock(uint32_t*);
+void Led_driver__Set_scrub_budget(uint32_t);
+void Led_driver__Set_current_budget(uint16_t);
+void Led_driver__Set_orientation(uint8_t);
+uint8_t Led_driver__Get_orientation(void);
+uint16_t Led_driver__Get_current_budget(void);
 
 #endif
\ No newline at end of file
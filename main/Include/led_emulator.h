@@ -0,0 +1,49 @@
+#ifndef LED_EMULATOR_H
+#define LED_EMULATOR_H
+
+#include <stdint.h>
+#include "led_transport.h"
+
+#define LED_EMULATOR_MAX_CHIPS      8       // 4 chained panels
+#define LED_EMULATOR_RAM_NIBBLES    96      // 24 rows * 4 addr/row
+#define LED_EMULATOR_RAM_ROWS       24
+
+// Writes clocked faster than this get bit errors injected (0 = never)
+#define LED_EMULATOR_ERROR_CLOCK_HZ 250000
+
+// HT1632 mode ids (first 3 bits of every transaction)
+#define LED_EMULATOR_MODE_READ      6       // 110
+#define LED_EMULATOR_MODE_WRITE     5       // 101
+#define LED_EMULATOR_MODE_CMD       4       // 100
+
+// State of one emulated chip. RAM nibbles are stored in clocking order:
+// first bit clocked for an address lands in bit 3 of ram[addr].
+typedef struct {
+    uint8_t cs_pin;
+    uint8_t in_use;
+    uint8_t ram[LED_EMULATOR_RAM_NIBBLES];
+    uint8_t sys_on;
+    uint8_t led_on;
+    uint8_t blink_on;       // BLINK ON: whole display blinks on the chip oscillator
+    uint8_t pwm_duty;       // 0-15
+    uint8_t pwm_duty_peak;  // Highest pwm_duty since Led_emulator__Start_duty_capture
+    uint8_t is_master;
+    uint8_t com_option;
+    uint32_t num_transactions;
+    uint32_t num_bits;
+    uint32_t num_errors;    // malformed/unsupported transactions
+    uint32_t num_injected;  // bit errors injected (clock above error threshold)
+} led_emulator_chip_t;
+
+void Led_emulator__Reset(void);
+void Led_emulator__Write(uint8_t cs_pin, uint8_t *tx_buffer, uint16_t num_bits);
+const led_emulator_chip_t *Led_emulator__Get_chip(uint8_t cs_pin);
+void Led_emulator__Get_RAM_rows(uint8_t cs_pin, uint16_t *rows);
+void Led_emulator__Set_clock_hz(uint32_t clock_hz);
+void Led_emulator__Set_error_clock_hz(uint32_t clock_hz);
+void Led_emulator__Start_duty_capture(void);
+float Led_emulator__Get_duty(uint8_t cs_pin, uint8_t addr, uint8_t bit);
+int Led_emulator__Read(uint8_t cs_pin, uint8_t *tx_buffer, uint16_t num_bits, uint8_t *rx_nibbles, uint8_t num_nibbles);
+void Led_emulator__Flip_RAM_bit(uint8_t cs_pin, uint8_t addr, uint8_t bit);
+
+#endif
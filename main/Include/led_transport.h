@@ -0,0 +1,38 @@
+#ifndef LED_TRANSPORT_H
+#define LED_TRANSPORT_H
+
+#include <stdint.h>
+
+/* Transport layer under the LED driver.
+    The driver assembles complete HT1632 bitstreams (command mode 100, write mode 101)
+    and hands them to a transport, which clocks them into one chip selected by its CS pin.
+
+    Buffer layout is wire order: the stream's first bit is the MSB of tx_buffer[0].
+    Bits past num_bits in the last byte are padding and must not be clocked out.
+
+    write may return before the bits are on the wire (queued), but must not keep a reference
+    to tx_buffer. flush waits for everything queued so far.
+
+    read clocks a READ mode header (110 AAAAAAA, in tx_buffer) then reads num_nibbles
+    successive RAM nibbles back from the chip (needs the HT1632 RD line).
+*/
+
+typedef void (*led_transport_init_fn)(void);
+typedef void (*led_transport_write_fn)(uint8_t cs_pin, uint8_t *tx_buffer, uint16_t num_bits);
+typedef int64_t (*led_transport_flush_fn)(void);
+typedef void (*led_transport_set_clock_fn)(uint32_t clock_hz);
+typedef int (*led_transport_read_fn)(uint8_t cs_pin, uint8_t *tx_buffer, uint16_t num_bits, uint8_t *rx_nibbles, uint8_t num_nibbles);
+
+typedef struct {
+    const char *name;
+    led_transport_init_fn init;         // Called once from Led_driver__Initialize (may be NULL)
+    led_transport_write_fn write;       // Clock num_bits of tx_buffer into chip at cs_pin
+    led_transport_flush_fn flush;       // Wait for queued writes, return esp_timer us of completion (NULL: write is synchronous)
+    led_transport_set_clock_fn set_clock_hz;    // Change bus clock (may be NULL)
+    led_transport_read_fn read;         // Read back RAM, 0 on success / -1 (NULL: no read-back)
+} led_transport_t;
+
+// Emulated HT1632 pair (see led_emulator.c). Used on host builds, can be swapped in at runtime.
+extern const led_transport_t Led_transport_emulator;
+
+#endif
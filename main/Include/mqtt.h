@@ -18,6 +18,8 @@ extern uint16_t view_main[16];
     #define MQTT_TOPIC_OFFLINE              "debug_device_offline"
     #define MQTT_TOPIC_TEST                 "debug_test_msg"
     #define MQTT_TOPIC_ETCH_SKETCH          "debug_etch_sketch"
+    #define MQTT_TOPIC_LATENCY              "debug_dev_latency"
+    #define MQTT_TOPIC_RECORDER             "debug_dev_recorder"
 #else
     // Production topics (zipcode appended at runtime)
     #define MQTT_TOPIC_WEATHER_BASE         "weather"
@@ -26,6 +28,8 @@ extern uint16_t view_main[16];
     #define MQTT_TOPIC_HEARTBEAT            "dev_heartbeat"
     #define MQTT_TOPIC_OFFLINE              "device_offline"
     #define MQTT_TOPIC_ETCH_SKETCH          "etch_sketch"
+    #define MQTT_TOPIC_LATENCY              "dev_latency"
+    #define MQTT_TOPIC_RECORDER             "dev_recorder"
 #endif
 
 // This client publishes to these topics (notify/update server)
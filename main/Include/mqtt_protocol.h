@@ -2,6 +2,7 @@
 #define MQTT_PROTOCOL_H
 
 #include <stdint.h>
+#include "latency.h"
 
 /**
  * MQTT Binary Message Protocol
@@ -20,14 +21,23 @@
 #define MSG_TYPE_DEVICE_CONFIG      0x03
 #define MSG_TYPE_VERSION            0x10
 #define MSG_TYPE_HEARTBEAT          0x11
+#define MSG_TYPE_POWER_REPORT       0x12
+#define MSG_TYPE_RENDER_PROFILE     0x13
 #define MSG_TYPE_ETCH_GET_FRAME     0x20
 #define MSG_TYPE_ETCH_UPDATE_FRAME  0x21
+#define MSG_TYPE_LATENCY_GET        0x30
+#define MSG_TYPE_LATENCY_REPORT     0x31
+#define MSG_TYPE_RECORDER_GET       0x32
+#define MSG_TYPE_RECORDER_CHUNK     0x33
 
 
 // Protocol Constants
 #define MQTT_PROTOCOL_HEADER_SIZE   2
 #define MQTT_PROTOCOL_MAX_PAYLOAD   255
 
+// Recorder dump: chunk header [chunk_index][num_chunks], rest of the payload is dump data
+#define MQTT_RECORDER_CHUNK_DATA    (MQTT_PROTOCOL_MAX_PAYLOAD - 2)
+
 // Temperature offset for current weather (to handle negative temps as uint8)
 #define TEMP_OFFSET                 50
 
@@ -88,6 +98,30 @@ typedef struct {
     uint16_t version;        // Firmware version number
 } mqtt_version_t;
 
+/**
+ * @brief Power report message payload (LED driver current/energy estimate)
+ * Total message size: 16 bytes (header + payload)
+ */
+typedef struct {
+    uint32_t energy_j;          // Estimated LED energy since boot
+    uint16_t current_ma;        // Estimated supply current now
+    uint16_t peak_current_ma;
+    uint16_t budget_ma;         // Current budget brightness is capped to (0 = no cap)
+    uint32_t num_capped_frames; // Frames shown below the requested brightness
+} mqtt_power_report_t;
+
+/**
+ * @brief Render profile of one view (CPU cycles per render)
+ * Per view payload: 20 bytes
+ */
+typedef struct {
+    uint32_t num_samples;       // Renders since boot
+    uint32_t min_cycles;
+    uint32_t avg_cycles;
+    uint32_t max_cycles;
+    uint32_t p99_cycles;        // Over the view's recent renders
+} mqtt_render_profile_t;
+
 typedef struct {
     uint16_t seq;         // Sequence number for gap detection
     uint16_t red[16];
@@ -167,6 +201,31 @@ int mqtt_protocol_build_device_config(const char **strings, uint8_t num_strings,
  */
 int mqtt_protocol_build_heartbeat(const char *device_name, uint8_t *buffer, uint8_t buffer_size);
 
+/**
+ * @brief Build power report message
+ * 
+ * @param report Power figures to send
+ * @param buffer Output buffer for complete message (header + payload)
+ * @param buffer_size Size of output buffer
+ * @return Number of bytes written, or -1 on error
+ */
+int mqtt_protocol_build_power_report(const mqtt_power_report_t *report, uint8_t *buffer, uint8_t buffer_size);
+
+/**
+ * @brief Build render profile message
+ * Payload: [cpu_mhz: uint16][num_views] then per view (View_type order):
+ * [num_samples][min_cycles][avg_cycles][max_cycles][p99_cycles], uint32 each, big-endian
+ * 
+ * @param profiles Array of num_views profiles
+ * @param num_views Number of views
+ * @param cpu_mhz CPU clock the cycles were counted at
+ * @param buffer Output buffer for complete message (header + payload)
+ * @param buffer_size Size of output buffer
+ * @return Number of bytes written, or -1 on error
+ */
+int mqtt_protocol_build_render_profile(const mqtt_render_profile_t *profiles, uint8_t num_views, uint16_t cpu_mhz,
+                                       uint8_t *buffer, uint16_t buffer_size);
+
 int mqtt_protocol_build_etch_get_frame(uint8_t *buffer, uint8_t buffer_size);
 int mqtt_protocol_parse_etch_update_frame(const uint8_t *payload, uint8_t payload_len,
                                           mqtt_etch_sketch_frame_t *frame);
@@ -179,4 +238,33 @@ int mqtt_protocol_parse_shared_view_updates(const uint8_t *payload, uint8_t payl
                                             mqtt_shared_pixel_update_t *updates, uint8_t max_updates, 
                                             uint8_t *out_count, uint16_t *out_seq);
 
+/**
+ * @brief Build latency report with one log2 histogram per stage
+ * Payload: [num_stages][num_buckets] then per stage (in latency_stage_t order):
+ * [num_samples: uint32][max_us: uint32][bucket counts: num_buckets x uint16, saturated],
+ * then [num_unchanged: uint32], big-endian
+ * 
+ * @param histograms Array of LATENCY_NUM_STAGES histograms
+ * @param num_unchanged Inputs whose frame was skipped as unchanged (Latency__Get_num_unchanged)
+ * @param buffer Output buffer for complete message (header + payload)
+ * @param buffer_size Size of output buffer
+ * @return Number of bytes written, or -1 on error
+ */
+int mqtt_protocol_build_latency_report(const latency_histogram_t *histograms, uint32_t num_unchanged, uint8_t *buffer, uint16_t buffer_size);
+
+/**
+ * @brief Build one chunk of a frame recorder dump (View__Recorder_dump)
+ * Payload: [chunk_index][num_chunks][data: up to MQTT_RECORDER_CHUNK_DATA bytes]
+ * 
+ * @param chunk_index Chunk number, 0 first
+ * @param num_chunks Chunks in the whole dump
+ * @param data Dump bytes of this chunk
+ * @param data_len Number of dump bytes
+ * @param buffer Output buffer for complete message (header + payload)
+ * @param buffer_size Size of output buffer
+ * @return Number of bytes written, or -1 on error
+ */
+int mqtt_protocol_build_recorder_chunk(uint8_t chunk_index, uint8_t num_chunks, const uint8_t *data, uint8_t data_len,
+                                       uint8_t *buffer, uint16_t buffer_size);
+
 #endif // MQTT_PROTOCOL_H
@@ -0,0 +1,99 @@
+#ifndef PANEL_WIRING_H
+#define PANEL_WIRING_H
+
+#include <stdint.h>
+
+/* Panel wiring tables: which view line feeds each controller RAM row.
+    One X(ram_row, plane, view_idx) entry per RAM row, 24 per chip. view_idx follows the
+    view_frame_t arrays (view[0] -> col 16, view[15] -> col 1 on the original PCB).
+    The driver expands the selected table into straight-line gather code, so a table costs
+    the same per frame as hand-written assignments. Select the board in menuconfig
+    (LED panel wiring); mirrored mounts are options on top of any table.
+*/
+
+// Original PCB
+#define PANEL_WIRING_REV1_RED(X) \
+    X(0,  green, 2)     \
+    X(1,  red,   3)     \
+    X(2,  green, 3)     \
+    X(3,  green, 4)     \
+    X(4,  red,   5)     \
+    X(5,  green, 1)     \
+    X(6,  red,   1)     \
+    X(7,  red,   0)     \
+    X(8,  green, 5)     \
+    X(9,  red,   6)     \
+    X(10, green, 6)     \
+    X(11, green, 7)     \
+    X(12, red,   8)     \
+    X(13, red,   9)     \
+    X(14, green, 9)     \
+    X(15, red,   10)    \
+    X(16, red,   11)    \
+    X(17, green, 11)    \
+    X(18, red,   12)    \
+    X(19, green, 12)    \
+    X(20, green, 13)    \
+    X(21, green, 15)    \
+    X(22, green, 14)    \
+    X(23, red,   15)
+
+#define PANEL_WIRING_REV1_BLUE(X) \
+    X(0,  green, 10)    \
+    X(1,  blue,  11)    \
+    X(2,  blue,  12)    \
+    X(3,  red,   13)    \
+    X(4,  blue,  13)    \
+    X(5,  red,   14)    \
+    X(6,  blue,  14)    \
+    X(7,  blue,  15)    \
+    X(8,  blue,  10)    \
+    X(9,  blue,  9)     \
+    X(10, green, 8)     \
+    X(11, blue,  8)     \
+    X(12, blue,  7)     \
+    X(13, red,   7)     \
+    X(14, blue,  6)     \
+    X(15, blue,  5)     \
+    X(16, red,   4)     \
+    X(17, blue,  4)     \
+    X(18, blue,  3)     \
+    X(19, red,   2)     \
+    X(20, blue,  2)     \
+    X(21, green, 0)     \
+    X(22, blue,  1)     \
+    X(23, blue,  0)
+
+// Selected board. New revisions: add tables above, a Kconfig entry and an #elif here.
+#if CONFIG_LED_PANEL_WIRING_REV1
+#define PANEL_WIRING_RED    PANEL_WIRING_REV1_RED
+#define PANEL_WIRING_BLUE   PANEL_WIRING_REV1_BLUE
+#else
+// Built without sdkconfig (eg. host): original PCB
+#define PANEL_WIRING_RED    PANEL_WIRING_REV1_RED
+#define PANEL_WIRING_BLUE   PANEL_WIRING_REV1_BLUE
+#endif
+
+// Mirrored mounts
+#if CONFIG_LED_PANEL_FLIP_X
+#define PANEL_VIEW_IDX(idx)     (15 - (idx))
+#else
+#define PANEL_VIEW_IDX(idx)     (idx)
+#endif
+
+// Reverse 16 bits: swap bytes, nibbles, pairs, then single bits
+static inline uint16_t reverse_bits_16(uint16_t bits) {
+    bits = (uint16_t)(((bits & 0xFF00) >> 8) | ((bits & 0x00FF) << 8));
+    bits = (uint16_t)(((bits & 0xF0F0) >> 4) | ((bits & 0x0F0F) << 4));
+    bits = (uint16_t)(((bits & 0xCCCC) >> 2) | ((bits & 0x3333) << 2));
+    bits = (uint16_t)(((bits & 0xAAAA) >> 1) | ((bits & 0x5555) << 1));
+    return bits;
+}
+
+#if CONFIG_LED_PANEL_FLIP_Y
+#define PANEL_ROW_BITS(bits)    reverse_bits_16(bits)
+#else
+#define PANEL_ROW_BITS(bits)    (bits)
+#endif
+
+#endif
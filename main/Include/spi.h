@@ -5,23 +5,20 @@
 
 #define SPI_HOST            SPI2_HOST
 #define DMA_CHANNEL         SPI_DMA_CH_AUTO
-#define SPI_CLOCK_SPEED_HZ  1 * 1000       // 10 kHz
+#define SPI_CLOCK_SPEED_HZ  1 * 1000       // 1 kHz: safe default until the LED driver calibrates the clock
 
-//Bit Bang definitions
-#define MS_DELAY_DATA   1
-#define CLK_LO      0
-#define CLK_HI      1
-#define DATA_LO     0
-#define DATA_HI     1
+// Queued (DMA) transactions: slots in flight at once and max bytes per transaction
+#define SPI_QUEUE_SIZE      16
+#define SPI_TRANS_MAX_BYTES 52              // Full RAM write is 50 bytes, keep 4 byte aligned
 
-#define DEBUG 0
-
-spi_device_handle_t Spi__Init(uint8_t, uint8_t, uint8_t, uint8_t);
+void Spi__Init_bus(uint8_t, uint8_t);
+spi_device_handle_t Spi__Add_device(uint8_t, uint8_t);
 void Spi__Write(spi_device_handle_t, uint8_t*, uint16_t);
+void Spi__Queue_write(spi_device_handle_t, uint8_t*, uint16_t);
+int64_t Spi__Flush(void);
+spi_device_handle_t Spi__Set_clock_hz(spi_device_handle_t, uint8_t, uint8_t, uint32_t);
+uint32_t Spi__Get_clock_hz(void);
+int Spi__Read(spi_device_handle_t, uint8_t, uint8_t, uint8_t*, uint16_t, uint8_t*, uint8_t);
 // void Spi__Write_byte(spi_device_handle_t, uint8_t, uint8_t);
 
-//bitbang
-void Spi__BitBang_Setup(uint8_t, uint8_t);
-void Spi__BitBang_Write(uint8_t, uint8_t, uint8_t*, uint16_t);
-
 #endif
\ No newline at end of file
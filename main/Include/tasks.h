@@ -1,4 +1,63 @@
 #ifndef TASKS_H
 #define TASKS_H
 
-#endif
\ No newline at end of file
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/* Task topology.
+    Every firmware task is created through Tasks__Create from one table in tasks.c
+    (name, core, priority, stack, static or dynamic). WiFi, lwIP, MQTT and Bluedroid
+    run on core 0 (sdkconfig), so our network / BLE tasks join them there and the
+    display, LED driver and input tasks get core 1 to themselves.
+*/
+
+#if CONFIG_FREERTOS_UNICORE
+    #define TASKS_CORE_NETWORK      0
+    #define TASKS_CORE_DISPLAY      0
+#else
+    #define TASKS_CORE_NETWORK      0   // PRO_CPU, with the WiFi / BT stacks
+    #define TASKS_CORE_DISPLAY      1   // APP_CPU: rendering, LED bus, UI input
+#endif
+
+// Tasks tracked for CPU usage, including IDF tasks (wifi, tiT, mqtt, idle, ...)
+#define TASKS_MAX_STATS             32
+
+// Stack a Task_table task should never touch on the target. Tasks__Log_stats warns below it
+// and gives the size to put in the table: bytes used at the high water mark plus this.
+#define TASKS_STACK_MARGIN          1024
+
+typedef enum {
+    // Display core
+    TASK_DISPLAY,
+    TASK_LED_TRANSMIT,
+    TASK_LED_SCRUB,
+    TASK_BUTTON,
+    TASK_ENCODER,
+    TASK_EVENT_DISPATCHER,
+    TASK_EVENT_LISTENER,
+    // Network core
+    TASK_SLEEP_WAKE,
+    TASK_CHECK_SERVER,
+    TASK_HEARTBEAT,
+    TASK_WIFI_RECONNECT,
+    TASK_OTA_DOWNLOAD,
+    TASK_ETCH_FLUSH,
+    TASK_BLE_SCAN,
+    NUM_TASKS
+} task_id_t;
+
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];
+    int8_t core;                // -1 = no affinity
+    uint8_t priority;
+    uint8_t cpu_percent;        // Of one core since the previous Tasks__Get_stats
+    uint32_t stack_free;        // Stack high water mark (bytes left at worst)
+    uint32_t stack_size;        // Task_table stack in bytes, 0 for tasks not created from it (IDF)
+} task_stats_t;
+
+int Tasks__Create(task_id_t task, TaskFunction_t function, void *param, TaskHandle_t *handle);
+int Tasks__Get_stats(task_stats_t *stats, uint8_t max_stats);
+void Tasks__Log_stats(void);
+
+#endif
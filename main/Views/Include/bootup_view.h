@@ -15,6 +15,13 @@ void Bootup_View__Initialize(void);
  */
 void Bootup_View__Get_frame(view_frame_t *frame);
 
+/**
+ * @brief Get the bootup view as a grayscale frame with random pixel levels
+ * 
+ * @param frame Pointer to view_gray_frame_t to fill with bit-planes
+ */
+void Bootup_View__Get_gray_frame(view_gray_frame_t *frame);
+
 /**
  * @brief Handle button press in bootup view (no-op)
  */
@@ -7,6 +7,7 @@
 //PUBLIC FUNCTION
 void Etchsketch__Initialize(void);
 void Etchsketch__On_Enter(void);
+void Etchsketch__On_Exit(void);
 void Etchsketch__Get_view(view_frame_t*);
 
 void Etchsketch__UI_Encoder_Top(uint8_t);
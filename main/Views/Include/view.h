@@ -8,21 +8,110 @@
 
 #define DEFAULT_REFRESH_RATE_MS    60000   // Update view every 60sec=60000
 
+// Display task scheduling: at most one frame per VIEW_MIN_FRAME_INTERVAL_MS, update requests
+// arriving before the next frame is allowed are merged into it. A refresh deadline that is
+// served more than VIEW_DEADLINE_SLACK_MS late counts as a miss.
+#define VIEW_MIN_FRAME_INTERVAL_MS  30      // ~33 fps, a whole number of 10 ms ticks
+#define VIEW_DEADLINE_SLACK_MS      20
+
+// Menu <-> view transitions: frames from old to new view, one per VIEW_MIN_FRAME_INTERVAL_MS
+#define VIEW_TRANSITION_FRAMES      12
+
+// Render profiler: CPU cycles of every module render, per view. 0 compiles it out of
+// build_new_view; View__Get_render_times then reports nothing.
+#ifndef VIEW_PROFILE
+#define VIEW_PROFILE                1
+#endif
+// Samples kept per view (ring) for View__Get_render_times percentiles
+#define VIEW_RENDER_SAMPLES         64
+
+// Buffer size for View__Frame_to_json (tools/view_creator format, hex strings)
+#define VIEW_FRAME_JSON_LEN         560
+
+// Flight recorder: the last VIEW_RECORDER_FRAMES frames sent to the LEDs. The oldest is kept
+// in full, each later one as the 16-bit rows that changed from the frame before it.
+#define VIEW_RECORDER_FRAMES        64
+#define VIEW_RECORDER_BYTES         2048    // Delta entries (6 bytes + 3 per changed row)
+#define VIEW_RECORDER_DUMP_LEN      (2 + 5 + (2 * VIEW_FRAME_ROWS) + VIEW_RECORDER_BYTES)
+
+// Grayscale mode: bits per channel (2-4). Levels 0..VIEW_GRAY_MAX_LEVEL
+#define VIEW_GRAY_BITS          3
+#define VIEW_GRAY_MAX_LEVEL     ((1 << VIEW_GRAY_BITS) - 1)
+#if VIEW_GRAY_BITS < 2 || VIEW_GRAY_BITS > 4
+#error "VIEW_GRAY_BITS must be 2-4"
+#endif
+
 extern SemaphoreHandle_t displayUpdateSemaphore;
 
 //PUBLIC TYPES
 
+// words overlays the three channels so whole frames can be combined 64 bits at a time,
+// rows walks all of them in order (red 0-15, green, blue)
+#define VIEW_FRAME_WORDS        12
+#define VIEW_FRAME_ROWS         48
 typedef struct {
-    uint16_t red[16];
-    uint16_t green[16];
-    uint16_t blue[16];
+    union {
+        struct {
+            uint16_t red[16];
+            uint16_t green[16];
+            uint16_t blue[16];
+        };
+        uint64_t words[VIEW_FRAME_WORDS];
+        uint16_t rows[VIEW_FRAME_ROWS];
+    };
 } view_frame_t;
 
+// Multi-level frame as weighted bit-planes: planes[k] holds bit k of every level (weight 2^k).
+// The LED driver shows each plane for a time proportional to its weight.
+typedef struct {
+    view_frame_t planes[VIEW_GRAY_BITS];
+} view_gray_frame_t;
+
 typedef enum {
     STATIC,
     DYNAMIC
 } Display_type;
 
+// Compositor layers, blended over the view's render in this order (notification on top).
+// Layers are kept between frames; setting one only recomposes, the view is not re-rendered.
+typedef enum {
+    VIEW_LAYER_BASE,        // Current view's render, managed by the display task
+    VIEW_LAYER_OVERLAY,
+    VIEW_LAYER_CURSOR,
+    VIEW_LAYER_NOTIFICATION,
+    VIEW_NUM_LAYERS
+} view_layer_t;
+
+// Applied to pixels under the layer's mask only. On a grayscale view every plane gets the same op.
+typedef enum {
+    VIEW_BLEND_OR,          // Light the layer's pixels
+    VIEW_BLEND_REPLACE,     // Layer's pixels (lit or dark) replace those below
+    VIEW_BLEND_XOR          // Invert below where the layer is lit
+} view_blend_t;
+
+typedef enum {
+    VIEW_TRANSITION_NONE,       // Snap to the new view
+    VIEW_TRANSITION_SLIDE,      // New view pushes the old one out sideways
+    VIEW_TRANSITION_WIPE,       // New view replaces the old one row by row
+    VIEW_TRANSITION_DISSOLVE    // Pixels switch over in a fixed scattered order
+} view_transition_t;
+
+// Display task scheduling counters
+typedef struct {
+    uint32_t num_requests;          // View__Request_update calls
+    uint32_t num_merged_requests;   // Requests served by a frame another request already triggered
+    uint32_t num_renders;
+    uint32_t num_deadline_renders;  // Renders for the view's refresh period with no request pending
+    uint32_t num_deadline_misses;   // Renders started more than VIEW_DEADLINE_SLACK_MS past the deadline
+    uint32_t num_transmitted;       // Frames the LED driver put on the wire (a replaced frame never is)
+    uint32_t num_frames_sent;       // Renders handed to the LED driver
+    uint32_t num_frames_skipped;    // Renders with the same hash as the last frame sent, not translated
+    uint32_t num_forced;            // View__Force_refresh calls
+    uint32_t num_transitions;       // Transitions started
+    uint32_t num_transitions_cancelled; // Cut short by input
+    uint16_t transition_fps_x10;    // Frame rate achieved by the last completed transition, x10
+} view_sched_stats_t;
+
 
 typedef enum {
   VIEW_MENU=0,
@@ -47,10 +136,44 @@ typedef enum {
   ENC2_CCW,
 } UI_Event_Type;
 
+// Render cost of one view in CPU cycles. Percentiles cover its last VIEW_RENDER_SAMPLES
+// renders, the rest everything since boot.
+typedef struct {
+    uint32_t num_samples;
+    uint32_t min_cycles;
+    uint32_t avg_cycles;
+    uint32_t max_cycles;
+    uint32_t p50_cycles;
+    uint32_t p90_cycles;
+    uint32_t p99_cycles;
+} view_render_times_t;
+
 //PUBLIC FUNCTION
 void View__Initialize();
 void View__Process_UI(uint16_t);
 void View__Set_display_state(uint8_t state);
 void View__Change_brightness(uint8_t);
 void View__Set_view(View_type view);
+void View__Request_update(void);
+void View__Get_sched_stats(view_sched_stats_t *stats);
+void View__Force_refresh(void);
+void View__Set_transition(view_transition_t transition);
+void View__Layer_set(view_layer_t layer, const view_frame_t *pixels, const view_frame_t *mask, view_blend_t blend);
+void View__Layer_clear(view_layer_t layer);
+void View__Request_compose(void);
+
+// Views draw random content from View__Random so a seeded run renders the same frames.
+// Seed 0 = hardware random seed (default).
+void View__Seed_random(uint32_t seed);
+uint32_t View__Random(void);
+void View__Get_frame(view_frame_t *frame);
+int View__Frame_to_json(const view_frame_t *frame, char *buffer, uint16_t buffer_size);
+void View__Get_render_times(View_type view, view_render_times_t *times);
+void View__Log_render_times(void);
+int View__Recorder_dump(uint8_t *buffer, uint16_t buffer_size);
+
+// Grayscale pixel access, levels 0..VIEW_GRAY_MAX_LEVEL
+void View__Gray_set_pixel(view_gray_frame_t *frame, uint8_t row, uint8_t col, uint8_t red, uint8_t green, uint8_t blue);
+void View__Gray_get_pixel(const view_gray_frame_t *frame, uint8_t row, uint8_t col, uint8_t *red, uint8_t *green, uint8_t *blue);
+void View__Gray_from_frame(view_gray_frame_t *gray, const view_frame_t *frame);
 #endif
\ No newline at end of file
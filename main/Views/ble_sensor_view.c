@@ -11,6 +11,7 @@
 #include "ble_sensor_view.h"
 #include "view.h"
 #include "mqtt.h"
+#include "tasks.h"
 
 #if CONFIG_BT_ENABLED
 #include "esp_bt.h"
@@ -97,7 +98,7 @@ static void handle_valid_packet(uint16_t sensor_id, int16_t temperature) {
     taskEXIT_CRITICAL(&s_ble_lock);
 
     publish_temperature(sensor_id, temperature);
-    xSemaphoreGive(displayUpdateSemaphore);
+    View__Request_update();
 }
 
 static bool parse_and_handle_mfr_packet(const uint8_t *adv_data, uint8_t adv_len) {
@@ -274,7 +275,7 @@ static void ble_scan_task(void *arg) {
                 taskEXIT_CRITICAL(&s_ble_lock);
 
                 start_continuous_scan();
-                xSemaphoreGive(displayUpdateSemaphore);
+                View__Request_update();
                 continue;
             }
 
@@ -310,7 +311,7 @@ static void ble_scan_task(void *arg) {
                 }
                 taskEXIT_CRITICAL(&s_ble_lock);
 
-                xSemaphoreGive(displayUpdateSemaphore);
+                View__Request_update();
             }
 
             vTaskDelay(pdMS_TO_TICKS(250));
@@ -329,14 +330,7 @@ static void set_pixel(uint16_t *plane, uint8_t row, uint8_t col) {
 void Ble_Sensor_View__Initialize(void) {
 #if CONFIG_BT_ENABLED
     if (s_ble_task_handle == NULL) {
-        xTaskCreate(
-            ble_scan_task,
-            "BleScanTask",
-            (4 * configMINIMAL_STACK_SIZE),
-            NULL,
-            5,
-            &s_ble_task_handle
-        );
+        Tasks__Create(TASK_BLE_SCAN, ble_scan_task, NULL, &s_ble_task_handle);
     }
 #else
     ESP_LOGW(TAG, "CONFIG_BT_ENABLED is off; BLE scanner view will show disabled state");
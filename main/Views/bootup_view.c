@@ -1,7 +1,6 @@
 #include <string.h>
 #include "esp_system.h"
 #include "esp_log.h"
-#include "esp_random.h"
 
 #include "bootup_view.h"
 #include "view.h"
@@ -22,9 +21,18 @@ void Bootup_View__Get_frame(view_frame_t *frame) {
     
     // Generate random colorful pixels for LED display
     for (uint8_t i = 0; i < 16; i++) {
-        frame->red[i] = esp_random() & 0xFFFF;
-        frame->green[i] = esp_random() & 0xFFFF;
-        frame->blue[i] = esp_random() & 0xFFFF;
+        frame->red[i] = View__Random() & 0xFFFF;
+        frame->green[i] = View__Random() & 0xFFFF;
+        frame->blue[i] = View__Random() & 0xFFFF;
+    }
+}
+
+// Random levels: each plane is independent random bits, so every level is equally likely
+void Bootup_View__Get_gray_frame(view_gray_frame_t *frame) {
+    if (!frame) return;
+
+    for (uint8_t k = 0; k < VIEW_GRAY_BITS; k++) {
+        Bootup_View__Get_frame(&frame->planes[k]);
     }
 }
 
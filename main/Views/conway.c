@@ -1,7 +1,6 @@
 #include <string.h>
 #include "esp_system.h"
 #include "esp_log.h"
-#include "esp_random.h"
 
 #include "conway.h"
 #include "view.h"
@@ -109,7 +108,7 @@ void restart_grid(void) {
     // Initialize the grid with random values
     for(uint8_t row=0; row<CONWAY_GRID_SIZE; row++) {
         for(uint8_t col=0; col<CONWAY_GRID_SIZE; col++) {
-            if(esp_random() % 2) {
+            if(View__Random() % 2) {
                 Conway_grid[row][col] = 2;  // alive
             } else {
                 Conway_grid[row][col] = 0;  // dead
@@ -10,6 +10,8 @@
 #include "ui.h"
 #include "mqtt.h"
 #include "mqtt_protocol.h"
+#include "led_driver.h"
+#include "tasks.h"
 
 static const char *TAG = "WEATHER_STATION: ETCHSKETCH";
 
@@ -23,6 +25,9 @@ typedef enum {
 // Private static variables
 static uint8_t Position_row;
 static uint8_t Position_col;
+static uint8_t Cursor_row;             // Position the cursor layer and blink region were set for
+static uint8_t Cursor_col;
+static uint8_t Cursor_set;             // 0 until set after entering the view
 
 // Paint mode tracking
 static uint8_t Paint_mode_active;      // 0=off, 1=paint with button, 2=paint with button2, 3=paint with button3
@@ -31,6 +36,7 @@ static pixel_color_t Paint_color;      // color for painting
 static mqtt_etch_sketch_frame_t shared_view;
 
 #define FLUSH_TIMER_PERIOD_MS 2000  // 2 seconds of inactivity triggers flush
+#define CURSOR_BLINK_PERIOD_MS 600  // Cursor blink on/off cycle, done by the LED driver
 static uint16_t Last_seq_seen;
 static uint16_t Next_seq_to_send;
 
@@ -74,6 +80,7 @@ void Etchsketch__Initialize(void) {
 
     Position_col = 0;
     Position_row = 0;
+    Cursor_set = 0;
     Paint_mode_active = 0;
     Paint_color = 0;
 
@@ -93,17 +100,7 @@ void Etchsketch__Initialize(void) {
 
     // Create worker task to perform flush outside timer context
     if (flush_worker_task_handle == NULL) {
-        BaseType_t created = xTaskCreate(
-            flush_worker_task,
-            "FlushWorker",
-            3072,          // stack words; generous to avoid overflow
-            NULL,
-            6,             // medium priority
-            &flush_worker_task_handle
-        );
-        if (created != pdPASS) {
-            ESP_LOGE(TAG, "Failed to create flush worker task");
-        }
+        Tasks__Create(TASK_ETCH_FLUSH, flush_worker_task, NULL, &flush_worker_task_handle);
     }
 }
 
@@ -125,7 +122,23 @@ void Etchsketch__Get_view(view_frame_t *frame) {
     memcpy(frame->red, shared_view.red, sizeof(shared_view.red));
     memcpy(frame->green, shared_view.green, sizeof(shared_view.green));
     memcpy(frame->blue, shared_view.blue, sizeof(shared_view.blue));
-    frame->red[Position_row] |= (1 << Position_col);
+
+    // Cursor on its own layer, blinked by the driver: only touched when it moves
+    if (!Cursor_set || Cursor_row != Position_row || Cursor_col != Position_col) {
+        view_frame_t cursor = {0};
+        cursor.red[Position_row] = (1 << Position_col);
+        View__Layer_set(VIEW_LAYER_CURSOR, &cursor, NULL, VIEW_BLEND_OR);
+        Led_driver__Set_blink_region(&cursor, CURSOR_BLINK_PERIOD_MS);
+        Cursor_row = Position_row;
+        Cursor_col = Position_col;
+        Cursor_set = 1;
+    }
+}
+
+void Etchsketch__On_Exit(void) {
+    View__Layer_clear(VIEW_LAYER_CURSOR);
+    Led_driver__Set_blink_region(NULL, 0);
+    Cursor_set = 0;
 }
 
 // Methods performed on UI events (encoder/button presses)
@@ -7,8 +7,12 @@
 #include <stdbool.h>
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_cpu.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 
 #include "view.h"
 #include "main.h"
@@ -24,9 +28,15 @@
 #include "Include/ble_sensor_view.h"
 #include "provisioning_view.h"
 #include "bootup_view.h"
+#include "latency.h"
+#include "tasks.h"
 
 static const char *TAG = "WEATHER_STATION: VIEW";
 
+// Brightness ramps, stepped by the LED driver (dispatcher does not wait for them)
+#define FADE_SLEEP_WAKE_MS      1500    // Whole range at sleep / wake
+#define FADE_ENCODER_MS         60      // Per encoder detent
+
 typedef enum {
     LEVEL_MIN,
     LEVEL_2,
@@ -46,16 +56,86 @@ typedef enum {
     LEVEL_MAX
 } Brightness_level;
 
+#define LAYER_BIT(layer)    (1 << (layer))
+
+// Menu <-> view transition, stepped by the display task
+typedef struct {
+    view_transition_t type;
+    uint8_t reverse;            // Back to the menu: slide / wipe run the other way
+    uint8_t frame;              // Frames shown so far, done at VIEW_TRANSITION_FRAMES
+    int64_t start_us;
+    view_gray_frame_t from;     // Last frame of the old view
+    uint8_t from_is_gray;
+} transition_state_t;
+
+// Compositor layer above the base; pixels and mask are only read under the mask
+typedef struct {
+    view_frame_t pixels;
+    view_frame_t mask;
+    view_blend_t blend;
+    uint8_t active;
+} view_layer_state_t;
+
 // Public variable
 SemaphoreHandle_t displayUpdateSemaphore = NULL;
 
 // Private static variables
 static view_frame_t View_frame;
+static view_gray_frame_t View_gray_frame;
+static uint8_t View_frame_is_gray;      // Last build used the module's render_gray
+static view_frame_t View_composed;      // Base with the layers blended on top, what gets sent
+static view_gray_frame_t View_composed_gray;
+static view_layer_state_t Layers[VIEW_NUM_LAYERS];  // [VIEW_LAYER_BASE] unused, base is View_frame
+static uint8_t Layers_dirty = LAYER_BIT(VIEW_LAYER_BASE);  // LAYER_BIT per layer changed since the last compose
+static int64_t Base_render_us;          // When the view itself was last rendered
+static portMUX_TYPE Layer_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static view_transition_t Transition_type = VIEW_TRANSITION_SLIDE;  // Used for menu switches
+static transition_state_t Transition;   // Display task only
+static view_gray_frame_t View_transition_frame;     // Old and new view mixed, sent instead of View_composed
+static uint8_t Transition_is_gray;
+static volatile uint8_t Transition_active;
+static volatile uint8_t Transition_request;     // 1 + reverse, set by the dispatcher, 0 = none
+static volatile uint8_t Transition_cancel;
+
+static uint32_t Random_state;           // xorshift32, never 0 once seeded
+
+#if VIEW_PROFILE
+// Render profile per view: cycle ring for percentiles, running min / total / max
+typedef struct {
+    uint32_t samples[VIEW_RENDER_SAMPLES];
+    uint32_t num_samples;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+} render_profile_t;
+
+static render_profile_t Render_profiles[NUM_MAIN_VIEWS];
+static portMUX_TYPE Render_lock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+// Flight recorder (see View__Recorder_dump for the entry layout)
+static uint8_t Recorder_ring[VIEW_RECORDER_BYTES];     // Delta entries, oldest at Recorder_head
+static uint16_t Recorder_head;
+static uint16_t Recorder_used;
+static uint16_t Recorder_num_frames;    // Including the base, 0 = empty
+static view_frame_t Recorder_base;      // Oldest recorded frame in full
+static uint32_t Recorder_base_ms;
+static uint8_t Recorder_base_view;
+static view_frame_t Recorder_last;      // Newest recorded frame, next delta is against it (display task only)
+static SemaphoreHandle_t Recorder_mutex = NULL;     // Ring and base: display task records, MQTT dumps
+static uint64_t View_sent_hash;         // Hash of the last frame handed to the LED driver
+static volatile uint8_t View_sent_hash_valid;
 
 static View_type View_current_view;
 static volatile uint32_t View_refresh_rate_ms;
 static uint8_t Display_State;  // 0=off, 1=on
 static Brightness_level Brightness;
+static volatile int64_t View_frame_render_us;     // When the display task started the newest frame
+static volatile int64_t View_frame_latency_us;    // Render start -> frame on the wire, from driver callback
+static view_sched_stats_t Sched_stats;
+static uint32_t Pending_requests;      // Requests since the last render started
+static portMUX_TYPE Sched_lock = portMUX_INITIALIZER_UNLOCKED;
 
 // Thread variables
 TaskHandle_t blockingTaskHandle_display = NULL;
@@ -63,25 +143,50 @@ void blocking_thread_update_display(void *);
 
 // Private method prototypes
 void build_new_view(void); 
+void render_view(void);
+void push_view_to_display(void);
 void decrease_brightness(void);
 void increase_brightness(void);
 void post_event(event_type_t, uint32_t);
+void on_frame_done(int64_t, uint32_t);
+TickType_t ticks_until(int64_t);
+uint64_t hash_frame(const view_frame_t*, uint8_t, uint64_t);
+void mark_layers_dirty(uint8_t);
+void compose_layers(void);
+void blend_plane(view_frame_t*, const view_layer_state_t*);
+void start_transition(void);
+void step_transition(void);
+void mix_transition_plane(view_frame_t*, const view_frame_t*, const view_frame_t*, uint8_t);
+uint8_t dissolve_order(uint8_t);
+#if VIEW_PROFILE
+void record_render_cycles(View_type, uint32_t);
+uint32_t percentile(const uint32_t*, uint32_t, uint8_t);
+#endif
+void record_frame(const view_frame_t*, View_type);
+void recorder_evict_oldest(void);
+uint8_t recorder_byte(uint16_t);
+void recorder_take(void);
+void recorder_give(void);
 
 typedef void (*view_render_fn)(view_frame_t *frame);
+typedef void (*view_render_gray_fn)(view_gray_frame_t *frame);
 typedef void (*view_init_fn)(void);
 typedef void (*view_button_fn)(uint8_t btn);
 typedef void (*view_encoder_fn)(uint8_t direction);
 typedef void (*view_enter_fn)(void);
+typedef void (*view_exit_fn)(void);
 typedef uint32_t (*view_refresh_fn)(void);
 
 typedef struct {
     view_init_fn initialize;
     view_render_fn render;
+    view_render_gray_fn render_gray;    // Optional multi-level render, used instead of render
     view_button_fn on_button;
     view_button_fn on_button_released;
     view_encoder_fn on_encoder_top;
     view_encoder_fn on_encoder_side;
     view_enter_fn on_enter;
+    view_exit_fn on_exit;           // Undo driver effects (eg. blink) before another view takes over
     uint32_t fixed_refresh_ms;
     view_refresh_fn get_refresh_ms;
     uint8_t button_map_down[4];
@@ -136,6 +241,7 @@ static const view_module_t View_modules[NUM_MAIN_VIEWS] = {
         .on_encoder_top = Etchsketch__UI_Encoder_Top,
         .on_encoder_side = Etchsketch__UI_Encoder_Side,
         .on_enter = Etchsketch__On_Enter,
+        .on_exit = Etchsketch__On_Exit,
         .fixed_refresh_ms = DEFAULT_REFRESH_RATE_MS,
         .button_map_down = {0, 1, 2, 3},
         .button_map_up = {0, 1, 2, 3},
@@ -177,6 +283,7 @@ static const view_module_t View_modules[NUM_MAIN_VIEWS] = {
     [VIEW_BOOTUP] = {
         .initialize = Bootup_View__Initialize,
         .render = Bootup_View__Get_frame,
+        .render_gray = Bootup_View__Get_gray_frame,
         .fixed_refresh_ms = 500,
         .button_map_down = {0, 0, 0, 0},
         .button_map_up = {0, 0, 0, 0},
@@ -191,6 +298,9 @@ void View__Initialize() {
     Display_State = 1;
     Brightness = LEVEL_MIN;
     View_refresh_rate_ms = DEFAULT_REFRESH_RATE_MS;
+    if (Random_state == 0) {
+        View__Seed_random(0);
+    }
 
     for (uint8_t i = 0; i < NUM_MAIN_VIEWS; i++) {
         if (View_modules[i].initialize) {
@@ -199,17 +309,12 @@ void View__Initialize() {
     }
 
     displayUpdateSemaphore = xSemaphoreCreateBinary();
+    Recorder_mutex = xSemaphoreCreateMutex();
+    Led_driver__Set_frame_done_callback(on_frame_done);
 
-    xTaskCreate(
-        blocking_thread_update_display,       // Task function
-        "BlockingTask_UpdateDisplay",       // Task name (for debugging)
-        (2*configMINIMAL_STACK_SIZE),   // Stack size (words)
-        NULL,                           // Task parameter
-        8,                             // Task priority
-        &blockingTaskHandle_display       // Task handle
-    );
+    Tasks__Create(TASK_DISPLAY, blocking_thread_update_display, NULL, &blockingTaskHandle_display);
 
-    xSemaphoreGive(displayUpdateSemaphore);
+    View__Request_update();
 }
 
 // Event system calls this to set UI event bits
@@ -226,6 +331,12 @@ void View__Process_UI(uint16_t UI_event) {
         return;
     }
 
+    // Any input ends a running transition on the new view. Not a release: letting go of the
+    // button that started it would cut every transition short.
+    if ((Transition_active || Transition_request) && !is_button_up) {
+        Transition_cancel = 1;
+    }
+
     // First button toggles menu for views that opt-in (button DOWN only).
     if((UI_event & 0x01) && !is_button_up && module->use_menu_toggle_on_btn1) {
         switch_between_menu_and_selected_view();
@@ -238,7 +349,7 @@ void View__Process_UI(uint16_t UI_event) {
         process_module_encoders(module, UI_event);
     }
 
-    xSemaphoreGive(displayUpdateSemaphore);
+    View__Request_update();
 }
 
 // Post view-related events to the event system
@@ -259,35 +370,374 @@ void View__Set_display_state(uint8_t request_state) {
     // Request turn off. If already off, do nothing.
     if(request_state == 0 && Display_State == 1) {
         Display_State = 0;
-        Led_driver__Toggle_LED(0);
+        Led_driver__Fade_LED(0, FADE_SLEEP_WAKE_MS);
     // Request turn on. If already on, do nothing.
     } else if(request_state == 1 && Display_State == 0) {
         Display_State = 1;
-        Led_driver__Toggle_LED(1);
+        // Chips sat dark for a while: resend the whole frame rather than trust their RAM
+        View__Force_refresh();
+        Led_driver__Fade_LED(1, FADE_SLEEP_WAKE_MS);
+    }
+}
+
+// Ask the display task for a new frame. Requests close together share one render.
+void View__Request_update(void) {
+    mark_layers_dirty(LAYER_BIT(VIEW_LAYER_BASE));
+    View__Request_compose();
+}
+
+// New frame from the layers as they are now, without re-rendering the view
+void View__Request_compose(void) {
+    if (!displayUpdateSemaphore) {
+        return;
     }
+    portENTER_CRITICAL(&Sched_lock);
+    Pending_requests++;
+    Sched_stats.num_requests++;
+    portEXIT_CRITICAL(&Sched_lock);
+    xSemaphoreGive(displayUpdateSemaphore);
+}
+
+void View__Get_sched_stats(view_sched_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+    led_driver_stats_t led_stats;
+    Led_driver__Get_stats(&led_stats);
+
+    portENTER_CRITICAL(&Sched_lock);
+    *stats = Sched_stats;
+    portEXIT_CRITICAL(&Sched_lock);
+    stats->num_transmitted = led_stats.num_frames;
+}
+
+// Recovery path: send the next frame even if unchanged, rewriting all of the chips' RAM
+void View__Force_refresh(void) {
+    View_sent_hash_valid = 0;
+    Led_driver__Invalidate_RAM();
+
+    portENTER_CRITICAL(&Sched_lock);
+    Sched_stats.num_forced++;
+    portEXIT_CRITICAL(&Sched_lock);
+    View__Request_update();
+}
+
+// pixels are blended where mask is set (NULL mask = whole frame). Shows from the next
+// frame: call View__Request_compose() unless an update is coming anyway.
+void View__Layer_set(view_layer_t layer, const view_frame_t *pixels, const view_frame_t *mask, view_blend_t blend) {
+    if (layer == VIEW_LAYER_BASE || layer >= VIEW_NUM_LAYERS || !pixels) {
+        return;
+    }
+    view_layer_state_t *state = &Layers[layer];
+
+    portENTER_CRITICAL(&Layer_lock);
+    state->pixels = *pixels;
+    if (mask) {
+        state->mask = *mask;
+    } else {
+        memset(&state->mask, 0xFF, sizeof(state->mask));
+    }
+    state->blend = blend;
+    state->active = 1;
+    Layers_dirty |= LAYER_BIT(layer);
+    portEXIT_CRITICAL(&Layer_lock);
+}
+
+void View__Layer_clear(view_layer_t layer) {
+    if (layer == VIEW_LAYER_BASE || layer >= VIEW_NUM_LAYERS) {
+        return;
+    }
+    portENTER_CRITICAL(&Layer_lock);
+    if (Layers[layer].active) {
+        Layers[layer].active = 0;
+        Layers_dirty |= LAYER_BIT(layer);
+    }
+    portEXIT_CRITICAL(&Layer_lock);
+}
+
+void View__Seed_random(uint32_t seed) {
+    while (seed == 0) {
+        seed = esp_random();
+    }
+    Random_state = seed;
+}
+
+uint32_t View__Random(void) {
+    if (Random_state == 0) {
+        View__Seed_random(0);
+    }
+    uint32_t x = Random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    Random_state = x;
+    return x;
+}
+
+// What the display shows (mid-transition: the mix), grayscale flattened to lit / dark.
+// Read without locking the display task: a diagnostic copy may mix two frames.
+void View__Get_frame(view_frame_t *frame) {
+    if (!frame) {
+        return;
+    }
+    const view_frame_t *planes = &View_composed;
+    uint8_t num_planes = 1;
+    if (Transition_active) {
+        planes = View_transition_frame.planes;
+        num_planes = Transition_is_gray ? VIEW_GRAY_BITS : 1;
+    } else if (View_frame_is_gray) {
+        planes = View_composed_gray.planes;
+        num_planes = VIEW_GRAY_BITS;
+    }
+
+    *frame = planes[0];
+    for (uint8_t k = 1; k < num_planes; k++) {
+        for (uint8_t i = 0; i < VIEW_FRAME_WORDS; i++) {
+            frame->words[i] |= planes[k].words[i];
+        }
+    }
+}
+
+// Frame as tools/view_creator JSON (visualize_display.py input). Returns length, or -1 if
+// buffer is too small (VIEW_FRAME_JSON_LEN always fits).
+int View__Frame_to_json(const view_frame_t *frame, char *buffer, uint16_t buffer_size) {
+    if (!frame || !buffer) {
+        return -1;
+    }
+    const char *names[3] = {"\"red\":   ", "\"green\": ", "\"blue\":  "};
+    const uint16_t *channels[3] = {frame->red, frame->green, frame->blue};
+    int len = snprintf(buffer, buffer_size, "{\n");
+
+    for (uint8_t channel = 0; channel < 3 && len >= 0 && len < buffer_size; channel++) {
+        len += snprintf(&buffer[len], buffer_size - len, "  %s[", names[channel]);
+        for (uint8_t row = 0; row < 16 && len < buffer_size; row++) {
+            len += snprintf(&buffer[len], buffer_size - len, "%s\"0x%04X\"", row ? ", " : "", channels[channel][row]);
+        }
+        if (len < buffer_size) {
+            len += snprintf(&buffer[len], buffer_size - len, "]%s\n", (channel < 2) ? "," : "");
+        }
+    }
+    if (len >= 0 && len < buffer_size) {
+        len += snprintf(&buffer[len], buffer_size - len, "}\n");
+    }
+    return (len >= 0 && len < buffer_size) ? len : -1;
+}
+
+// Nearest-rank percentiles over the view's last VIEW_RENDER_SAMPLES renders
+void View__Get_render_times(View_type view, view_render_times_t *times) {
+    if (view >= NUM_MAIN_VIEWS || !times) {
+        return;
+    }
+    memset(times, 0, sizeof(*times));
+#if VIEW_PROFILE
+    render_profile_t profile;
+    uint32_t *samples = profile.samples;
+
+    portENTER_CRITICAL(&Render_lock);
+    profile = Render_profiles[view];
+    portEXIT_CRITICAL(&Render_lock);
+
+    times->num_samples = profile.num_samples;
+    if (profile.num_samples == 0) {
+        return;
+    }
+    times->min_cycles = profile.min_cycles;
+    times->max_cycles = profile.max_cycles;
+    times->avg_cycles = (uint32_t)(profile.total_cycles / profile.num_samples);
+
+    uint32_t num_kept = (times->num_samples < VIEW_RENDER_SAMPLES) ? times->num_samples : VIEW_RENDER_SAMPLES;
+    // Insertion sort, at most VIEW_RENDER_SAMPLES
+    for (uint32_t i = 1; i < num_kept; i++) {
+        uint32_t sample = samples[i];
+        uint32_t j = i;
+        while (j > 0 && samples[j - 1] > sample) {
+            samples[j] = samples[j - 1];
+            j--;
+        }
+        samples[j] = sample;
+    }
+    times->p50_cycles = percentile(samples, num_kept, 50);
+    times->p90_cycles = percentile(samples, num_kept, 90);
+    times->p99_cycles = percentile(samples, num_kept, 99);
+#endif
+}
+
+// Cycles shown as us at the configured CPU clock
+void View__Log_render_times(void) {
+    for (uint8_t view = 0; view < NUM_MAIN_VIEWS; view++) {
+        view_render_times_t times;
+        View__Get_render_times(view, &times);
+        if (times.num_samples == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "view %u: n=%lu min=%lu avg=%lu p50=%lu p90=%lu p99=%lu max=%lu us", view, (unsigned long)times.num_samples,
+                 (unsigned long)(times.min_cycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ), (unsigned long)(times.avg_cycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ),
+                 (unsigned long)(times.p50_cycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ), (unsigned long)(times.p90_cycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ),
+                 (unsigned long)(times.p99_cycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ), (unsigned long)(times.max_cycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ));
+    }
+}
+
+// Flight recorder contents, oldest first. All multi-byte fields big-endian:
+//   [num_frames: uint16]
+//   [time_ms: uint32][view: uint8][48 rows: uint16, red 0-15, green, blue]     oldest frame
+//   num_frames - 1 times:
+//   [time_ms: uint32][view: uint8][num_rows: uint8] num_rows x [row: uint8][xor: uint16]
+// Returns bytes written (VIEW_RECORDER_DUMP_LEN always fits), or -1.
+int View__Recorder_dump(uint8_t *buffer, uint16_t buffer_size) {
+    if (!buffer || buffer_size < VIEW_RECORDER_DUMP_LEN) {
+        return -1;
+    }
+    uint16_t idx = 0;
+
+    // A mutex, not a critical section: a full dump is ~2 KB of copying
+    recorder_take();
+    buffer[idx++] = (uint8_t)(Recorder_num_frames >> 8);
+    buffer[idx++] = (uint8_t)Recorder_num_frames;
+    if (Recorder_num_frames > 0) {
+        buffer[idx++] = (uint8_t)(Recorder_base_ms >> 24);
+        buffer[idx++] = (uint8_t)(Recorder_base_ms >> 16);
+        buffer[idx++] = (uint8_t)(Recorder_base_ms >> 8);
+        buffer[idx++] = (uint8_t)Recorder_base_ms;
+        buffer[idx++] = Recorder_base_view;
+        for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+            buffer[idx++] = (uint8_t)(Recorder_base.rows[row] >> 8);
+            buffer[idx++] = (uint8_t)Recorder_base.rows[row];
+        }
+        // Ring from the oldest entry, in at most two pieces
+        uint16_t first_len = VIEW_RECORDER_BYTES - Recorder_head;
+        if (first_len > Recorder_used) {
+            first_len = Recorder_used;
+        }
+        memcpy(&buffer[idx], &Recorder_ring[Recorder_head], first_len);
+        memcpy(&buffer[idx + first_len], Recorder_ring, Recorder_used - first_len);
+        idx += Recorder_used;
+    }
+    recorder_give();
+
+    return idx;
+}
+
+// Animation for the menu toggle, VIEW_TRANSITION_NONE to snap
+void View__Set_transition(view_transition_t transition) {
+    Transition_type = transition;
 }
 
 // Switch to a specific view and update display immediately
 void View__Set_view(View_type view) {
     if (view < NUM_MAIN_VIEWS) {
+        const view_module_t *module = get_current_module();
+        if (view != View_current_view && module && module->on_exit) {
+            module->on_exit();
+        }
         View_current_view = view;
-        xSemaphoreGive(displayUpdateSemaphore);  // Trigger immediate display update
+        View__Request_update();  // Trigger immediate display update
+    }
+}
+
+void View__Gray_set_pixel(view_gray_frame_t *frame, uint8_t row, uint8_t col, uint8_t red, uint8_t green, uint8_t blue) {
+    if (!frame || row >= 16 || col >= 16) {
+        return;
+    }
+    uint16_t mask = (1 << col);
+    for (uint8_t k = 0; k < VIEW_GRAY_BITS; k++) {
+        view_frame_t *plane = &frame->planes[k];
+        plane->red[row] = ((red >> k) & 1) ? (plane->red[row] | mask) : (plane->red[row] & ~mask);
+        plane->green[row] = ((green >> k) & 1) ? (plane->green[row] | mask) : (plane->green[row] & ~mask);
+        plane->blue[row] = ((blue >> k) & 1) ? (plane->blue[row] | mask) : (plane->blue[row] & ~mask);
+    }
+}
+
+void View__Gray_get_pixel(const view_gray_frame_t *frame, uint8_t row, uint8_t col, uint8_t *red, uint8_t *green, uint8_t *blue) {
+    uint8_t r = 0, g = 0, b = 0;
+    if (frame && row < 16 && col < 16) {
+        for (uint8_t k = 0; k < VIEW_GRAY_BITS; k++) {
+            const view_frame_t *plane = &frame->planes[k];
+            r |= ((plane->red[row] >> col) & 1) << k;
+            g |= ((plane->green[row] >> col) & 1) << k;
+            b |= ((plane->blue[row] >> col) & 1) << k;
+        }
+    }
+    if (red) *red = r;
+    if (green) *green = g;
+    if (blue) *blue = b;
+}
+
+// On/off frame at full level: every plane gets the same bits
+void View__Gray_from_frame(view_gray_frame_t *gray, const view_frame_t *frame) {
+    if (!gray || !frame) {
+        return;
+    }
+    for (uint8_t k = 0; k < VIEW_GRAY_BITS; k++) {
+        gray->planes[k] = *frame;
     }
 }
 
 // PRIVATE METHODS
 
+// Re-renders the view only when asked to (View__Request_update, refresh deadline), then
+// blends the layers over it if anything changed
 void build_new_view(void) {
+    Latency__Mark_build_start();
+
+    // Old view's last frame, before the new view renders over it
+    if (Transition_request) {
+        start_transition();
+    }
+
+    portENTER_CRITICAL(&Layer_lock);
+    uint8_t render_base = Layers_dirty & LAYER_BIT(VIEW_LAYER_BASE);
+    Layers_dirty &= ~LAYER_BIT(VIEW_LAYER_BASE);
+    portEXIT_CRITICAL(&Layer_lock);
+
+    if (render_base) {
+        render_view();
+    }
+
+    // Render may have set layers (eg. a cursor)
+    portENTER_CRITICAL(&Layer_lock);
+    uint8_t dirty = Layers_dirty | render_base;
+    Layers_dirty = 0;
+    portEXIT_CRITICAL(&Layer_lock);
+
+    if (dirty) {
+        compose_layers();
+    }
+
+    if (Transition_active) {
+        step_transition();
+    }
+}
+
+void render_view(void) {
+    Base_render_us = esp_timer_get_time();
+
     // Clear view
     memset(&View_frame, 0, sizeof(View_frame));
+    View_frame_is_gray = 0;
 
     const view_module_t *module = get_current_module();
     if (!module) {
         return;
     }
 
-    if (module->render) {
+    if (module->render_gray) {
+        memset(&View_gray_frame, 0, sizeof(View_gray_frame));
+#if VIEW_PROFILE
+        uint32_t start_cycles = esp_cpu_get_cycle_count();
+        module->render_gray(&View_gray_frame);
+        record_render_cycles(View_current_view, esp_cpu_get_cycle_count() - start_cycles);
+#else
+        module->render_gray(&View_gray_frame);
+#endif
+        View_frame_is_gray = 1;
+    } else if (module->render) {
+#if VIEW_PROFILE
+        uint32_t start_cycles = esp_cpu_get_cycle_count();
+        module->render(&View_frame);
+        record_render_cycles(View_current_view, esp_cpu_get_cycle_count() - start_cycles);
+#else
         module->render(&View_frame);
+#endif
     }
 
     if (module->get_refresh_ms) {
@@ -299,6 +749,346 @@ void build_new_view(void) {
     }
 }
 
+// Frames identical to the last one sent are dropped before translation. Orientation is part
+// of the hash since the same view frame maps to different chip RAM after a change.
+void push_view_to_display(void) {
+    uint64_t hash;
+    if (Transition_active) {
+        hash = hash_frame(View_transition_frame.planes, Transition_is_gray ? VIEW_GRAY_BITS : 1, Transition_is_gray);
+    } else if (View_frame_is_gray) {
+        hash = hash_frame(View_composed_gray.planes, VIEW_GRAY_BITS, 1);
+    } else {
+        hash = hash_frame(&View_composed, 1, 0);
+    }
+    hash ^= Led_driver__Get_orientation();
+
+    uint8_t unchanged = View_sent_hash_valid && (hash == View_sent_hash);
+    portENTER_CRITICAL(&Sched_lock);
+    if (unchanged) {
+        Sched_stats.num_frames_skipped++;
+    } else {
+        Sched_stats.num_frames_sent++;
+    }
+    portEXIT_CRITICAL(&Sched_lock);
+    if (unchanged) {
+        Latency__Mark_frame_unchanged();
+        return;
+    }
+    View_sent_hash = hash;
+    View_sent_hash_valid = 1;
+
+    view_frame_t shown;
+    View__Get_frame(&shown);
+    record_frame(&shown, View_current_view);
+
+    // Marked before the hand-over: the transmit task may report the frame done before
+    // Update_RAM returns. This task is the only one handing frames over, so it is the next seq.
+    Latency__Mark_frame_published(Led_driver__Get_frame_seq() + 1);
+    if (Transition_active && Transition_is_gray) {
+        Led_driver__Update_RAM_gray(&View_transition_frame);
+    } else if (Transition_active) {
+        Led_driver__Update_RAM(&View_transition_frame.planes[0]);
+    } else if (View_frame_is_gray) {
+        Led_driver__Update_RAM_gray(&View_composed_gray);
+    } else {
+        Led_driver__Update_RAM(&View_composed);
+    }
+}
+
+// 64-bit FNV-1a over 32-bit words of num_frames bitplanes. seed tells flat and gray apart.
+uint64_t hash_frame(const view_frame_t *frames, uint8_t num_frames, uint64_t seed) {
+    uint64_t hash = 0xCBF29CE484222325ULL ^ seed;
+    const uint32_t *words = (const uint32_t *)frames;
+    uint32_t num_words = (uint32_t)num_frames * (sizeof(view_frame_t) / sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < num_words; i++) {
+        hash ^= words[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+void mark_layers_dirty(uint8_t layer_bits) {
+    portENTER_CRITICAL(&Layer_lock);
+    Layers_dirty |= layer_bits;
+    portEXIT_CRITICAL(&Layer_lock);
+}
+
+// Composed = base, then each active layer from the bottom up
+void compose_layers(void) {
+    uint8_t num_planes = View_frame_is_gray ? VIEW_GRAY_BITS : 1;
+    view_frame_t *composed = View_frame_is_gray ? View_composed_gray.planes : &View_composed;
+    const view_frame_t *base = View_frame_is_gray ? View_gray_frame.planes : &View_frame;
+
+    memcpy(composed, base, num_planes * sizeof(view_frame_t));
+
+    portENTER_CRITICAL(&Layer_lock);
+    for (uint8_t layer = VIEW_LAYER_BASE + 1; layer < VIEW_NUM_LAYERS; layer++) {
+        if (!Layers[layer].active) {
+            continue;
+        }
+        for (uint8_t k = 0; k < num_planes; k++) {
+            blend_plane(&composed[k], &Layers[layer]);
+        }
+    }
+    portEXIT_CRITICAL(&Layer_lock);
+}
+
+// Capture what is on the display now (mid-transition: the mix) as the old view
+void start_transition(void) {
+    uint8_t request = Transition_request;
+    Transition_request = 0;
+
+    if (Transition_active) {
+        Transition.from = View_transition_frame;
+        Transition.from_is_gray = Transition_is_gray;
+    } else if (View_frame_is_gray) {
+        Transition.from = View_composed_gray;
+        Transition.from_is_gray = 1;
+    } else {
+        Transition.from.planes[0] = View_composed;
+        Transition.from_is_gray = 0;
+    }
+    Transition.type = Transition_type;
+    Transition.reverse = request - 1;
+    Transition.frame = 0;
+    Transition.start_us = esp_timer_get_time();
+    Transition_active = 1;
+
+    portENTER_CRITICAL(&Sched_lock);
+    Sched_stats.num_transitions++;
+    portEXIT_CRITICAL(&Sched_lock);
+}
+
+// Next transition frame from the old view and the new view's composed frame.
+// The last frame is the new view itself.
+void step_transition(void) {
+    if (Transition_cancel) {
+        Transition_cancel = 0;
+        Transition_active = 0;
+        portENTER_CRITICAL(&Sched_lock);
+        Sched_stats.num_transitions_cancelled++;
+        portEXIT_CRITICAL(&Sched_lock);
+        return;
+    }
+
+    Transition.frame++;
+    if (Transition.frame >= VIEW_TRANSITION_FRAMES) {
+        // First mixed frame to the new view: VIEW_TRANSITION_FRAMES - 1 frame intervals
+        int64_t elapsed_us = esp_timer_get_time() - Transition.start_us;
+        portENTER_CRITICAL(&Sched_lock);
+        Sched_stats.transition_fps_x10 = elapsed_us ? (uint16_t)(((VIEW_TRANSITION_FRAMES - 1) * 10000000LL) / elapsed_us) : 0;
+        uint16_t fps_x10 = Sched_stats.transition_fps_x10;
+        portEXIT_CRITICAL(&Sched_lock);
+        Transition_active = 0;
+        ESP_LOGI(TAG, "Transition done at %u.%u fps", fps_x10 / 10, fps_x10 % 10);
+        return;
+    }
+
+    Transition_is_gray = Transition.from_is_gray || View_frame_is_gray;
+    uint8_t num_planes = Transition_is_gray ? VIEW_GRAY_BITS : 1;
+    for (uint8_t k = 0; k < num_planes; k++) {
+        const view_frame_t *from = &Transition.from.planes[Transition.from_is_gray ? k : 0];
+        const view_frame_t *to = View_frame_is_gray ? &View_composed_gray.planes[k] : &View_composed;
+        mix_transition_plane(&View_transition_frame.planes[k], from, to, Transition.frame);
+    }
+}
+
+// One plane of transition frame (1 to VIEW_TRANSITION_FRAMES - 1), 64 bits (four rows) per step
+void mix_transition_plane(view_frame_t *out, const view_frame_t *from, const view_frame_t *to, uint8_t frame) {
+    const uint64_t lanes = 0x0001000100010001ULL;   // Multiplier copying a row mask into all four rows of a word
+    uint64_t row_masks[4];      // Rows taken from the new view, for the four rows of each word
+
+    if (Transition.type == VIEW_TRANSITION_SLIDE) {
+        // Both views shift sideways within each 16-bit row
+        uint8_t shift = (uint8_t)((frame * 16) / VIEW_TRANSITION_FRAMES);
+        if (shift == 0) {
+            *out = *from;
+            return;
+        }
+        uint64_t from_lanes = lanes * (uint16_t)(Transition.reverse ? (0xFFFF << shift) : (0xFFFF >> shift));
+        for (uint8_t i = 0; i < VIEW_FRAME_WORDS; i++) {
+            uint64_t old_part = Transition.reverse ? (from->words[i] << shift) : (from->words[i] >> shift);
+            uint64_t new_part = Transition.reverse ? (to->words[i] >> (16 - shift)) : (to->words[i] << (16 - shift));
+            out->words[i] = (old_part & from_lanes) | (new_part & ~from_lanes);
+        }
+        return;
+    }
+
+    memset(row_masks, 0, sizeof(row_masks));
+    if (Transition.type == VIEW_TRANSITION_WIPE) {
+        uint8_t rows = (uint8_t)((frame * 16) / VIEW_TRANSITION_FRAMES);
+        for (uint8_t row = 0; row < 16; row++) {
+            uint8_t from_new = Transition.reverse ? (row >= 16 - rows) : (row < rows);
+            if (from_new) {
+                row_masks[row / 4] |= 0xFFFFULL << ((row % 4) * 16);
+            }
+        }
+    } else {
+        uint16_t threshold = (uint16_t)((frame * 256) / VIEW_TRANSITION_FRAMES);
+        for (uint16_t pixel = 0; pixel < 256; pixel++) {
+            if (dissolve_order((uint8_t)pixel) < threshold) {
+                row_masks[pixel / 64] |= 1ULL << (pixel % 64);
+            }
+        }
+    }
+
+    // Words run red rows 0-15, green, blue: word i holds rows 4 * (i % 4) to 4 * (i % 4) + 3
+    for (uint8_t i = 0; i < VIEW_FRAME_WORDS; i++) {
+        uint64_t mask = row_masks[i % 4];
+        out->words[i] = (from->words[i] & ~mask) | (to->words[i] & mask);
+    }
+}
+
+#if VIEW_PROFILE
+void record_render_cycles(View_type view, uint32_t cycles) {
+    render_profile_t *profile = &Render_profiles[view];
+
+    portENTER_CRITICAL(&Render_lock);
+    profile->samples[profile->num_samples % VIEW_RENDER_SAMPLES] = cycles;
+    if (profile->num_samples == 0 || cycles < profile->min_cycles) {
+        profile->min_cycles = cycles;
+    }
+    if (cycles > profile->max_cycles) {
+        profile->max_cycles = cycles;
+    }
+    profile->total_cycles += cycles;
+    profile->num_samples++;
+    portEXIT_CRITICAL(&Render_lock);
+}
+
+// sorted holds num_samples ascending; 0 when empty
+uint32_t percentile(const uint32_t *sorted, uint32_t num_samples, uint8_t percent) {
+    if (num_samples == 0) {
+        return 0;
+    }
+    uint32_t rank = (num_samples * percent + 99) / 100;
+    return sorted[(rank > 0) ? (rank - 1) : 0];
+}
+#endif
+
+// Append frame as a delta against the last one, dropping the oldest frames to make room
+void record_frame(const view_frame_t *frame, View_type view) {
+    uint32_t time_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    uint8_t entry[6 + (3 * VIEW_FRAME_ROWS)];
+    uint8_t num_rows = 0;
+
+    recorder_take();
+    uint8_t first = (Recorder_num_frames == 0);
+    if (first) {
+        Recorder_base = *frame;
+        Recorder_base_ms = time_ms;
+        Recorder_base_view = view;
+        Recorder_num_frames = 1;
+    }
+    recorder_give();
+    if (first) {
+        Recorder_last = *frame;
+        return;
+    }
+
+    // Delta against the last frame outside the lock: only this task touches Recorder_last
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        uint16_t diff = frame->rows[row] ^ Recorder_last.rows[row];
+        if (diff) {
+            entry[6 + (3 * num_rows)] = row;
+            entry[7 + (3 * num_rows)] = (uint8_t)(diff >> 8);
+            entry[8 + (3 * num_rows)] = (uint8_t)diff;
+            num_rows++;
+        }
+    }
+    entry[0] = (uint8_t)(time_ms >> 24);
+    entry[1] = (uint8_t)(time_ms >> 16);
+    entry[2] = (uint8_t)(time_ms >> 8);
+    entry[3] = (uint8_t)time_ms;
+    entry[4] = view;
+    entry[5] = num_rows;
+    uint16_t entry_len = 6 + (3 * num_rows);
+    Recorder_last = *frame;
+
+    recorder_take();
+    while (Recorder_num_frames > 1 &&
+           (Recorder_num_frames >= VIEW_RECORDER_FRAMES || Recorder_used + entry_len > VIEW_RECORDER_BYTES)) {
+        recorder_evict_oldest();
+    }
+    for (uint16_t i = 0; i < entry_len; i++) {
+        Recorder_ring[(Recorder_head + Recorder_used + i) % VIEW_RECORDER_BYTES] = entry[i];
+    }
+    Recorder_used += entry_len;
+    Recorder_num_frames++;
+    recorder_give();
+}
+
+// Fold the oldest delta into the base frame. Recorder_mutex held.
+void recorder_evict_oldest(void) {
+    uint8_t num_rows = recorder_byte(5);
+
+    Recorder_base_ms = ((uint32_t)recorder_byte(0) << 24) | ((uint32_t)recorder_byte(1) << 16) |
+                       ((uint32_t)recorder_byte(2) << 8) | recorder_byte(3);
+    Recorder_base_view = recorder_byte(4);
+    for (uint8_t i = 0; i < num_rows; i++) {
+        uint8_t row = recorder_byte(6 + (3 * i));
+        Recorder_base.rows[row] ^= (uint16_t)((recorder_byte(7 + (3 * i)) << 8) | recorder_byte(8 + (3 * i)));
+    }
+
+    uint16_t entry_len = 6 + (3 * num_rows);
+    Recorder_head = (Recorder_head + entry_len) % VIEW_RECORDER_BYTES;
+    Recorder_used -= entry_len;
+    Recorder_num_frames--;
+}
+
+// Byte offset from the oldest delta entry
+uint8_t recorder_byte(uint16_t offset) {
+    return Recorder_ring[(Recorder_head + offset) % VIEW_RECORDER_BYTES];
+}
+
+// No mutex before View__Initialize: nothing else runs yet
+void recorder_take(void) {
+    if (Recorder_mutex) {
+        xSemaphoreTake(Recorder_mutex, portMAX_DELAY);
+    }
+}
+
+void recorder_give(void) {
+    if (Recorder_mutex) {
+        xSemaphoreGive(Recorder_mutex);
+    }
+}
+
+// Fixed scattered order 0-255 of the pixels (row * 16 + col): bit-reversed odd multiple, a permutation
+uint8_t dissolve_order(uint8_t pixel) {
+    uint8_t x = (uint8_t)(pixel * 167);
+    x = (uint8_t)((x >> 4) | (x << 4));
+    x = (uint8_t)(((x & 0xCC) >> 2) | ((x & 0x33) << 2));
+    x = (uint8_t)(((x & 0xAA) >> 1) | ((x & 0x55) << 1));
+    return x;
+}
+
+// One plane, all three channels, 64 bits (four rows) per step
+void blend_plane(view_frame_t *plane, const view_layer_state_t *layer) {
+    uint64_t *dst = plane->words;
+    const uint64_t *pixels = layer->pixels.words;
+    const uint64_t *mask = layer->mask.words;
+
+    switch (layer->blend) {
+        case VIEW_BLEND_OR:
+            for (uint8_t i = 0; i < VIEW_FRAME_WORDS; i++) {
+                dst[i] |= pixels[i] & mask[i];
+            }
+            break;
+        case VIEW_BLEND_REPLACE:
+            for (uint8_t i = 0; i < VIEW_FRAME_WORDS; i++) {
+                dst[i] = (dst[i] & ~mask[i]) | (pixels[i] & mask[i]);
+            }
+            break;
+        case VIEW_BLEND_XOR:
+            for (uint8_t i = 0; i < VIEW_FRAME_WORDS; i++) {
+                dst[i] ^= pixels[i] & mask[i];
+            }
+            break;
+    }
+}
+
 static const view_module_t *get_current_module(void) {
     if (View_current_view >= NUM_MAIN_VIEWS) {
         return NULL;
@@ -343,19 +1133,30 @@ static void process_module_encoders(const view_module_t *module, uint16_t UI_eve
 }
 
 static void switch_between_menu_and_selected_view(void) {
-    if (View_current_view == VIEW_MENU) {
-        View_current_view = Menu__Get_current_view();
-    } else {
+    const view_module_t *module = get_current_module();
+    if (module && module->on_exit) {
+        module->on_exit();
+    }
+
+    uint8_t to_menu = (View_current_view != VIEW_MENU);
+    if (to_menu) {
         View_current_view = VIEW_MENU;
+    } else {
+        View_current_view = Menu__Get_current_view();
     }
 
-    build_new_view();
-    Led_driver__Update_RAM(&View_frame);
+    // Display task renders the new view and animates over from the old one
+    if (Transition_type != VIEW_TRANSITION_NONE) {
+        Transition_request = 1 + to_menu;
+        Transition_cancel = 0;
+    }
 
-    const view_module_t *module = get_current_module();
+    module = get_current_module();
     if (module && module->on_enter) {
         module->on_enter();
     }
+
+    View__Request_update();
 }
 
 
@@ -364,10 +1165,10 @@ void decrease_brightness(void) {
     // ESP_LOGI(TAG, "Brightness: %d", Brightness);
     if(Brightness == LEVEL_MIN) {
         Display_State = 0;
-        Led_driver__Toggle_LED(0);
+        Led_driver__Fade_LED(0, FADE_ENCODER_MS);
     } else {
         Brightness--;
-        Led_driver__Set_brightness(Brightness);
+        Led_driver__Fade_brightness(Brightness, FADE_ENCODER_MS);
     }
 }
 
@@ -376,22 +1177,84 @@ void increase_brightness(void) {
     // ESP_LOGI(TAG, "Brightness: %d", Brightness);
     if(Display_State == 0) {
         Display_State = 1;
-        Led_driver__Toggle_LED(1);
+        Led_driver__Fade_LED(1, FADE_ENCODER_MS);
     } else if(Brightness < LEVEL_MAX) {
         Brightness++;
-        Led_driver__Set_brightness(Brightness);
+        Led_driver__Fade_brightness(Brightness, FADE_ENCODER_MS);
     }
 }
 
+// Renders when an update is requested or the current view's refresh period runs out,
+// never faster than VIEW_MIN_FRAME_INTERVAL_MS
 void blocking_thread_update_display(void *pvParameters) {
+    int64_t last_render_us = 0;
+    int64_t deadline_us = 0;        // Next refresh the current view needs
+
     while(1) {
-        // Wait for semaphore from event system or timeout for periodic refresh
-        TickType_t wait_ticks = (View_refresh_rate_ms == 0) ? DEFAULT_REFRESH_RATE_MS : pdMS_TO_TICKS(View_refresh_rate_ms);
+        // Wait for a request or the deadline
+        uint8_t requested = (xSemaphoreTake(displayUpdateSemaphore, ticks_until(deadline_us)) == pdTRUE);
+        if (!requested && esp_timer_get_time() < deadline_us) {
+            continue;
+        }
+
+        // Frame rate cap: requests given meanwhile merge into this frame
+        if (requested) {
+            int64_t earliest_us = last_render_us + (VIEW_MIN_FRAME_INTERVAL_MS * 1000);
+            if (esp_timer_get_time() < earliest_us) {
+                vTaskDelay(ticks_until(earliest_us));
+            }
+            xSemaphoreTake(displayUpdateSemaphore, 0);
+        }
+
+        int64_t start_us = esp_timer_get_time();
+        portENTER_CRITICAL(&Sched_lock);
+        if (Pending_requests > 1) {
+            Sched_stats.num_merged_requests += Pending_requests - 1;
+        }
+        Pending_requests = 0;
+        Sched_stats.num_renders++;
+        if (!requested && !Transition_active) {
+            Sched_stats.num_deadline_renders++;
+        }
+        if (deadline_us > 0 && start_us > deadline_us + (VIEW_DEADLINE_SLACK_MS * 1000)) {
+            Sched_stats.num_deadline_misses++;
+        }
+        portEXIT_CRITICAL(&Sched_lock);
+
+        // Deadline refresh re-renders the view, a request may only need the layers recomposed.
+        // A transition frame only needs the next mix.
+        if (!requested && !Transition_active) {
+            mark_layers_dirty(LAYER_BIT(VIEW_LAYER_BASE));
+        }
 
-        xSemaphoreTake(displayUpdateSemaphore, wait_ticks);
-        
-        // Update display (whether triggered by UI event or timeout)
+        // Driver only swaps the frame in; it goes out on the wire while the next one renders
+        View_frame_render_us = start_us;
         build_new_view();
-        Led_driver__Update_RAM(&View_frame);
+        push_view_to_display();
+
+        last_render_us = start_us;
+        if (Transition_active) {
+            deadline_us = start_us + (VIEW_MIN_FRAME_INTERVAL_MS * 1000);
+        } else {
+            uint32_t refresh_ms = (View_refresh_rate_ms == 0) ? DEFAULT_REFRESH_RATE_MS : View_refresh_rate_ms;
+            deadline_us = Base_render_us + ((int64_t)refresh_ms * 1000);
+        }
+    }
+}
+
+// Ticks to wait until time_us (esp_timer), rounded up so the wait never ends early
+TickType_t ticks_until(int64_t time_us) {
+    int64_t remaining_us = time_us - esp_timer_get_time();
+    if (remaining_us <= 0) {
+        return 0;
     }
-}
\ No newline at end of file
+    int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+    return (TickType_t)((remaining_us + tick_us - 1) / tick_us);
+}
+
+// Driver transmit task reports each frame leaving the wire
+void on_frame_done(int64_t done_us, uint32_t frame_seq) {
+    Latency__Mark_frame_done(done_us, frame_seq);
+    View_frame_latency_us = done_us - View_frame_render_us;
+    ESP_LOGD(TAG, "Frame on display %lld us after render start", View_frame_latency_us);
+}
@@ -1,3 +1,4 @@
+#include <string.h>
 #include "esp_system.h"
 #include "esp_log.h"
 
@@ -15,8 +16,29 @@ static Weather_data_type Weather_today;   // current_temp, min_temp, max_temp, p
 static Weather_data_type Weather_tomorrow;   // max_temp, precip_percent, moon phase
 static Weather_data_type Weather_next_day;   // max_temp, precip_percent, moon phase
 
+// Retained scene: each sprite keeps its rasterized bitplanes with the value they were drawn for.
+// A refresh only re-rasterizes sprites whose value (or color) changed, the rest are ORed in from cache.
+typedef enum {
+    SCENE_MAX_TEMP,
+    SCENE_CURRENT_TEMP,
+    SCENE_PRECIP,
+    SCENE_MOON,
+    SCENE_LETTER,
+    NUM_SCENE_SPRITES
+} Scene_sprite_type;
+
+typedef struct {
+    view_frame_t raster;
+    COLOR_TYPE color;
+    uint8_t value;
+    uint8_t valid;
+} Scene_sprite;
+
+static Scene_sprite Scene[NUM_SCENE_SPRITES];
+
 // PRIVATE METHODS
 void build_view(view_frame_t *);
+void add_scene_sprite(Scene_sprite_type, SPRITE_TYPE, COLOR_TYPE, uint8_t, view_frame_t *);
 uint8_t update_stored_value(uint8_t*, uint8_t);
 
 // PUBLIC METHODS
@@ -36,6 +58,8 @@ void Weather__Initialize(void) {
     Weather_next_day.max_temp = 200;
     Weather_next_day.precip = 200;
     Weather_next_day.moon = 200;
+
+    memset(Scene, 0, sizeof(Scene));
 }
 
 void Weather__Get_view(view_frame_t *frame) {
@@ -85,7 +109,7 @@ void Weather__Update_values(uint8_t api, uint8_t* payload, uint8_t payload_len)
     }
 
     if (update_view) {
-        xSemaphoreGive(displayUpdateSemaphore);
+        View__Request_update();
     }
 }
 
@@ -101,7 +125,7 @@ void Weather__Set_view_comm_loss(void) {
     Weather_next_day.max_temp = 200;
     Weather_next_day.precip = 200;
     Weather_next_day.moon = 200;
-    xSemaphoreGive(displayUpdateSemaphore);
+    View__Request_update();
 }
 
 void Weather__UI_Encoder_Top(uint8_t direction) {
@@ -142,21 +166,21 @@ void Weather__UI_Button(uint8_t btn) {
 
 void build_view(view_frame_t *frame) {
     if(Internal_view_type == DAY0) {
-        Sprite__Add_sprite(MAX_TEMP, RED, Weather_today.max_temp, frame);
-        Sprite__Add_sprite(CURRENT_TEMP, GREEN, Weather_today.current_temp, frame);
+        add_scene_sprite(SCENE_MAX_TEMP, MAX_TEMP, RED, Weather_today.max_temp, frame);
+        add_scene_sprite(SCENE_CURRENT_TEMP, CURRENT_TEMP, GREEN, Weather_today.current_temp, frame);
 
         // Only show precip if between 1 and 100. If 100, show all diagonal symbols
         if((Weather_today.precip > 0)) {
-            Sprite__Add_sprite(PRECIP, BLUE, Weather_today.precip, frame);
+            add_scene_sprite(SCENE_PRECIP, PRECIP, BLUE, Weather_today.precip, frame);
         }
 
         // Lower-left symbol: Moon icon
         if(Weather_today.moon > 0) {
-            Sprite__Add_sprite(MOON, WHITE, Weather_today.moon, frame);
+            add_scene_sprite(SCENE_MOON, MOON, WHITE, Weather_today.moon, frame);
         }
         
     } else if(Internal_view_type == DAY1) {
-        Sprite__Add_sprite(MAX_TEMP, RED, Weather_tomorrow.max_temp, frame);
+        add_scene_sprite(SCENE_MAX_TEMP, MAX_TEMP, RED, Weather_tomorrow.max_temp, frame);
         // Get number corresponding to day of the week of today (0=Sun, 1=Mon...)
         uint8_t day_of_week = Local_Time__Get_letter_day_of_week();
         if (day_of_week < 7) {  // valid day of week
@@ -164,22 +188,22 @@ void build_view(view_frame_t *frame) {
             if (day_of_week > 6) {
                 day_of_week = 0;
             }
-            Sprite__Add_sprite(LETTER, GREEN, day_of_week, frame);
+            add_scene_sprite(SCENE_LETTER, LETTER, GREEN, day_of_week, frame);
         }
         
         // Only show precip if between 1 and 100. If 100, show all diagonal symbols
         if((Weather_tomorrow.precip > 0)) {
-            Sprite__Add_sprite(PRECIP, BLUE, Weather_tomorrow.precip, frame);
+            add_scene_sprite(SCENE_PRECIP, PRECIP, BLUE, Weather_tomorrow.precip, frame);
             // ESP_LOGI(TAG, "precip: %u\n", Weather_tomorrow.precip);
         }
 
         // Lower-left symbol: Moon icon
         if(Weather_tomorrow.moon) {
-            Sprite__Add_sprite(MOON, WHITE, Weather_tomorrow.moon, frame);
+            add_scene_sprite(SCENE_MOON, MOON, WHITE, Weather_tomorrow.moon, frame);
         }
     
     } else if(Internal_view_type == DAY2) {
-        Sprite__Add_sprite(MAX_TEMP, RED, Weather_next_day.max_temp, frame);
+        add_scene_sprite(SCENE_MAX_TEMP, MAX_TEMP, RED, Weather_next_day.max_temp, frame);
         // Get number corresponding to day of the week of today (0=Sun, 1=Mon...)
         uint8_t day_of_week = Local_Time__Get_letter_day_of_week();
         if (day_of_week < 7) {  // valid day of week
@@ -187,21 +211,38 @@ void build_view(view_frame_t *frame) {
             if (day_of_week > 6) {
                 day_of_week = day_of_week - 7;
             }
-            Sprite__Add_sprite(LETTER, GREEN, day_of_week, frame);
+            add_scene_sprite(SCENE_LETTER, LETTER, GREEN, day_of_week, frame);
         }
         
         // Only show precip if between 1 and 100. If 100, show all diagonal symbols
         if((Weather_next_day.precip > 0)) {
-            Sprite__Add_sprite(PRECIP, BLUE, Weather_next_day.precip, frame);
+            add_scene_sprite(SCENE_PRECIP, PRECIP, BLUE, Weather_next_day.precip, frame);
         }
 
         // Lower-left symbol: Moon icon
         if(Weather_next_day.moon) {
-            Sprite__Add_sprite(MOON, WHITE, Weather_next_day.moon, frame);
+            add_scene_sprite(SCENE_MOON, MOON, WHITE, Weather_next_day.moon, frame);
         }
     }
 }
 
+// Rasterize sprite into its own cache when its value or color changed, then merge it into frame
+void add_scene_sprite(Scene_sprite_type slot, SPRITE_TYPE sprite, COLOR_TYPE color, uint8_t value, view_frame_t *frame) {
+    Scene_sprite *cached = &Scene[slot];
+
+    if (!cached->valid || cached->value != value || cached->color != color) {
+        memset(&cached->raster, 0, sizeof(cached->raster));
+        Sprite__Add_sprite(sprite, color, value, &cached->raster);
+        cached->value = value;
+        cached->color = color;
+        cached->valid = 1;
+    }
+
+    for (uint8_t i = 0; i < VIEW_FRAME_WORDS; i++) {
+        frame->words[i] |= cached->raster.words[i];
+    }
+}
+
 // Compare new val to old val. If changed, need to update view
 uint8_t update_stored_value(uint8_t* stored_val, uint8_t new_val) {
     uint8_t ret_val = 0;
@@ -0,0 +1,217 @@
+/* Bit bang transport for the HT1632 pair.
+    Pacing is a busy wait on the CPU cycle counter and pins are driven through the GPIO
+    set/clear registers, so a full RAM write takes well under a millisecond instead of a
+    tick per half clock. Interrupts may stretch a phase, which the chip tolerates (static logic).
+    On host builds the pins are recorded in a timestamped trace (see bit_bang.h).
+*/
+
+#include <string.h>
+
+#include "bit_bang.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include "led_emulator.h"
+#else
+#include "driver/gpio.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "soc/gpio_reg.h"
+#endif
+
+// PRIVATE variables
+static bit_bang_timing_t Timing = {
+    .setup_ns = BIT_BANG_SETUP_NS,
+    .hold_ns = BIT_BANG_HOLD_NS,
+    .cs_setup_ns = BIT_BANG_CS_SETUP_NS,
+    .cs_hold_ns = BIT_BANG_CS_HOLD_NS,
+};
+
+#if CONFIG_IDF_TARGET_LINUX
+static bit_bang_edge_t Trace[BIT_BANG_TRACE_LEN];
+static uint16_t Trace_count;
+static uint32_t Virtual_ns;
+static uint8_t Clk_pin;
+static uint8_t Data_pin;
+static uint8_t Data_level;
+static uint8_t Capture_cs = 0xFF;       // CS pin currently low, 0xFF: none
+static uint8_t Capture_buf[64];
+static uint16_t Capture_bits;
+#else
+static uint32_t Cycles_setup;
+static uint32_t Cycles_hold;
+static uint32_t Cycles_cs_setup;
+static uint32_t Cycles_cs_hold;
+static uint32_t Overhead_cycles;        // Cost of one pin write + empty wait, taken off each wait
+#endif
+
+// PRIVATE method prototypes
+static inline void pin_write(uint8_t pin, uint8_t level);
+static inline void delay_ns(uint32_t ns, uint32_t cycles);
+static void calibrate(void);
+
+// PUBLIC METHODS
+
+void Bit_bang__Setup(uint8_t clk_pin, uint8_t data_pin) {
+#if CONFIG_IDF_TARGET_LINUX
+    Clk_pin = clk_pin;
+    Data_pin = data_pin;
+#else
+    // gpio config clk and data pins
+    gpio_reset_pin(clk_pin);
+    gpio_reset_pin(data_pin);
+    gpio_set_direction(clk_pin, GPIO_MODE_OUTPUT);
+    gpio_set_direction(data_pin, GPIO_MODE_OUTPUT);
+#endif
+    pin_write(clk_pin, CLK_HI);
+    pin_write(data_pin, DATA_LO);
+    calibrate();
+}
+
+void Bit_bang__Setup_cs(uint8_t cs_pin) {
+#if !CONFIG_IDF_TARGET_LINUX
+    gpio_reset_pin(cs_pin);
+    gpio_set_direction(cs_pin, GPIO_MODE_OUTPUT);
+#endif
+    pin_write(cs_pin, 1);
+}
+
+void Bit_bang__Set_timing(const bit_bang_timing_t *timing) {
+    if (timing) {
+        Timing = *timing;
+        calibrate();
+    }
+}
+
+// CS low: wait setup before the first clk edge. CS high: wait hold after the last edge first.
+void Bit_bang__Set_cs(uint8_t cs_pin, uint8_t level) {
+#if CONFIG_IDF_TARGET_LINUX
+    if (level) {
+        delay_ns(Timing.cs_hold_ns, 0);
+        pin_write(cs_pin, 1);
+    } else {
+        pin_write(cs_pin, 0);
+        delay_ns(Timing.cs_setup_ns, 0);
+    }
+#else
+    if (level) {
+        delay_ns(Timing.cs_hold_ns, Cycles_cs_hold);
+        pin_write(cs_pin, 1);
+    } else {
+        pin_write(cs_pin, 0);
+        delay_ns(Timing.cs_setup_ns, Cycles_cs_setup);
+    }
+#endif
+}
+
+// Buffer is in wire order: bytes first->last, bits MSB->LSB, stop after num_bits.
+// Per bit: clk low, set data, wait setup, clk high (chip latches), wait hold.
+void Bit_bang__Write(uint8_t clk_pin, uint8_t data_pin, uint8_t *tx_buffer, uint16_t num_bits) {
+#if CONFIG_IDF_TARGET_LINUX
+    uint32_t cycles_setup = 0;
+    uint32_t cycles_hold = 0;
+#else
+    uint32_t cycles_setup = Cycles_setup;
+    uint32_t cycles_hold = Cycles_hold;
+#endif
+
+    for(uint16_t i_bit = 0; i_bit < num_bits; i_bit++) {
+        uint8_t level = (tx_buffer[i_bit / 8] >> (7 - (i_bit % 8))) & 1;
+
+        pin_write(clk_pin, CLK_LO);
+        pin_write(data_pin, level);
+        delay_ns(Timing.setup_ns, cycles_setup);
+        pin_write(clk_pin, CLK_HI);
+        delay_ns(Timing.hold_ns, cycles_hold);
+    }
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+uint16_t Bit_bang__Get_trace(const bit_bang_edge_t **trace) {
+    if (trace) {
+        *trace = Trace;
+    }
+    return Trace_count;
+}
+
+void Bit_bang__Clear_trace(void) {
+    Trace_count = 0;
+}
+#endif
+
+// PRIVATE METHODS
+
+#if CONFIG_IDF_TARGET_LINUX
+// Record pin change, and sample data on rising clk for the chip whose CS is low
+static inline void pin_write(uint8_t pin, uint8_t level) {
+    if (Trace_count < BIT_BANG_TRACE_LEN) {
+        Trace[Trace_count].t_ns = Virtual_ns;
+        Trace[Trace_count].pin = pin;
+        Trace[Trace_count].level = level;
+        Trace_count++;
+    }
+
+    if (pin == Data_pin) {
+        Data_level = level;
+    } else if (pin == Clk_pin) {
+        if (level == CLK_HI && Capture_cs != 0xFF && Capture_bits < (sizeof(Capture_buf) * 8)) {
+            if (Data_level) {
+                Capture_buf[Capture_bits / 8] |= (0x80 >> (Capture_bits % 8));
+            }
+            Capture_bits++;
+        }
+    } else if (level == 0) {
+        Capture_cs = pin;
+        Capture_bits = 0;
+        memset(Capture_buf, 0, sizeof(Capture_buf));
+    } else if (pin == Capture_cs) {
+        Led_emulator__Write(pin, Capture_buf, Capture_bits);
+        Capture_cs = 0xFF;
+    }
+}
+
+static inline void delay_ns(uint32_t ns, uint32_t cycles) {
+    Virtual_ns += ns;
+}
+
+static void calibrate(void) {
+}
+
+#else
+static inline void pin_write(uint8_t pin, uint8_t level) {
+    if (level) {
+        REG_WRITE(GPIO_OUT_W1TS_REG, BIT(pin));
+    } else {
+        REG_WRITE(GPIO_OUT_W1TC_REG, BIT(pin));
+    }
+}
+
+static inline void delay_ns(uint32_t ns, uint32_t cycles) {
+    uint32_t start = esp_cpu_get_cycle_count();
+    while ((uint32_t)(esp_cpu_get_cycle_count() - start) < cycles) {
+    }
+}
+
+static uint32_t ns_to_cycles(uint32_t ns, uint32_t cycles_per_us) {
+    uint32_t cycles = ((ns * cycles_per_us) + 999) / 1000;
+    return (cycles > Overhead_cycles) ? (cycles - Overhead_cycles) : 0;
+}
+
+// Convert ns timing to cycle counts. Overhead of a pin write + empty wait is measured
+// once so short setup/hold times are not padded by the loop itself.
+static void calibrate(void) {
+    uint32_t cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+
+    Overhead_cycles = 0;
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (uint8_t i = 0; i < 16; i++) {
+        REG_WRITE(GPIO_OUT_W1TS_REG, 0);
+        delay_ns(0, 0);
+    }
+    Overhead_cycles = (uint32_t)(esp_cpu_get_cycle_count() - start) / 16;
+
+    Cycles_setup = ns_to_cycles(Timing.setup_ns, cycles_per_us);
+    Cycles_hold = ns_to_cycles(Timing.hold_ns, cycles_per_us);
+    Cycles_cs_setup = ns_to_cycles(Timing.cs_setup_ns, cycles_per_us);
+    Cycles_cs_hold = ns_to_cycles(Timing.cs_hold_ns, cycles_per_us);
+}
+#endif
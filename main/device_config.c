@@ -14,6 +14,8 @@ static struct {
     char user_name[16];
     char wifi_ssid[32];
     char wifi_password[64];
+    uint32_t led_clock_hz;      // 0 = not calibrated yet
+    uint8_t led_orientation;    // LED_ORIENT_* | LED_ORIENT_MIRROR, 0 = as built
     bool initialized;
 } config_cache = {
     .device_name = "dev00",
@@ -21,6 +23,8 @@ static struct {
     .user_name = "DefaultUser",
     .wifi_ssid = "",
     .wifi_password = "",
+    .led_clock_hz = 0,
+    .led_orientation = 0,
     .initialized = false
 };
 
@@ -111,6 +115,29 @@ int Device_Config__Init(void) {
         ESP_LOGI(TAG, "Loaded WiFi password from NVS");
     }
     
+    // Read calibrated LED bus clock (optional - set after first calibration)
+    err = nvs_get_u32(nvs_handle, "led_clk", &config_cache.led_clock_hz);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGI(TAG, "LED clock not found in NVS");
+        config_cache.led_clock_hz = 0;
+    } else if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Error reading LED clock: %s", esp_err_to_name(err));
+        config_cache.led_clock_hz = 0;
+    } else {
+        ESP_LOGI(TAG, "Loaded LED clock from NVS: %lu Hz", (unsigned long)config_cache.led_clock_hz);
+    }
+
+    // Read panel orientation (optional - default is the orientation as built)
+    err = nvs_get_u8(nvs_handle, "led_orient", &config_cache.led_orientation);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        config_cache.led_orientation = 0;
+    } else if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Error reading LED orientation: %s", esp_err_to_name(err));
+        config_cache.led_orientation = 0;
+    } else {
+        ESP_LOGI(TAG, "Loaded LED orientation from NVS: %u", config_cache.led_orientation);
+    }
+    
     // Commit writes
     nvs_commit(nvs_handle);
     nvs_close(nvs_handle);
@@ -590,3 +617,95 @@ int Device_Config__Set_WiFi_Password(const char *password) {
     ESP_LOGI(TAG, "WiFi password updated");
     return 0;
 }
+
+int Device_Config__Get_Led_clock_hz(uint32_t *clock_hz) {
+    if (clock_hz == NULL) {
+        return -1;
+    }
+    
+    if (!config_cache.initialized) {
+        ESP_LOGW(TAG, "Config not initialized, call Device_Config__Init() first");
+        return -1;
+    }
+    
+    if (config_cache.led_clock_hz == 0) {
+        return -1;
+    }
+    
+    *clock_hz = config_cache.led_clock_hz;
+    return 0;
+}
+
+int Device_Config__Set_Led_clock_hz(uint32_t clock_hz) {
+    // Only write if different
+    if (config_cache.led_clock_hz == clock_hz) {
+        ESP_LOGD(TAG, "LED clock unchanged, skipping write");
+        return 0;
+    }
+    
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+        return -1;
+    }
+    
+    err = nvs_set_u32(nvs_handle, "led_clk", clock_hz);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write LED clock: %s", esp_err_to_name(err));
+        nvs_close(nvs_handle);
+        return -1;
+    }
+    
+    nvs_commit(nvs_handle);
+    nvs_close(nvs_handle);
+    
+    config_cache.led_clock_hz = clock_hz;
+    
+    ESP_LOGI(TAG, "LED clock updated: %lu Hz", (unsigned long)clock_hz);
+    return 0;
+}
+
+int Device_Config__Get_Led_orientation(uint8_t *orientation) {
+    if (orientation == NULL) {
+        return -1;
+    }
+    
+    if (!config_cache.initialized) {
+        ESP_LOGW(TAG, "Config not initialized, call Device_Config__Init() first");
+        return -1;
+    }
+    
+    *orientation = config_cache.led_orientation;
+    return 0;
+}
+
+int Device_Config__Set_Led_orientation(uint8_t orientation) {
+    // Only write if different
+    if (config_cache.led_orientation == orientation) {
+        ESP_LOGD(TAG, "LED orientation unchanged, skipping write");
+        return 0;
+    }
+    
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+        return -1;
+    }
+    
+    err = nvs_set_u8(nvs_handle, "led_orient", orientation);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write LED orientation: %s", esp_err_to_name(err));
+        nvs_close(nvs_handle);
+        return -1;
+    }
+    
+    nvs_commit(nvs_handle);
+    nvs_close(nvs_handle);
+    
+    config_cache.led_orientation = orientation;
+    
+    ESP_LOGI(TAG, "LED orientation updated: %u", orientation);
+    return 0;
+}
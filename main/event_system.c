@@ -1,7 +1,10 @@
 #include "event_system.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "view.h"
 #include "main.h"
+#include "latency.h"
+#include "tasks.h"
 
 static const char *TAG = "EVENT_SYSTEM";
 
@@ -38,14 +41,7 @@ void EventSystem_StartTasks(void) {
     ESP_LOGI(TAG, "Starting Event System tasks");
 
     // Create event dispatcher task (highest priority for responsiveness)
-    xTaskCreate(
-        event_dispatcher_task,           // Task function
-        "EventDispatcher",               // Task name (for debugging)
-        (3*configMINIMAL_STACK_SIZE),   // Stack size (words)
-        NULL,                           // Task parameter
-        12,                             // Task priority (high)
-        &eventDispatcherTaskHandle      // Task handle
-    );
+    Tasks__Create(TASK_EVENT_DISPATCHER, event_dispatcher_task, NULL, &eventDispatcherTaskHandle);
     
     // Wait for event dispatcher to signal it's ready (max 1 second)
     EventBits_t bits = xEventGroupWaitBits(
@@ -90,6 +86,7 @@ void event_dispatcher_task(void *pvParameters) {
             switch (event.type) {
                 case EVENT_UI_BUTTON_DOWN:
                     // Button pressed (down)
+                    Latency__Mark_dispatch(event.timestamp);
                     for (int i = 0; i < 4; i++) {
                         if (event.data & (1 << i)) {
                             View__Process_UI(1 << i);
@@ -108,6 +105,7 @@ void event_dispatcher_task(void *pvParameters) {
                     break;
                     
                 case EVENT_UI_ENCODER:
+                    Latency__Mark_dispatch(event.timestamp);
                     // Check each encoder event and notify view
                     // first 4 bits are buttons, next 4 bits are encoders
                     for (int i = 4; i < 8; i++) {
@@ -119,7 +117,7 @@ void event_dispatcher_task(void *pvParameters) {
 
                 case EVENT_MQTT_DATA_RECEIVED:
                     // MQTT data received - may need display update
-                    xSemaphoreGive(displayUpdateSemaphore);
+                    View__Request_update();
                     break;
                     
                 case EVENT_BRIGHTNESS_CHANGE:
@@ -147,11 +145,16 @@ void event_dispatcher_task(void *pvParameters) {
 
 // Post event to system event queue
 void EventSystem_PostEvent(event_type_t type, uint32_t data, void* payload) {
+    EventSystem_PostEventAt(type, data, payload, (uint32_t)esp_timer_get_time());
+}
+
+// Post event detected earlier than now (eg. timestamp taken in an ISR, before debounce)
+void EventSystem_PostEventAt(event_type_t type, uint32_t data, void* payload, uint32_t timestamp) {
     system_event_t event = {
         .type = type,
         .data = data,
         .payload = payload,
-        .timestamp = xTaskGetTickCount()
+        .timestamp = timestamp
     };
     
     // Try to post event, don't block if queue is full
@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "latency.h"
+
+static const char *TAG = "WEATHER_STATION: LATENCY";
+
+typedef enum {
+    TRACE_IDLE,
+    TRACE_DISPATCHED,
+    TRACE_BUILDING,
+    TRACE_PUBLISHED
+} trace_state_t;
+
+// Stage timestamps of the input being traced (esp_timer us, low 32 bits)
+typedef struct {
+    trace_state_t state;
+    uint32_t detect_us;
+    uint32_t dispatch_us;
+    uint32_t build_us;
+    uint32_t publish_us;
+    uint32_t frame_seq;
+} latency_trace_t;
+
+// PRIVATE variables
+static latency_trace_t Trace;
+static latency_histogram_t Histograms[LATENCY_NUM_STAGES];
+static uint32_t Num_unchanged;          // Traced inputs whose frame was skipped as unchanged
+static portMUX_TYPE Latency_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *Stage_names[LATENCY_NUM_STAGES] = {
+    [LATENCY_STAGE_QUEUE] = "queue",
+    [LATENCY_STAGE_DISPATCH] = "dispatch",
+    [LATENCY_STAGE_RENDER] = "render",
+    [LATENCY_STAGE_TRANSMIT] = "transmit",
+    [LATENCY_STAGE_TOTAL] = "total",
+};
+
+// PRIVATE method prototypes
+void record_sample(latency_stage_t, uint32_t);
+uint8_t bucket_index(uint32_t);
+
+// PUBLIC methods
+
+// Event dispatcher picked up a UI event detected at detect_us. Starts a trace unless one
+// is in flight (a stale one is dropped).
+void Latency__Mark_dispatch(uint32_t detect_us) {
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+
+    portENTER_CRITICAL(&Latency_lock);
+    if (Trace.state != TRACE_IDLE && (now_us - Trace.detect_us) > LATENCY_TRACE_TIMEOUT_US) {
+        Trace.state = TRACE_IDLE;
+    }
+    if (Trace.state == TRACE_IDLE) {
+        Trace.detect_us = detect_us;
+        Trace.dispatch_us = now_us;
+        Trace.state = TRACE_DISPATCHED;
+    }
+    portEXIT_CRITICAL(&Latency_lock);
+}
+
+// Display task (or dispatcher on a view switch) starts building a frame.
+// A build already running when the input was dispatched does not count.
+void Latency__Mark_build_start(void) {
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+
+    portENTER_CRITICAL(&Latency_lock);
+    if (Trace.state == TRACE_DISPATCHED) {
+        Trace.build_us = now_us;
+        Trace.state = TRACE_BUILDING;
+    }
+    portEXIT_CRITICAL(&Latency_lock);
+}
+
+// Built frame about to be handed to the driver as frame_seq (Led_driver__Get_frame_seq + 1)
+void Latency__Mark_frame_published(uint32_t frame_seq) {
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+
+    portENTER_CRITICAL(&Latency_lock);
+    if (Trace.state == TRACE_BUILDING) {
+        Trace.publish_us = now_us;
+        Trace.frame_seq = frame_seq;
+        Trace.state = TRACE_PUBLISHED;
+    }
+    portEXIT_CRITICAL(&Latency_lock);
+}
+
+// Built frame is identical to the one sent last, nothing goes to the driver
+void Latency__Mark_frame_unchanged(void) {
+    portENTER_CRITICAL(&Latency_lock);
+    if (Trace.state == TRACE_BUILDING) {
+        Trace.state = TRACE_IDLE;
+        Num_unchanged++;
+    }
+    portEXIT_CRITICAL(&Latency_lock);
+}
+
+// Driver frame-done callback. Frames are only ever replaced by newer ones, so any frame
+// at or after the traced one carries the input.
+void Latency__Mark_frame_done(int64_t done_us, uint32_t frame_seq) {
+    latency_trace_t trace;
+
+    portENTER_CRITICAL(&Latency_lock);
+    trace = Trace;
+    if (trace.state == TRACE_PUBLISHED && (int32_t)(frame_seq - trace.frame_seq) >= 0) {
+        Trace.state = TRACE_IDLE;
+    } else {
+        trace.state = TRACE_IDLE;
+    }
+    portEXIT_CRITICAL(&Latency_lock);
+
+    if (trace.state != TRACE_PUBLISHED) {
+        return;
+    }
+
+    uint32_t wire_us = (uint32_t)done_us;
+    record_sample(LATENCY_STAGE_QUEUE, trace.dispatch_us - trace.detect_us);
+    record_sample(LATENCY_STAGE_DISPATCH, trace.build_us - trace.dispatch_us);
+    record_sample(LATENCY_STAGE_RENDER, trace.publish_us - trace.build_us);
+    record_sample(LATENCY_STAGE_TRANSMIT, wire_us - trace.publish_us);
+    record_sample(LATENCY_STAGE_TOTAL, wire_us - trace.detect_us);
+}
+
+void Latency__Get_histogram(latency_stage_t stage, latency_histogram_t *histogram) {
+    if (stage >= LATENCY_NUM_STAGES || !histogram) {
+        return;
+    }
+    portENTER_CRITICAL(&Latency_lock);
+    *histogram = Histograms[stage];
+    portEXIT_CRITICAL(&Latency_lock);
+}
+
+uint32_t Latency__Get_num_unchanged(void) {
+    return Num_unchanged;
+}
+
+void Latency__Reset(void) {
+    portENTER_CRITICAL(&Latency_lock);
+    memset(Histograms, 0, sizeof(Histograms));
+    Num_unchanged = 0;
+    Trace.state = TRACE_IDLE;
+    portEXIT_CRITICAL(&Latency_lock);
+}
+
+// One line per stage: samples, mean, max, then the non-empty buckets as lower bound (us):count
+void Latency__Log(void) {
+    ESP_LOGI(TAG, "unchanged n=%lu", (unsigned long)Num_unchanged);
+    for (uint8_t stage = 0; stage < LATENCY_NUM_STAGES; stage++) {
+        latency_histogram_t histogram;
+        char line[160] = "";
+        int len = 0;
+
+        Latency__Get_histogram(stage, &histogram);
+        uint32_t mean_us = histogram.num_samples ? (uint32_t)(histogram.total_us / histogram.num_samples) : 0;
+        for (uint8_t bucket = 0; bucket < LATENCY_NUM_BUCKETS && len < (int)sizeof(line); bucket++) {
+            if (histogram.bucket[bucket] == 0) {
+                continue;
+            }
+            uint32_t lower_us = bucket ? (1UL << bucket) : 0;
+            len += snprintf(&line[len], sizeof(line) - len, " %lu:%lu", (unsigned long)lower_us, (unsigned long)histogram.bucket[bucket]);
+        }
+
+        ESP_LOGI(TAG, "%-8s n=%lu mean=%lu us max=%lu us |%s", Stage_names[stage], (unsigned long)histogram.num_samples,
+                 (unsigned long)mean_us, (unsigned long)histogram.max_us, line);
+    }
+}
+
+const char *Latency__Stage_name(latency_stage_t stage) {
+    if (stage >= LATENCY_NUM_STAGES) {
+        return "-";
+    }
+    return Stage_names[stage];
+}
+
+// PRIVATE METHODS
+
+void record_sample(latency_stage_t stage, uint32_t sample_us) {
+    latency_histogram_t *histogram = &Histograms[stage];
+
+    portENTER_CRITICAL(&Latency_lock);
+    histogram->bucket[bucket_index(sample_us)]++;
+    histogram->num_samples++;
+    histogram->total_us += sample_us;
+    if (sample_us > histogram->max_us) {
+        histogram->max_us = sample_us;
+    }
+    portEXIT_CRITICAL(&Latency_lock);
+}
+
+// floor(log2(us)), clamped to the last bucket
+uint8_t bucket_index(uint32_t sample_us) {
+    if (sample_us < 2) {
+        return 0;
+    }
+    uint8_t index = (uint8_t)(31 - __builtin_clz(sample_us));
+    return (index < LATENCY_NUM_BUCKETS) ? index : (LATENCY_NUM_BUCKETS - 1);
+}
@@ -1,52 +1,307 @@
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/gpio.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
 
 #include "led_driver.h"
+#include "led_emulator.h"
+#include "panel_wiring.h"
+#include "tasks.h"
+#if LED_TRANSPORT == LED_TRANSPORT_SPI
+#include "driver/gpio.h"
 #include "spi.h"
+#elif LED_TRANSPORT == LED_TRANSPORT_BIT_BANG
+#include "bit_bang.h"
+#endif
 
-// const static char *TAG = "WEATHER_STATION: LED_DRIVER";
+static const char *TAG = "WEATHER_STATION: LED_DRIVER";
 
 // PRIVATE variables
-static uint16_t RAM_red[24];
-static uint16_t RAM_blue[24];
 
-spi_device_handle_t Spi_Handle_Red;
-spi_device_handle_t Spi_Handle_Blue;
+static const led_panel_t Panels[LED_NUM_PANELS] = LED_PANELS;
+
+// RAM images for both chips of a panel. Render side translates into Frame_back and swaps it
+// with Frame_front; the transmit task copies Frame_front out and puts it on the wire.
+typedef struct {
+    uint16_t red[24];
+    uint16_t blue[24];
+} RAM_image_t;
+
+// One image per panel for plain frames, VIEW_GRAY_BITS weighted planes for grayscale frames
+typedef struct {
+    RAM_image_t planes[VIEW_GRAY_BITS][LED_NUM_PANELS];
+    uint8_t num_planes;
+    uint32_t seq;
+    uint16_t lit_leds;      // Counted on the render side (count_lit)
+} RAM_frame_t;
+
+static RAM_frame_t RAM_frames[2];
+static RAM_frame_t *Frame_back = &RAM_frames[0];
+static RAM_frame_t *Frame_front = &RAM_frames[1];
+static RAM_frame_t Frame_wire;
+static uint8_t Frame_pending;           // Frame_front holds a frame not yet picked up
+static uint32_t Frame_seq;              // Number of the newest frame handed over
+static portMUX_TYPE Frame_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Transmit task notification bits
+#define NOTIFY_FRAME        0x01    // New frame swapped in
+#define NOTIFY_PLANE        0x02    // Plane timer expired, show next grayscale plane
+#define NOTIFY_COMMAND      0x04    // Commands queued in Command_batch
+#define NOTIFY_BLINK        0x08    // Region blink changed phase
+
+// Commands waiting for the transmit task, one slot per kind (a newer request replaces the
+// pending one). Sent to every chip as one command mode stream (100 C C C), ahead of the
+// RAM writes of the frame or plane being put on the wire.
+#define COMMAND_PWM         0x01
+#define COMMAND_LED         0x02
+#define COMMAND_BLINK       0x04
+#define COMMAND_MAX         3       // Slots above
+typedef struct {
+    uint8_t pending;        // COMMAND_* bits
+    uint8_t pwm_duty;       // 101X DDDD
+    uint8_t led;            // LED_ON / LED_OFF
+    uint8_t blink;          // BLINK_ON / BLINK_OFF
+} command_batch_t;
+
+static command_batch_t Command_batch;
+static portMUX_TYPE Command_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Binary coded modulation: plane k stays on the chips for LED_GRAY_BASE_US << k
+static esp_timer_handle_t Plane_timer = NULL;
+static uint8_t Gray_active;
+static uint8_t Gray_plane;
+static int64_t Gray_cycle_start_us;
+
+// Region blink: two banks per plane, the frame as rendered and the frame with the masked
+// bits cleared. A periodic timer flips between them; only the masked nibbles go out.
+static esp_timer_handle_t Blink_timer = NULL;
+static view_frame_t Blink_view_mask;    // As requested, to ignore repeats of the same region
+static RAM_image_t Blink_mask;          // Chip RAM bits of the blinking pixels (every panel)
+static uint16_t Blink_period_ms;        // 0 = no region blink
+static uint8_t Blink_dark;              // Masked bits are currently cleared
+static portMUX_TYPE Blink_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t Transmit_task_handle = NULL;
+static TaskHandle_t Scrub_task_handle = NULL;
+static volatile uint32_t Scrub_budget_us = LED_SCRUB_BUDGET_US;     // Bus us per second
+static SemaphoreHandle_t Bus_mutex = NULL;     // One owner of the chips at a time (frames, commands)
+static led_frame_done_cb_t Frame_done_cb = NULL;
+static volatile int64_t Frame_done_us;
+static uint32_t Clock_hz = LED_CLOCK_DEFAULT_HZ;
+static uint8_t Led_state = 1;           // Last LED on/off command, restored after calibration (Fade_lock)
+
+static volatile uint8_t Orientation = LED_ORIENT_0;    // LED_ORIENT_* | LED_ORIENT_MIRROR
+
+// Current limiting and energy accounting (transmit task)
+static uint16_t Current_budget_ma = LED_CURRENT_BUDGET_MA;
+static volatile uint8_t Requested_level;    // Last Led_driver__Set_brightness
+static volatile uint8_t Max_level = 15;     // Cap for the frame on the chips
+static uint8_t Chip_level;                  // PWM level last sent (setup sends PWM_DUTY: level 0)
+static uint8_t Chip_led_on = 1;
+static int64_t Energy_since_us;             // Start of the interval at Stats.current_ma
+static uint32_t Power_uw;                   // Estimated power over that interval
+static uint64_t Energy_rem;                 // Sub-uJ remainder (uW * us)
+
+// Brightness fade: esp_timer callback steps Requested_level toward the target, commands go
+// through the batch like any brightness change
+typedef struct {
+    uint8_t target;
+    uint8_t num_steps;
+    uint8_t step;
+    uint8_t off_at_end;     // LED off once the target (level 0) is reached. Cleared when the
+                            // fade is stopped, retargeted or done: set = fading off right now.
+    uint8_t running;        // Steps left. Cleared when stopped, so a callback already past
+                            // esp_timer_stop leaves the level alone.
+    int64_t start_us;
+    uint32_t step_us;
+} fade_t;
+
+static esp_timer_handle_t Fade_timer = NULL;
+static fade_t Fade;
+static uint8_t Restore_level;       // Level before fading off, faded back to on wake
+static portMUX_TYPE Fade_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Write mode stream for all 96 addresses: 10 mode/address bits + (24 rows * 16 bits) = 394 bits
+// Round up nearest 8 bits = 400 = 50bytes
+#define RAM_STREAM_BITS     394
+#define RAM_STREAM_BYTES    50
+#define RAM_NUM_ADDR        96      // 24 rows * 4 addr/row
+#define SCRUB_WINDOWS_PER_PASS  (((RAM_NUM_ADDR + LED_SCRUB_WINDOW_ADDR - 1) / LED_SCRUB_WINDOW_ADDR) * LED_NUM_PANELS * 2)
+
+// Last RAM image written to each chip. Only addresses that differ from it get sent.
+typedef struct {
+    uint16_t RAM[24];
+    uint8_t valid;      // 0 until a full write lands (chip RAM undefined after power up)
+} RAM_shadow_t;
+
+// Wire-order bit writer: stream bit 0 is the MSB of buf[0]
+typedef struct {
+    uint8_t *buf;
+    uint32_t acc;       // Pending bits, right aligned
+    uint8_t acc_bits;
+    uint16_t num_bits;  // Total bits written
+} bit_writer_t;
+
+static const led_transport_t *Transport = NULL;
+static led_driver_stats_t Stats;
+static uint64_t Total_frame_ns;
+static uint32_t Frame_bytes;    // Bytes clocked out so far for the frame in progress
+static uint32_t Frame_bits;
+static uint32_t Frame_transactions;
+static uint64_t Total_bits;
+static RAM_shadow_t Shadows[LED_NUM_PANELS][2];     // [panel][0: red chip, 1: blue chip]
+
+#if LED_TRANSPORT == LED_TRANSPORT_SPI
+#if LED_NUM_PANELS > 3
+#error "SPI2 has 6 hardware chip selects: at most 3 panels on the SPI transport"
+#endif
+spi_device_handle_t Spi_handles[LED_NUM_PANELS][2];
+#endif
 
 // PRIVATE method prototypes
-void configure_GPIO_output(uint8_t);
-void set_cs(uint8_t, uint8_t);
-uint16_t add_payload_to_buf(uint8_t*, uint16_t, uint16_t, uint8_t);
-void send_setup_messages(uint8_t);
+void send_setup_messages(uint8_t, uint8_t);
 void send_single_command(uint8_t, uint8_t);
-void update_RAM(uint8_t, uint16_t*);
+void send_command_all(uint8_t);
+void queue_command(uint8_t, uint8_t);
+void send_batch(void);
+void flush_commands(void);
+void update_RAM(uint8_t, const uint16_t*);
 void clear_RAM(uint8_t);
+void write_RAM_run(uint8_t, const uint16_t*, uint8_t, uint8_t);
+RAM_shadow_t *get_shadow(uint8_t);
+void invalidate_shadows(void);
 void transmit_spi(uint8_t, uint8_t*, uint16_t);
+void record_frame_stats(uint32_t);
+int verify_clock(uint8_t);
+void transmit_task(void *);
+void scrub_task(void *);
+int scrub_window(uint8_t, uint8_t, uint8_t);
+void publish_frame(void);
+void take_new_frame(void);
+void show_plane(uint8_t);
+void write_plane(uint8_t);
+void plane_timer_callback(void *);
+void blink_timer_callback(void *);
+void translate_blink_mask(const view_frame_t*, RAM_image_t*);
+void bus_take(void);
+int64_t bus_give(void);
+void batch_command(uint8_t, uint8_t);
+void apply_level(uint8_t);
+void batch_level(uint8_t);
+void start_fade(uint8_t, uint32_t, uint8_t);
+void stop_fade(void);
+void finish_fade_off(void);
+void fade_timer_callback(void *);
+uint8_t max_level_for(uint16_t);
+void account_energy(void);
+uint16_t count_lit(const view_frame_t*);
+
+uint16_t pack_RAM_stream(uint8_t*, const uint16_t*);
+static inline void bits_begin(bit_writer_t*, uint8_t*);
+static inline void bits_put(bit_writer_t*, uint16_t, uint8_t);
+static inline uint16_t bits_end(bit_writer_t*);
+
+void translate_view_to_RAM(const view_frame_t*, RAM_image_t*);
+void orient_frame(const view_frame_t*, view_frame_t*, uint8_t);
+void orient_rows(const uint16_t*, uint16_t*, uint8_t, uint8_t, uint8_t);
+static inline void transpose_16x16(uint16_t*);
+
+// Transport backends
+#if LED_TRANSPORT == LED_TRANSPORT_SPI
+static void spi_transport_init(void);
+static void spi_transport_write(uint8_t, uint8_t*, uint16_t);
+static void spi_transport_set_clock(uint32_t);
+static spi_device_handle_t get_spi_handle(uint8_t);
+#if RD_PIN >= 0
+static int spi_transport_read(uint8_t, uint8_t*, uint16_t, uint8_t*, uint8_t);
+#endif
+
+static const led_transport_t Transport_spi = {
+    .name = "spi",
+    .init = spi_transport_init,
+    .write = spi_transport_write,
+    .flush = Spi__Flush,
+    .set_clock_hz = spi_transport_set_clock,
+#if RD_PIN >= 0
+    .read = spi_transport_read,
+#endif
+};
+#define DEFAULT_TRANSPORT   (&Transport_spi)
 
-uint16_t insert_bits_MSB_buffer(uint8_t*, uint16_t, uint8_t, uint8_t);
+#elif LED_TRANSPORT == LED_TRANSPORT_BIT_BANG
+static void bit_bang_transport_init(void);
+static void bit_bang_transport_write(uint8_t, uint8_t*, uint16_t);
+static void bit_bang_transport_set_clock(uint32_t);
 
-void translate_views_to_RAM_red(uint16_t *, uint16_t *, uint16_t *);
-void translate_views_to_RAM_blue(uint16_t *, uint16_t *, uint16_t *, uint16_t *);
+static const led_transport_t Transport_bit_bang = {
+    .name = "bit_bang",
+    .init = bit_bang_transport_init,
+    .write = bit_bang_transport_write,
+    .set_clock_hz = bit_bang_transport_set_clock,
+};
+#define DEFAULT_TRANSPORT   (&Transport_bit_bang)
+
+#else
+#define DEFAULT_TRANSPORT   (&Led_transport_emulator)
+#endif
 
 
 // PUBLIC methods
 
 void Led_driver__Initialize(void) {
-    #if USE_SPI_BIT_BANG
-    configure_GPIO_output(CS_RED);
-    configure_GPIO_output(CS_BLUE);
-    Spi__BitBang_Setup(CLK_PIN, DATA_PIN);
+    if (Transport == NULL) {
+        Transport = DEFAULT_TRANSPORT;
+    }
+    if (Bus_mutex == NULL) {
+        Bus_mutex = xSemaphoreCreateMutex();
+    }
+    if (Transport->init) {
+        Transport->init();
+    }
+
+    bus_take();
+    for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        send_setup_messages(Panels[panel].cs_red, Panels[panel].sync_red);
+        send_setup_messages(Panels[panel].cs_blue, Panels[panel].sync_blue);
+    }
+    bus_give();
+    ESP_LOGI(TAG, "%u panel(s) on %s transport", LED_NUM_PANELS, Transport->name);
 
-    #else
-    Spi_Handle_Red = Spi__Init(DATA_PIN, CLK_PIN, SPI_MODE, CS_RED);    // Unused pin 46 used for CS til incorporate CS into SPI
-    Spi_Handle_Blue = Spi__Init(DATA_PIN, CLK_PIN, SPI_MODE, CS_BLUE);    // Unused pin 46 used for CS til incorporate CS into SPI
-    #endif
+    if (Plane_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = plane_timer_callback,
+            .name = "led_plane",
+        };
+        esp_timer_create(&timer_args, &Plane_timer);
+    }
+    if (Blink_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = blink_timer_callback,
+            .name = "led_blink",
+        };
+        esp_timer_create(&timer_args, &Blink_timer);
+    }
+    if (Fade_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = fade_timer_callback,
+            .name = "led_fade",
+        };
+        esp_timer_create(&timer_args, &Fade_timer);
+    }
 
-    send_setup_messages(CS_RED);
-    send_setup_messages(CS_BLUE);
+    if (Transmit_task_handle == NULL) {
+        // Above the display task: picks up frames as soon as they are swapped in
+        Tasks__Create(TASK_LED_TRANSMIT, transmit_task, NULL, &Transmit_task_handle);
+    }
+
+    if (Scrub_task_handle == NULL && Transport->read) {
+        // Background: only runs when nothing else on the core wants the CPU. Without
+        // read-back (SPI with RD_PIN < 0, bit bang) there is nothing to scrub with.
+        Tasks__Create(TASK_LED_SCRUB, scrub_task, NULL, &Scrub_task_handle);
+    }
 }
 
 // Send commands to Led drivers at bootup
@@ -55,31 +310,136 @@ void Led_driver__Initialize(void) {
 //     send_setup_messages(CS_BLUE);
 // }
 
+// Hand a frame to the transmit task. Does not wait for the bus: the frame is translated
+// into the back buffer and swapped to the front. If the previous front frame has not been
+// picked up yet it is replaced (only the newest frame matters).
+// Every panel on the chain shows the same frame.
 void Led_driver__Update_RAM(view_frame_t *frame) {
-    //translate view to RAM
-    translate_views_to_RAM_red(frame->red, frame->green, RAM_red);
-    translate_views_to_RAM_blue(frame->red, frame->green, frame->blue, RAM_blue);
+    translate_view_to_RAM(frame, &Frame_back->planes[0][0]);
+    for (uint8_t panel = 1; panel < LED_NUM_PANELS; panel++) {
+        Frame_back->planes[0][panel] = Frame_back->planes[0][0];
+    }
+    Frame_back->num_planes = 1;
+    Frame_back->lit_leds = count_lit(frame) * LED_NUM_PANELS;
+
+    publish_frame();
+}
 
-    update_RAM(CS_RED, RAM_red);
-    update_RAM(CS_BLUE, RAM_blue);
+// One frame per panel (LED_NUM_PANELS, chain order), all sent in the same bus acquisition
+void Led_driver__Update_RAM_panels(view_frame_t *frames) {
+    uint16_t lit_leds = 0;
+    for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        translate_view_to_RAM(&frames[panel], &Frame_back->planes[0][panel]);
+        lit_leds += count_lit(&frames[panel]);
+    }
+    Frame_back->num_planes = 1;
+    Frame_back->lit_leds = lit_leds;
+
+    publish_frame();
+}
+
+// Grayscale frame: planes are cycled with binary coded modulation until the next frame.
+// Below LED_GRAY_MIN_CLOCK_HZ the bus is too slow to cycle planes, so any lit level is shown on.
+void Led_driver__Update_RAM_gray(view_gray_frame_t *frame) {
+    if (Clock_hz < LED_GRAY_MIN_CLOCK_HZ) {
+        view_frame_t flat;
+        memset(&flat, 0, sizeof(flat));
+        for (uint8_t k = 0; k < VIEW_GRAY_BITS; k++) {
+            for (uint8_t row = 0; row < 16; row++) {
+                flat.red[row] |= frame->planes[k].red[row];
+                flat.green[row] |= frame->planes[k].green[row];
+                flat.blue[row] |= frame->planes[k].blue[row];
+            }
+        }
+        Led_driver__Update_RAM(&flat);
+        return;
+    }
+
+    // Plane k is on for 2^k of the (2^VIEW_GRAY_BITS - 1) slots of a cycle
+    uint32_t weighted_lit = 0;
+    for (uint8_t k = 0; k < VIEW_GRAY_BITS; k++) {
+        translate_view_to_RAM(&frame->planes[k], &Frame_back->planes[k][0]);
+        for (uint8_t panel = 1; panel < LED_NUM_PANELS; panel++) {
+            Frame_back->planes[k][panel] = Frame_back->planes[k][0];
+        }
+        weighted_lit += (uint32_t)count_lit(&frame->planes[k]) << k;
+    }
+    Frame_back->num_planes = VIEW_GRAY_BITS;
+    Frame_back->lit_leds = (uint16_t)((weighted_lit + ((1 << VIEW_GRAY_BITS) - 1) - 1) / ((1 << VIEW_GRAY_BITS) - 1)) * LED_NUM_PANELS;
+
+    publish_frame();
 }
 
 void Led_driver__Clear_RAM(void) {
-    clear_RAM(CS_RED);
-    clear_RAM(CS_BLUE);
+    bus_take();
+    for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        clear_RAM(Panels[panel].cs_red);
+        clear_RAM(Panels[panel].cs_blue);
+    }
+    bus_give();
 }
 
-// Brightness 0 (on but most dim) to 15 (brightest)
+// Chip RAM contents no longer trusted: the next frame is written in full, not as a diff.
+// Waits for the bus so a frame being diffed against the shadows right now is not torn.
+void Led_driver__Invalidate_RAM(void) {
+    bus_take();
+    invalidate_shadows();
+    bus_give();
+}
+
+// Brightness 0 (on but most dim) to 15 (brightest). Queued: goes out with the next frame,
+// or on its own right away when no frame is pending.
+// Capped to the current budget for the frame on the chips; each new frame is capped again.
+// Stops a running fade.
 void Led_driver__Set_brightness(uint8_t level) {
-    level &= 0xF;
-    uint8_t pwm_duty = 0xA0 | level;    // 101X DDDD
+    stop_fade();
+    apply_level(level & 0xF);
+}
 
-    send_single_command(pwm_duty, CS_RED);
-    send_single_command(pwm_duty, CS_BLUE);
+// Ramp from the present level to level over duration_ms without blocking the caller.
+// A new fade (or Set_brightness) takes over from wherever the running one got to.
+void Led_driver__Fade_brightness(uint8_t level, uint32_t duration_ms) {
+    start_fade(level & 0xF, duration_ms, 0);
 }
 
-// Turn display on/off
+// Fade the display off (down to level 0, then LED off) or back on (LED on at level 0, then
+// up to the level it had before fading off). Fading on while a fade off is still running
+// turns it around from the level it got to; the LED never goes off.
+void Led_driver__Fade_LED(uint8_t led_state, uint32_t duration_ms) {
+    portENTER_CRITICAL(&Fade_lock);
+    uint8_t is_on = Led_state;
+    uint8_t fading_off = Fade.off_at_end;
+    if (led_state == 1) {
+        Fade.off_at_end = 0;
+    }
+    portEXIT_CRITICAL(&Fade_lock);
+
+    if (led_state == 1) {
+        if (is_on && !fading_off) {
+            return;
+        }
+        if (!is_on) {
+            stop_fade();
+            apply_level(0);
+            portENTER_CRITICAL(&Fade_lock);
+            Led_state = 1;
+            portEXIT_CRITICAL(&Fade_lock);
+            queue_command(COMMAND_LED, LED_ON);
+        }
+        start_fade(Restore_level, duration_ms, 0);
+    } else {
+        // Already off or on the way: the level to restore was taken when that fade started
+        if (!is_on || fading_off) {
+            return;
+        }
+        Restore_level = Requested_level;
+        start_fade(0, duration_ms, 1);
+    }
+}
+
+// Turn display on/off (queued like brightness). Stops a running fade.
 void Led_driver__Toggle_LED(uint8_t led_state) {
+    stop_fade();
     uint8_t cmd;
     if(led_state==1) {
         cmd = LED_ON;
@@ -87,237 +447,1208 @@ void Led_driver__Toggle_LED(uint8_t led_state) {
         cmd = LED_OFF;
     }
 
-    send_single_command(cmd, CS_RED);
-    send_single_command(cmd, CS_BLUE);
+    portENTER_CRITICAL(&Fade_lock);
+    Led_state = (led_state == 1);
+    portEXIT_CRITICAL(&Fade_lock);
+    queue_command(COMMAND_LED, cmd);
 }
 
+// Whole display blinks on the chip oscillator (queued like brightness)
+void Led_driver__Set_blink(uint8_t blink_state) {
+    queue_command(COMMAND_BLINK, blink_state ? BLINK_ON : BLINK_OFF);
+}
 
-// PRIVATE METHODS
+// Blink the pixels set in mask (any channel) with period_ms per on/off cycle, on top of
+// whatever frames are handed over. The transmit task flips the masked bits on its own,
+// the render side is not involved. Same mask on every panel. NULL or 0 stops it.
+// Repeating the current region and period is a no-op so the phase keeps running.
+void Led_driver__Set_blink_region(const view_frame_t *mask, uint16_t period_ms) {
+    RAM_image_t RAM_mask;
+
+    if (!mask || period_ms == 0) {
+        if (Blink_period_ms == 0) {
+            return;
+        }
+        esp_timer_stop(Blink_timer);
+        portENTER_CRITICAL(&Blink_lock);
+        Blink_period_ms = 0;
+        Blink_dark = 0;
+        portEXIT_CRITICAL(&Blink_lock);
+    } else {
+        if (period_ms == Blink_period_ms && memcmp(mask, &Blink_view_mask, sizeof(Blink_view_mask)) == 0) {
+            return;
+        }
+        translate_blink_mask(mask, &RAM_mask);
+
+        esp_timer_stop(Blink_timer);
+        portENTER_CRITICAL(&Blink_lock);
+        Blink_view_mask = *mask;
+        Blink_mask = RAM_mask;
+        Blink_period_ms = period_ms;
+        Blink_dark = 0;
+        portEXIT_CRITICAL(&Blink_lock);
+        esp_timer_start_periodic(Blink_timer, (uint64_t)period_ms * 500);
+    }
 
-void configure_GPIO_output(uint8_t pin) {
-    gpio_reset_pin(pin);
-    gpio_set_direction(pin, GPIO_MODE_OUTPUT);
-    set_cs(pin, CS_INACTIVE);
+    // Bring back pixels left dark by the previous region
+    if (Transmit_task_handle) {
+        xTaskNotify(Transmit_task_handle, NOTIFY_BLINK, eSetBits);
+    }
 }
 
-// Allow time for settle, Set CS pin, Allow time for settle
-void set_cs(uint8_t pin, uint8_t level) {
-    vTaskDelay(pdMS_TO_TICKS(MS_DELAY_DATA));
-    if(level) {
-        gpio_set_level(pin, 1);
-    } else {
-        gpio_set_level(pin, 0);
+// Swap transport (eg. emulator on a bench without panel). Takes effect for the next transaction;
+// call before Led_driver__Initialize so the new transport gets its setup messages.
+void Led_driver__Set_transport(const led_transport_t *transport) {
+    if (transport) {
+        Transport = transport;
+        invalidate_shadows();
     }
-    vTaskDelay(pdMS_TO_TICKS(MS_DELAY_DATA));
 }
 
-uint16_t add_payload_to_buf(uint8_t * tx_buffer, uint16_t curr_idx, uint16_t payload, uint8_t num_bits_payload) {
-    uint8_t byte1 = (payload >> 8) & 0xFF ;
-    uint8_t byte2 = payload & 0xFF;
+void Led_driver__Get_stats(led_driver_stats_t *stats) {
+    if (stats) {
+        *stats = Stats;
+        // Energy up to now at the present estimate
+        stats->energy_uj += ((uint64_t)Power_uw * (uint64_t)(esp_timer_get_time() - Energy_since_us) + Energy_rem) / 1000000;
+    }
+}
 
-    // Spi__BitBang_Write(CLK_PIN, DATA_PIN, payload, CMD_LEN);
-    if(num_bits_payload <= 8) {
-        curr_idx = insert_bits_MSB_buffer(tx_buffer, curr_idx, byte2, num_bits_payload);
-    } else {
-        curr_idx = insert_bits_MSB_buffer(tx_buffer, curr_idx, byte1, (num_bits_payload - 8));
-        curr_idx = insert_bits_MSB_buffer(tx_buffer, curr_idx, byte2, 8);
+// LED_ORIENT_0/90/180/270, optionally | LED_ORIENT_MIRROR. Applies from the next frame,
+// the blink region (translated with the old orientation) right away.
+void Led_driver__Set_orientation(uint8_t orientation) {
+    view_frame_t view_mask;
+    RAM_image_t RAM_mask;
+
+    Orientation = orientation & (LED_ORIENT_270 | LED_ORIENT_MIRROR);
+
+    portENTER_CRITICAL(&Blink_lock);
+    view_mask = Blink_view_mask;
+    portEXIT_CRITICAL(&Blink_lock);
+    translate_blink_mask(&view_mask, &RAM_mask);
+    portENTER_CRITICAL(&Blink_lock);
+    Blink_mask = RAM_mask;
+    portEXIT_CRITICAL(&Blink_lock);
+}
+
+uint8_t Led_driver__Get_orientation(void) {
+    return Orientation;
+}
+
+// Supply current budget in mA, 0 = no cap. Applies from the next frame.
+void Led_driver__Set_current_budget(uint16_t budget_ma) {
+    Current_budget_ma = budget_ma;
+}
+
+uint16_t Led_driver__Get_current_budget(void) {
+    return Current_budget_ma;
+}
+
+// Bus time the RAM scrubber may use per second (0 stops it)
+void Led_driver__Set_scrub_budget(uint32_t budget_us) {
+    Scrub_budget_us = budget_us;
+}
+
+// Called from the transmit task each time a frame has left the wire (esp_timer us)
+void Led_driver__Set_frame_done_callback(led_frame_done_cb_t callback) {
+    Frame_done_cb = callback;
+}
+
+// Completion time of the last frame on the wire, 0 before the first one
+int64_t Led_driver__Get_frame_done_us(void) {
+    return Frame_done_us;
+}
+
+// Number of the newest frame handed over, matches frame_seq in the done callback once it is shown
+uint32_t Led_driver__Get_frame_seq(void) {
+    return Frame_seq;
+}
+
+// Host simulator for grayscale timing: runs the emulated chips for window_ms and compares
+// each RAM bit's measured on time with the duty its level asks for (level / max level).
+// Only valid with the emulator transport while a grayscale frame is showing.
+int Led_driver__Simulate_gray(uint32_t window_ms, led_gray_report_t *report) {
+    if (!report || Transport != &Led_transport_emulator || !Gray_active) {
+        return -1;
+    }
+
+    Led_emulator__Start_duty_capture();
+    vTaskDelay(pdMS_TO_TICKS(window_ms));
+
+    float total_error = 0;
+    float max_error = 0;
+    uint32_t num_bits = 0;
+
+    for (uint8_t chip = 0; chip < (LED_NUM_PANELS * 2); chip++) {
+        uint8_t panel = chip / 2;
+        uint8_t dev = (chip % 2) ? Panels[panel].cs_blue : Panels[panel].cs_red;
+        for (uint8_t row = 0; row < 24; row++) {
+            for (uint8_t pos = 0; pos < 16; pos++) {
+                uint8_t level = 0;
+                for (uint8_t k = 0; k < VIEW_GRAY_BITS; k++) {
+                    const RAM_image_t *plane = &Frame_wire.planes[k][panel];
+                    uint16_t RAM_row = (chip % 2) ? plane->blue[row] : plane->red[row];
+                    level |= ((RAM_row >> pos) & 1) << k;
+                }
+                float expected = (float)level / (float)VIEW_GRAY_MAX_LEVEL;
+                // Row bit 15 is the first bit of address row*4
+                float measured = Led_emulator__Get_duty(dev, (row * 4) + (3 - (pos / 4)), pos % 4);
+                float error = (measured > expected) ? (measured - expected) : (expected - measured);
+                total_error += error;
+                if (error > max_error) {
+                    max_error = error;
+                }
+                num_bits++;
+            }
+        }
     }
 
-    return curr_idx;
+    report->refresh_hz = Stats.gray_cycle_us ? (1000000.0f / (float)Stats.gray_cycle_us) : 0;
+    report->mean_duty_error = total_error / (float)num_bits;
+    report->max_duty_error = max_error;
+    ESP_LOGI(TAG, "Gray sim: %.1f Hz, duty error mean %.3f max %.3f", report->refresh_hz, report->mean_duty_error, report->max_duty_error);
+    return 0;
+}
+
+// Apply a known good bus clock (eg. calibrated value loaded from NVS)
+void Led_driver__Set_clock_hz(uint32_t clock_hz) {
+    if (clock_hz == 0) {
+        return;
+    }
+    bus_take();
+    Clock_hz = clock_hz;
+    if (Transport && Transport->set_clock_hz) {
+        Transport->set_clock_hz(clock_hz);
+    }
+    bus_give();
+}
+
+uint32_t Led_driver__Get_clock_hz(void) {
+    return Clock_hz;
 }
 
-void send_setup_messages(uint8_t dev) {
+// Step the bus clock up through LED_CLOCK_STEPS_HZ, writing test patterns and reading
+// them back from both chips. Settles on the fastest step where every pass verified
+// (stops at the first failing step). Display is blanked meanwhile and the last frame
+// is rewritten afterwards. Returns 0 and the chosen clock, -1 if the transport cannot
+// read back or even the slowest step failed (clock left unchanged).
+int Led_driver__Calibrate_clock(uint32_t *clock_hz) {
+    static const uint32_t clock_steps_hz[] = LED_CLOCK_STEPS_HZ;
+    uint32_t best_hz = 0;
+
+    if (!Transport || !Transport->read || !Transport->set_clock_hz) {
+        ESP_LOGW(TAG, "No read-back on %s transport, keeping %lu Hz", Transport ? Transport->name : "-", (unsigned long)Clock_hz);
+        return -1;
+    }
+
+    bus_take();
+    flush_commands();
+    send_command_all(LED_OFF);
+
+    // Every chip on the chain shares the bus clock, so the slowest one sets it
+    for (uint8_t step = 0; step < (sizeof(clock_steps_hz) / sizeof(clock_steps_hz[0])); step++) {
+        uint8_t step_ok = 1;
+        Transport->set_clock_hz(clock_steps_hz[step]);
+        for (uint8_t panel = 0; panel < LED_NUM_PANELS && step_ok; panel++) {
+            if (verify_clock(Panels[panel].cs_red) != 0 || verify_clock(Panels[panel].cs_blue) != 0) {
+                ESP_LOGI(TAG, "Clock %lu Hz failed read-back on panel %u", (unsigned long)clock_steps_hz[step], panel);
+                step_ok = 0;
+            }
+        }
+        if (!step_ok) {
+            break;
+        }
+        best_hz = clock_steps_hz[step];
+    }
+
+    if (best_hz > 0) {
+        Clock_hz = best_hz;
+    }
+    Transport->set_clock_hz(Clock_hz);
+
+    // Chips hold test patterns now: full rewrite of the last frame
+    invalidate_shadows();
+    write_plane(Gray_plane);
+    if (Led_state) {
+        send_command_all(LED_ON);
+    }
+    bus_give();
+
+    if (best_hz == 0) {
+        ESP_LOGE(TAG, "Clock calibration failed, keeping %lu Hz", (unsigned long)Clock_hz);
+        return -1;
+    }
+
+    ESP_LOGI(TAG, "Clock calibrated: %lu Hz", (unsigned long)Clock_hz);
+    if (clock_hz) {
+        *clock_hz = Clock_hz;
+    }
+    return 0;
+}
+
+
+// PRIVATE METHODS
+
+// sync_mode: SET_MASTER or SET_SLAVE
+void send_setup_messages(uint8_t dev, uint8_t sync_mode) {
     // Number of data bits in buffer = 3 + (9 * 6) = 57. Round up to nearest 8bits = 64 = 8bytes
     uint8_t tx_buffer[8];
-    uint16_t current_idx;
-    uint16_t num_bits_buffer;
-    memset(&tx_buffer, 0, sizeof(tx_buffer));
-
-    uint8_t len_buffer_bits = 64;
-    current_idx = len_buffer_bits - 1;
-    
-    // Assemble buffer
-    current_idx = add_payload_to_buf(tx_buffer, current_idx, CMD_MODE, 3);
-    num_bits_buffer = 3;    // CMD_MODE is 3 bits
-
-    current_idx = add_payload_to_buf(tx_buffer, current_idx, ((uint16_t)(SYS_DIS << 1)), 9);
-    current_idx = add_payload_to_buf(tx_buffer, current_idx, ((uint16_t)(COM_OPTION << 1)), 9);
-    if(dev == CS_RED) {
-        current_idx = add_payload_to_buf(tx_buffer, current_idx, ((uint16_t)(SET_MASTER << 1)), 9);
-    } else {
-        current_idx = add_payload_to_buf(tx_buffer, current_idx, ((uint16_t)(SET_SLAVE << 1)), 9);
-    }
-    current_idx = add_payload_to_buf(tx_buffer, current_idx, ((uint16_t)(SYS_ON << 1)), 9);
-    current_idx = add_payload_to_buf(tx_buffer, current_idx, ((uint16_t)(PWM_DUTY << 1)), 9);
-    current_idx = add_payload_to_buf(tx_buffer, current_idx, ((uint16_t)(LED_ON << 1)), 9);
-    num_bits_buffer += (6 * 9);
+    bit_writer_t writer;
+    bits_begin(&writer, tx_buffer);
+
+    // Assemble buffer: CMD_MODE is 3 bits, each command 9 bits (extra X bit at LSB)
+    bits_put(&writer, CMD_MODE, 3);
+    bits_put(&writer, (uint16_t)(SYS_DIS << 1), 9);
+    bits_put(&writer, (uint16_t)(COM_OPTION << 1), 9);
+    bits_put(&writer, (uint16_t)(sync_mode << 1), 9);
+    bits_put(&writer, (uint16_t)(SYS_ON << 1), 9);
+    bits_put(&writer, (uint16_t)(PWM_DUTY << 1), 9);
+    bits_put(&writer, (uint16_t)(LED_ON << 1), 9);
+
+    transmit_spi(dev, tx_buffer, bits_end(&writer));
 
-    transmit_spi(dev, tx_buffer, num_bits_buffer);
+    // Contents of chip RAM unknown until the next full write
+    get_shadow(dev)->valid = 0;
 }
 
 void send_single_command(uint8_t cmd, uint8_t dev) {    
     // Number of data bits in buffer = 3 + 9 = 12. Round up nearest 8 bits = 16 = 2bytes
     uint8_t tx_buffer[2];
-    uint16_t current_idx = 0;
-    uint16_t num_bits_buffer = 0;
-    memset(&tx_buffer, 0, sizeof(tx_buffer));
+    bit_writer_t writer;
+    bits_begin(&writer, tx_buffer);
 
-    uint8_t len_buffer_bits = 8 * 2;
-    current_idx = len_buffer_bits - 1;
-    
-    // Assemble buffer
-    current_idx = add_payload_to_buf(tx_buffer, current_idx, CMD_MODE, 3);
-    num_bits_buffer += 3;
+    bits_put(&writer, CMD_MODE, 3);
+    bits_put(&writer, (uint16_t)(cmd << 1), 9);
 
-    add_payload_to_buf(tx_buffer, current_idx, ((uint16_t)(cmd << 1)), 9);
-    num_bits_buffer += 9;
+    transmit_spi(dev, tx_buffer, bits_end(&writer));
+}
+
+// Put a command in its batch slot and wake the transmit task
+void queue_command(uint8_t slot, uint8_t cmd) {
+    batch_command(slot, cmd);
+    send_batch();
+}
 
-    transmit_spi(dev, tx_buffer, num_bits_buffer);
+// Wake the transmit task for the batch, or send it right away before the task exists
+void send_batch(void) {
+    if (Transmit_task_handle) {
+        xTaskNotify(Transmit_task_handle, NOTIFY_COMMAND, eSetBits);
+    } else {
+        bus_take();
+        flush_commands();
+        bus_give();
+    }
 }
 
-void update_RAM(uint8_t dev, uint16_t *RAM_mem) {
-    // Total num bits = ( 24 rows * 4 addr/row  * 4 bits/addr) + 10 mode bits = 394 bits
-    // Round up nearest 8 bits = 400 = 50bytes
-    uint8_t tx_buffer[50];
-    uint16_t current_idx;
-    memset(&tx_buffer, 0, sizeof(tx_buffer));
+// New requested brightness, sent capped to the budget of the frame on the chips
+void apply_level(uint8_t level) {
+    batch_level(level);
+    send_batch();
+}
+
+void batch_level(uint8_t level) {
+    Requested_level = level;
+    if (level > Max_level) {
+        level = Max_level;
+    }
+    uint8_t pwm_duty = 0xA0 | level;    // 101X DDDD
+
+    batch_command(COMMAND_PWM, pwm_duty);
+}
 
-    uint16_t len_buffer_bits = 50 * 8;        // Round up nearest 8 bits = 400 (50 bytes)
-    current_idx = len_buffer_bits - 1;  // MSBit of buffer
+void start_fade(uint8_t target, uint32_t duration_ms, uint8_t off_at_end) {
+    esp_timer_stop(Fade_timer);
 
-    // // Asemble buffer
-    // // Insert mode bits
-    current_idx = add_payload_to_buf(tx_buffer, current_idx, SET_WRITE_MODE, SET_WRITE_LEN);
-    // // Insert data bits at appropriate place in buffer
-    // // eg. First iteration: ####-xxxx-xxxx-xxxx. shift 12 right, mask 4 bits
-    for(uint8_t row=0; row<24; row++) {
-        uint16_t data_row = RAM_mem[row];
-        for(uint8_t addr = 4; addr > 0; addr--) {
-            uint8_t shifted_data = data_row >> ((addr - 1) * 4);
-            uint8_t masked_data = shifted_data & 0xF;
-            current_idx = insert_bits_MSB_buffer(tx_buffer, current_idx, masked_data, 4);
+    portENTER_CRITICAL(&Fade_lock);
+    uint8_t from = Requested_level;
+    uint8_t num_steps = (target > from) ? (target - from) : (from - target);
+    uint32_t step_us = num_steps ? (duration_ms * 1000) / num_steps : 0;
+    if (step_us < LED_FADE_MIN_STEP_MS * 1000) {
+        step_us = LED_FADE_MIN_STEP_MS * 1000;
+    }
+    Fade.target = target;
+    Fade.num_steps = num_steps;
+    Fade.step = 0;
+    Fade.off_at_end = off_at_end;
+    Fade.start_us = esp_timer_get_time();
+    Fade.step_us = step_us;
+    Fade.running = (num_steps > 0);
+    portEXIT_CRITICAL(&Fade_lock);
+
+    if (num_steps > 0) {
+        esp_timer_start_once(Fade_timer, step_us);
+    } else if (off_at_end) {
+        finish_fade_off();
+    }
+}
+
+// Stop a running fade where it got to. A fade off does not turn the LED off any more.
+// esp_timer_stop does not wait for a callback already running, running tells it to stop.
+void stop_fade(void) {
+    portENTER_CRITICAL(&Fade_lock);
+    Fade.running = 0;
+    Fade.off_at_end = 0;
+    portEXIT_CRITICAL(&Fade_lock);
+    esp_timer_stop(Fade_timer);
+}
+
+// Fade off reached level 0: LED off, unless it was turned around or stopped meanwhile (the
+// timer callback may already be running when the fade is stopped)
+void finish_fade_off(void) {
+    portENTER_CRITICAL(&Fade_lock);
+    uint8_t off = Fade.off_at_end;
+    if (off) {
+        Fade.off_at_end = 0;
+        Led_state = 0;
+        batch_command(COMMAND_LED, LED_OFF);
+    }
+    portEXIT_CRITICAL(&Fade_lock);
+
+    if (off) {
+        send_batch();
+    }
+}
+
+// esp_timer task context: one level toward the target, then arm the next step at its
+// scheduled time
+void fade_timer_callback(void *arg) {
+    int64_t now_us = esp_timer_get_time();
+
+    // Step and level change in one go: a stop or new level that comes after wins
+    portENTER_CRITICAL(&Fade_lock);
+    if (!Fade.running) {
+        portEXIT_CRITICAL(&Fade_lock);
+        return;
+    }
+    Fade.step++;
+    uint8_t level = Requested_level;
+    if (level < Fade.target) {
+        level++;
+    } else if (level > Fade.target) {
+        level--;
+    }
+    batch_level(level);
+    if (Fade.step >= Fade.num_steps) {
+        Fade.running = 0;
+    }
+    fade_t fade = Fade;
+    portEXIT_CRITICAL(&Fade_lock);
+    send_batch();
+
+    int64_t late_us = now_us - (fade.start_us + (int64_t)fade.step * fade.step_us);
+    if (late_us > (int64_t)Stats.fade_max_late_us) {
+        Stats.fade_max_late_us = (uint32_t)late_us;
+    }
+    Stats.num_fade_steps++;
+
+    if (fade.running) {
+        int64_t next_us = fade.start_us + (int64_t)(fade.step + 1) * fade.step_us - esp_timer_get_time();
+        esp_timer_start_once(Fade_timer, (next_us > 0) ? (uint64_t)next_us : 0);
+    } else if (fade.off_at_end) {
+        finish_fade_off();
+    }
+}
+
+// Put a command in its batch slot for the next flush_commands
+void batch_command(uint8_t slot, uint8_t cmd) {
+    portENTER_CRITICAL(&Command_lock);
+    if (Command_batch.pending & slot) {
+        Stats.num_commands_coalesced++;
+    }
+    if (slot == COMMAND_PWM) {
+        Command_batch.pwm_duty = cmd;
+    } else if (slot == COMMAND_BLINK) {
+        Command_batch.blink = cmd;
+    } else {
+        Command_batch.led = cmd;
+    }
+    Command_batch.pending |= slot;
+    Stats.num_commands++;
+    portEXIT_CRITICAL(&Command_lock);
+}
+
+// Send pending commands to every chip, one command mode stream each. Bus must be held.
+void flush_commands(void) {
+    command_batch_t batch;
+    portENTER_CRITICAL(&Command_lock);
+    batch = Command_batch;
+    Command_batch.pending = 0;
+    portEXIT_CRITICAL(&Command_lock);
+
+    if (!batch.pending) {
+        return;
+    }
+
+    // 3 + (9 * COMMAND_MAX) = 30 bits. Round up nearest 8 bits = 32 = 4bytes
+    uint8_t tx_buffer[(3 + (CMD_LEN * COMMAND_MAX) + 7) / 8];
+    bit_writer_t writer;
+    bits_begin(&writer, tx_buffer);
+
+    bits_put(&writer, CMD_MODE, 3);
+    if (batch.pending & COMMAND_PWM) {
+        bits_put(&writer, (uint16_t)(batch.pwm_duty << 1), CMD_LEN);
+    }
+    if (batch.pending & COMMAND_LED) {
+        bits_put(&writer, (uint16_t)(batch.led << 1), CMD_LEN);
+    }
+    if (batch.pending & COMMAND_BLINK) {
+        bits_put(&writer, (uint16_t)(batch.blink << 1), CMD_LEN);
+    }
+    uint16_t num_bits = bits_end(&writer);
+
+    for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        transmit_spi(Panels[panel].cs_red, tx_buffer, num_bits);
+        transmit_spi(Panels[panel].cs_blue, tx_buffer, num_bits);
+        Stats.num_command_streams += 2;
+    }
+
+    if (batch.pending & COMMAND_PWM) {
+        Chip_level = batch.pwm_duty & 0xF;
+    }
+    if (batch.pending & COMMAND_LED) {
+        Chip_led_on = (batch.led == LED_ON);
+    }
+    account_energy();
+}
+
+// Same command to every chip on the chain, queued back to back. Bus must be held.
+void send_command_all(uint8_t cmd) {
+    for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        send_single_command(cmd, Panels[panel].cs_red);
+        send_single_command(cmd, Panels[panel].cs_blue);
+    }
+}
+
+// Send only the addresses that changed since the last write to this chip.
+// Each run of changed nibbles is one write-at-address transaction (101 AAAAAAA DDDD DDDD ...).
+// Short gaps between runs are sent as-is since a new transaction header costs more than
+// rewriting a few unchanged nibbles. Falls back to the full stream when that is cheaper.
+void update_RAM(uint8_t dev, const uint16_t *RAM_mem) {
+    RAM_shadow_t *shadow = get_shadow(dev);
+
+    if(!shadow->valid) {
+        uint8_t tx_buffer[RAM_STREAM_BYTES];
+        transmit_spi(dev, tx_buffer, pack_RAM_stream(tx_buffer, RAM_mem));
+        memcpy(shadow->RAM, RAM_mem, sizeof(shadow->RAM));
+        shadow->valid = 1;
+        return;
+    }
+
+    // Collect runs of dirty addresses [start, end]
+    uint8_t run_start[RAM_NUM_ADDR / 2];
+    uint8_t run_end[RAM_NUM_ADDR / 2];
+    uint8_t num_runs = 0;
+    uint16_t num_bits_total = 0;
+
+    for(uint8_t row = 0; row < 24; row++) {
+        uint16_t diff = RAM_mem[row] ^ shadow->RAM[row];
+        if(diff == 0) {
+            continue;
+        }
+        for(uint8_t nibble = 0; nibble < 4; nibble++) {
+            if(((diff >> (12 - (nibble * 4))) & 0xF) == 0) {
+                continue;
+            }
+            uint8_t addr = (row * 4) + nibble;
+            if(num_runs > 0 && (addr - run_end[num_runs - 1]) <= (RAM_DIFF_MERGE_GAP + 1)) {
+                num_bits_total += (addr - run_end[num_runs - 1]) * WRITE_LEN;
+                run_end[num_runs - 1] = addr;
+            } else {
+                run_start[num_runs] = addr;
+                run_end[num_runs] = addr;
+                num_runs++;
+                num_bits_total += SET_WRITE_LEN + WRITE_LEN;
+            }
+        }
+    }
+
+    if(num_runs == 0) {
+        return;
+    }
+
+    if(num_bits_total >= RAM_STREAM_BITS) {
+        uint8_t tx_buffer[RAM_STREAM_BYTES];
+        transmit_spi(dev, tx_buffer, pack_RAM_stream(tx_buffer, RAM_mem));
+    } else {
+        for(uint8_t run = 0; run < num_runs; run++) {
+            write_RAM_run(dev, RAM_mem, run_start[run], run_end[run]);
         }
     }
-    uint16_t num_bits_buffer = 394;
-    
-    transmit_spi(dev, tx_buffer, num_bits_buffer);
+    memcpy(shadow->RAM, RAM_mem, sizeof(shadow->RAM));
 }
 
-void clear_RAM(uint8_t dev) {
-    // total num bits = ( 24 rows * 4 addr/row  * 4 bits/addr) + 10 mode bits = 394 bits
-    // round up nearest 8 bits = 400 bits = 50bytes
-    uint8_t tx_buffer[50];
-    uint16_t current_idx;
-    uint16_t num_bits_buffer;
+// Write addresses first..last (inclusive) from RAM_mem in one successive write transaction
+void write_RAM_run(uint8_t dev, const uint16_t *RAM_mem, uint8_t first, uint8_t last) {
+    uint8_t tx_buffer[RAM_STREAM_BYTES];
+    bit_writer_t writer;
+    bits_begin(&writer, tx_buffer);
+
+    bits_put(&writer, SET_WRITE_MODE | first, SET_WRITE_LEN);
+    for(uint8_t addr = first; addr <= last; addr++) {
+        uint8_t nibble = (RAM_mem[addr / 4] >> (12 - ((addr % 4) * 4))) & 0xF;
+        bits_put(&writer, nibble, WRITE_LEN);
+    }
 
-    memset(&tx_buffer, 0, sizeof(tx_buffer));
+    transmit_spi(dev, tx_buffer, bits_end(&writer));
+}
+
+RAM_shadow_t *get_shadow(uint8_t dev) {
+    for(uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        if(dev == Panels[panel].cs_red) {
+            return &Shadows[panel][0];
+        }
+        if(dev == Panels[panel].cs_blue) {
+            return &Shadows[panel][1];
+        }
+    }
+    return &Shadows[0][0];
+}
 
-    uint16_t len_buffer_bits = 50 * 8;        // Round up nearest 8 bits = 400 (50 bytes)
-    current_idx = len_buffer_bits - 1;  // MSBit of buffer
+// Chip RAM no longer known (eg. new transport, test patterns): next write is a full one
+void invalidate_shadows(void) {
+    for(uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        Shadows[panel][0].valid = 0;
+        Shadows[panel][1].valid = 0;
+    }
+}
 
-    // Asemble buffer
-    add_payload_to_buf(tx_buffer, current_idx, SET_WRITE_MODE, SET_WRITE_LEN);
-    num_bits_buffer = 394;
+void clear_RAM(uint8_t dev) {
+    static const uint16_t RAM_blank[24] = {0};
+    uint8_t tx_buffer[RAM_STREAM_BYTES];
+    RAM_shadow_t *shadow = get_shadow(dev);
 
-    transmit_spi(dev, tx_buffer, num_bits_buffer);
+    transmit_spi(dev, tx_buffer, pack_RAM_stream(tx_buffer, RAM_blank));
+    memset(shadow->RAM, 0, sizeof(shadow->RAM));
+    shadow->valid = 1;
 }
 
 void transmit_spi(uint8_t dev, uint8_t * tx_buffer, uint16_t num_bits_buffer) {
-    #if USE_SPI_BIT_BANG
-        set_cs(dev, CS_ACTIVE);
-        Spi__BitBang_Write(CLK_PIN, DATA_PIN, tx_buffer, num_bits_buffer);
-        set_cs(dev, CS_INACTIVE);
-    #else
-        if(dev==CS_RED) {
-            Spi__Write(Spi_Handle_Red, tx_buffer, num_bits_buffer);
-        } else {
-            Spi__Write(Spi_Handle_Blue, tx_buffer, num_bits_buffer);
-        }
-    #endif
-}
-
-// Insert data bits into array buffer
-uint16_t insert_bits_MSB_buffer(uint8_t * tx_buffer, uint16_t current_idx, uint8_t data, uint8_t num_bits_data) {
-    // ex scenario: buf[ ] = [0110 01XX] [xxxx xxxx], idx=9, data={101}
-    //              shift data >> 1, insert into 1st byte:
-    //              buf[2] = [0110 0110]
-    //              shift data << 5 = (8-num_bits_data)
-    //              buf[1] = [01xx xxxx]
-
-    // indexes zero based! [7 6 5 4  3 2 1 0]
-    uint8_t current_byte = current_idx / 8;
-    uint8_t curr_idx_in_byte = current_idx % 8;
-    uint8_t empty_bits_byte1 = curr_idx_in_byte + 1;
-
-    if(num_bits_data < empty_bits_byte1) {  // data can fit fully into current byte
-        // shift data left if necessary
-        data <<= (empty_bits_byte1 - num_bits_data);
-        tx_buffer[current_byte] |= data;
-    
-    } else {    // data split between 2 bytes
-        uint8_t shifted_data_first_byte = data >> (num_bits_data - empty_bits_byte1);
-        tx_buffer[current_byte] |= shifted_data_first_byte;
-
-        uint8_t bits_left_in_data = num_bits_data - empty_bits_byte1;
-        uint8_t shifted_data_second_byte = data << (8 - bits_left_in_data);
-        tx_buffer[current_byte - 1] |= shifted_data_second_byte;
-    }
-
-    return (current_idx - num_bits_data);
-}
-
-// view[0]->col 16, view[15]->col 1
-// view index = 16-col
-void translate_views_to_RAM_red(uint16_t *view_red, uint16_t *view_green, uint16_t *ret_RAM_red) {
-    ret_RAM_red[0] = view_green[2];     //col14
-    ret_RAM_red[1] = view_red[3];
-    ret_RAM_red[2] = view_green[3];
-    ret_RAM_red[3] = view_green[4];
-    ret_RAM_red[4] = view_red[5];
-    ret_RAM_red[5] = view_green[1];
-    ret_RAM_red[6] = view_red[1];
-    ret_RAM_red[7] = view_red[0];
-    ret_RAM_red[8] = view_green[5];
-    ret_RAM_red[9] = view_red[6];
-    ret_RAM_red[10] = view_green[6];
-    ret_RAM_red[11] = view_green[7];
-    ret_RAM_red[12] = view_red[8];
-    ret_RAM_red[13] = view_red[9];
-    ret_RAM_red[14] = view_green[9];
-    ret_RAM_red[15] = view_red[10];
-    ret_RAM_red[16] = view_red[11];
-    ret_RAM_red[17] = view_green[11];
-    ret_RAM_red[18] = view_red[12];
-    ret_RAM_red[19] = view_green[12];
-    ret_RAM_red[20] = view_green[13];
-    ret_RAM_red[21] = view_green[15];
-    ret_RAM_red[22] = view_green[14];
-    ret_RAM_red[23] = view_red[15];
-}
-
-void translate_views_to_RAM_blue(uint16_t *view_red, uint16_t *view_green, uint16_t *view_blue, uint16_t *ret_RAM_blue) {
-    ret_RAM_blue[0] = view_green[10];
-    ret_RAM_blue[1] = view_blue[11];
-    ret_RAM_blue[2] = view_blue[12];
-    ret_RAM_blue[3] = view_red[13];
-    ret_RAM_blue[4] = view_blue[13];
-    ret_RAM_blue[5] = view_red[14];
-    ret_RAM_blue[6] = view_blue[14];
-    ret_RAM_blue[7] = view_blue[15];
-    ret_RAM_blue[8] = view_blue[10];
-    ret_RAM_blue[9] = view_blue[9];
-    ret_RAM_blue[10] = view_green[8];
-    ret_RAM_blue[11] = view_blue[8];
-    ret_RAM_blue[12] = view_blue[7];
-    ret_RAM_blue[13] = view_red[7];
-    ret_RAM_blue[14] = view_blue[6];
-    ret_RAM_blue[15] = view_blue[5];
-    ret_RAM_blue[16] = view_red[4];
-    ret_RAM_blue[17] = view_blue[4];
-    ret_RAM_blue[18] = view_blue[3];
-    ret_RAM_blue[19] = view_red[2];
-    ret_RAM_blue[20] = view_blue[2];
-    ret_RAM_blue[21] = view_green[0];
-    ret_RAM_blue[22] = view_blue[1];
-    ret_RAM_blue[23] = view_blue[0];
+    if (Transport == NULL) {
+        return;
+    }
+    Transport->write(dev, tx_buffer, num_bits_buffer);
+    Frame_bytes += (num_bits_buffer + 7) / 8;
+    Frame_bits += num_bits_buffer;
+    Frame_transactions++;
+}
+
+// Swap the translated back frame to the front and wake the transmit task.
+// If the previous front frame has not been picked up yet it is replaced.
+void publish_frame(void) {
+    portENTER_CRITICAL(&Frame_lock);
+    Frame_back->seq = ++Frame_seq;
+    RAM_frame_t *swap = Frame_front;
+    Frame_front = Frame_back;
+    Frame_back = swap;
+    if (Frame_pending) {
+        Stats.num_replaced_frames++;
+    }
+    Frame_pending = 1;
+    portEXIT_CRITICAL(&Frame_lock);
+
+    if (Transmit_task_handle) {
+        xTaskNotify(Transmit_task_handle, NOTIFY_FRAME, eSetBits);
+    }
+}
+
+// Puts new frames on the wire and, in grayscale mode, switches planes when the plane
+// timer expires. Rendering of the next frame carries on meanwhile.
+void transmit_task(void *pvParameters) {
+    while(1) {
+        uint32_t notify_bits = 0;
+        xTaskNotifyWait(0, 0xFFFFFFFF, &notify_bits, portMAX_DELAY);
+
+        if (notify_bits & NOTIFY_FRAME) {
+            take_new_frame();
+        } else if ((notify_bits & NOTIFY_PLANE) && Gray_active) {
+            uint8_t next_plane = (Gray_plane + 1) % VIEW_GRAY_BITS;
+            if (next_plane == 0) {
+                int64_t now_us = esp_timer_get_time();
+                Stats.num_gray_cycles++;
+                Stats.gray_cycle_us = (uint32_t)(now_us - Gray_cycle_start_us);
+                Gray_cycle_start_us = now_us;
+            }
+            bus_take();
+            flush_commands();
+            show_plane(next_plane);
+            bus_give();
+        } else if (notify_bits & NOTIFY_BLINK) {
+            // Rewrite the plane on the chips in the new phase: only masked nibbles differ
+            bus_take();
+            Frame_bits = 0;
+            write_plane(Gray_plane);
+            Stats.num_blink_toggles++;
+            Stats.blink_bits += Frame_bits;
+            bus_give();
+        }
+
+        // Commands with no frame or plane to ride along with
+        if (Command_batch.pending) {
+            bus_take();
+            flush_commands();
+            bus_give();
+        }
+    }
+}
+
+// Take the newest swapped-in frame and queue its changed addresses for every chip.
+// Grayscale frames restart the plane cycle from plane 0.
+void take_new_frame(void) {
+    portENTER_CRITICAL(&Frame_lock);
+    uint8_t has_frame = Frame_pending;
+    if (has_frame) {
+        Frame_wire = *Frame_front;
+        Frame_pending = 0;
+    }
+    portEXIT_CRITICAL(&Frame_lock);
+
+    if (!has_frame) {
+        return;
+    }
+
+    esp_timer_stop(Plane_timer);
+    Gray_active = (Frame_wire.num_planes > 1);
+
+    bus_take();
+    int64_t start_us = esp_timer_get_time();
+    Frame_bytes = 0;
+    Frame_bits = 0;
+    Frame_transactions = 0;
+
+    Gray_cycle_start_us = start_us;
+
+    // Brightness for this frame within the current budget. Dimming goes out ahead of the
+    // new image and brightening after it, so the estimate never exceeds the budget between.
+    // A PWM command still queued was capped for the previous frame: it goes out first, so
+    // it is what the new image has to be compared against.
+    Max_level = max_level_for(Frame_wire.lit_leds);
+    uint8_t level = (Requested_level < Max_level) ? Requested_level : Max_level;
+    if (level < Requested_level) {
+        Stats.num_capped_frames++;
+    }
+    portENTER_CRITICAL(&Command_lock);
+    uint8_t first_level = (Command_batch.pending & COMMAND_PWM) ? (Command_batch.pwm_duty & 0xF) : Chip_level;
+    portEXIT_CRITICAL(&Command_lock);
+    if (level < first_level) {
+        batch_command(COMMAND_PWM, PWM_DUTY | level);
+    }
+    flush_commands();
+    show_plane(0);
+    Stats.lit_leds = Frame_wire.lit_leds;
+    account_energy();
+    if (level > Chip_level) {
+        batch_command(COMMAND_PWM, PWM_DUTY | level);
+        flush_commands();
+    }
+
+    int64_t done_us = bus_give();
+    record_frame_stats((uint32_t)((done_us - start_us) * 1000));
+    Frame_done_us = done_us;
+
+    if (Frame_done_cb) {
+        Frame_done_cb(done_us, Frame_wire.seq);
+    }
+}
+
+// Write plane to every chip (differential), then arm the timer for its weight. Bus must be held.
+// All panels are queued back to back, the transport flushes once when the bus is given back.
+void show_plane(uint8_t plane) {
+    Gray_plane = plane;
+    write_plane(plane);
+
+    if (Gray_active) {
+        Stats.num_planes_shown++;
+        esp_timer_start_once(Plane_timer, (uint64_t)LED_GRAY_BASE_US << plane);
+    }
+}
+
+// Differential write of Frame_wire's plane to every chip, from the dark bank while a
+// region blink is in its off half. Bus must be held.
+void write_plane(uint8_t plane) {
+    RAM_image_t mask;
+    RAM_image_t dark;
+
+    portENTER_CRITICAL(&Blink_lock);
+    uint8_t is_dark = Blink_dark;
+    if (is_dark) {
+        mask = Blink_mask;
+    }
+    portEXIT_CRITICAL(&Blink_lock);
+
+    for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        const RAM_image_t *image = &Frame_wire.planes[plane][panel];
+        if (is_dark) {
+            for (uint8_t row = 0; row < 24; row++) {
+                dark.red[row] = image->red[row] & ~mask.red[row];
+                dark.blue[row] = image->blue[row] & ~mask.blue[row];
+            }
+            image = &dark;
+        }
+        update_RAM(Panels[panel].cs_red, image->red);
+        update_RAM(Panels[panel].cs_blue, image->blue);
+    }
+}
+
+// esp_timer task context: hand the plane switch to the transmit task
+void plane_timer_callback(void *arg) {
+    if (Transmit_task_handle) {
+        xTaskNotify(Transmit_task_handle, NOTIFY_PLANE, eSetBits);
+    }
+}
+
+// Chip RAM bits of the pixels set in mask, any channel, at the current orientation
+void translate_blink_mask(const view_frame_t *mask, RAM_image_t *RAM_mask) {
+    view_frame_t any_channel;
+    for (uint8_t row = 0; row < 16; row++) {
+        uint16_t bits = mask->red[row] | mask->green[row] | mask->blue[row];
+        any_channel.red[row] = bits;
+        any_channel.green[row] = bits;
+        any_channel.blue[row] = bits;
+    }
+    translate_view_to_RAM(&any_channel, RAM_mask);
+}
+
+// esp_timer task context: flip the region blink phase, the transmit task writes it
+void blink_timer_callback(void *arg) {
+    portENTER_CRITICAL(&Blink_lock);
+    Blink_dark = !Blink_dark;
+    portEXIT_CRITICAL(&Blink_lock);
+
+    if (Transmit_task_handle) {
+        xTaskNotify(Transmit_task_handle, NOTIFY_BLINK, eSetBits);
+    }
+}
+
+void bus_take(void) {
+    if (Bus_mutex) {
+        xSemaphoreTake(Bus_mutex, portMAX_DELAY);
+    }
+}
+
+// Wait for queued writes and release the bus. Returns completion time (esp_timer us).
+int64_t bus_give(void) {
+    int64_t done_us = 0;
+    if (Transport && Transport->flush) {
+        done_us = Transport->flush();
+    }
+    if (done_us == 0) {
+        done_us = esp_timer_get_time();
+    }
+    if (Bus_mutex) {
+        xSemaphoreGive(Bus_mutex);
+    }
+    return done_us;
+}
+
+// Write LED_CLOCK_VERIFY_PASSES patterns to all addresses and read each one back.
+// Goes straight to the transport so frame stats are not touched. Bus must be held.
+int verify_clock(uint8_t dev) {
+    uint16_t pattern[24];
+    uint8_t tx_buffer[RAM_STREAM_BYTES];
+    uint8_t rx_nibbles[RAM_NUM_ADDR];
+    bit_writer_t writer;
+
+    for (uint8_t pass = 0; pass < LED_CLOCK_VERIFY_PASSES; pass++) {
+        for (uint8_t row = 0; row < 24; row++) {
+            pattern[row] = 0xA55A ^ (row * 0x0F1F) ^ (pass * 0x3C3C);
+        }
+        Transport->write(dev, tx_buffer, pack_RAM_stream(tx_buffer, pattern));
+        if (Transport->flush) {
+            Transport->flush();
+        }
+
+        bits_begin(&writer, tx_buffer);
+        bits_put(&writer, SET_READ_MODE, SET_WRITE_LEN);     // 110, address 0
+        if (Transport->read(dev, tx_buffer, bits_end(&writer), rx_nibbles, RAM_NUM_ADDR) != 0) {
+            return -1;
+        }
+
+        for (uint8_t addr = 0; addr < RAM_NUM_ADDR; addr++) {
+            uint8_t expected = (pattern[addr / 4] >> (12 - ((addr % 4) * 4))) & 0xF;
+            if (rx_nibbles[addr] != expected) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Walks every chip's RAM one window at a time, comparing it with the shadow. Each period adds
+// its share of the budget as credit; a window is only read when the credit covers its cost,
+// so small budgets still make progress, just less often.
+void scrub_task(void *pvParameters) {
+    uint8_t chip = 0;           // panel * 2 + (0: red, 1: blue)
+    uint8_t addr = 0;
+    int64_t credit_us = 0;
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while(1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(LED_SCRUB_PERIOD_MS));
+
+        // Planes alternate on the chips in grayscale mode, a read would stretch plane timing
+        if (Scrub_budget_us == 0 || Gray_active || !Transport || !Transport->read) {
+            credit_us = 0;
+            continue;
+        }
+
+        int64_t period_us = (int64_t)Scrub_budget_us * LED_SCRUB_PERIOD_MS / 1000;
+        // Read: 10 header bits + 4 bits per address
+        int64_t window_us = (int64_t)(SET_WRITE_LEN + (WRITE_LEN * LED_SCRUB_WINDOW_ADDR)) * 1000000 / Clock_hz;
+        if (window_us < 1) {
+            window_us = 1;
+        }
+        credit_us += period_us;
+        if (credit_us > period_us + window_us) {
+            credit_us = period_us + window_us;
+        }
+
+        // At most one pass over every chip per period, whatever the budget
+        uint16_t num_windows = 0;
+        while (credit_us >= window_us && num_windows < SCRUB_WINDOWS_PER_PASS) {
+            num_windows++;
+            uint8_t panel = chip / 2;
+            uint8_t dev = (chip % 2) ? Panels[panel].cs_blue : Panels[panel].cs_red;
+
+            bus_take();
+            int64_t start_us = esp_timer_get_time();
+            int repaired = scrub_window(dev, addr, LED_SCRUB_WINDOW_ADDR);
+            int64_t done_us = bus_give();
+
+            // Charge at least the wire time of the read, in case the transport reports less
+            int64_t used_us = done_us - start_us;
+            if (used_us < window_us) {
+                used_us = window_us;
+            }
+            credit_us -= used_us;
+            Stats.scrub_bus_us += used_us;
+            if (repaired < 0) {
+                ESP_LOGW(TAG, "Scrub read failed on chip %u", chip);
+                break;
+            }
+            Stats.num_scrub_windows++;
+            if (repaired > 0) {
+                Stats.num_scrub_repairs += repaired;
+                ESP_LOGW(TAG, "Scrub repaired %d nibble(s) on chip %u at %u", repaired, chip, addr);
+            }
+
+            addr += LED_SCRUB_WINDOW_ADDR;
+            if (addr >= RAM_NUM_ADDR) {
+                addr = 0;
+                chip = (chip + 1) % (LED_NUM_PANELS * 2);
+                if (chip == 0) {
+                    Stats.num_scrub_passes++;
+                }
+            }
+        }
+    }
+}
+
+// Read back num_addr addresses from first and rewrite each run that differs from the shadow.
+// Returns nibbles repaired (0 if the chip has no known content yet), -1 if the read failed.
+// Bus must be held.
+int scrub_window(uint8_t dev, uint8_t first, uint8_t num_addr) {
+    RAM_shadow_t *shadow = get_shadow(dev);
+    uint8_t tx_buffer[2];
+    uint8_t rx_nibbles[RAM_NUM_ADDR];
+    bit_writer_t writer;
+
+    if (!shadow->valid) {
+        return 0;
+    }
+    if (first + num_addr > RAM_NUM_ADDR) {
+        num_addr = RAM_NUM_ADDR - first;
+    }
+
+    bits_begin(&writer, tx_buffer);
+    bits_put(&writer, SET_READ_MODE | first, SET_WRITE_LEN);
+    if (Transport->read(dev, tx_buffer, bits_end(&writer), rx_nibbles, num_addr) != 0) {
+        return -1;
+    }
+
+    int repaired = 0;
+    int16_t run_start = -1;
+    for (uint8_t i = 0; i <= num_addr; i++) {
+        uint8_t corrupt = 0;
+        if (i < num_addr) {
+            uint8_t addr = first + i;
+            uint8_t expected = (shadow->RAM[addr / 4] >> (12 - ((addr % 4) * 4))) & 0xF;
+            corrupt = (rx_nibbles[i] != expected);
+        }
+        if (corrupt) {
+            repaired++;
+            if (run_start < 0) {
+                run_start = first + i;
+            }
+        } else if (run_start >= 0) {
+            write_RAM_run(dev, shadow->RAM, (uint8_t)run_start, first + i - 1);
+            run_start = -1;
+        }
+    }
+    return repaired;
+}
+
+// Highest PWM level (0-15) that keeps lit_leds within Current_budget_ma. Level 0 even if over.
+uint8_t max_level_for(uint16_t lit_leds) {
+    if (Current_budget_ma == 0 || lit_leds == 0) {
+        return 15;
+    }
+    // (level + 1) / 16 * lit_leds * LED_CURRENT_PER_LED_UA <= budget
+    uint32_t steps = ((uint32_t)Current_budget_ma * 1000 * 16) / ((uint32_t)lit_leds * LED_CURRENT_PER_LED_UA);
+    if (steps == 0) {
+        return 0;
+    }
+    return (steps > 16) ? 15 : (uint8_t)(steps - 1);
+}
+
+// Close the energy interval at the old estimate and start one at the state now on the chips.
+// Transmit task (or bus holder) only.
+void account_energy(void) {
+    int64_t now_us = esp_timer_get_time();
+    uint64_t energy = (uint64_t)Power_uw * (uint64_t)(now_us - Energy_since_us) + Energy_rem;
+    Stats.energy_uj += energy / 1000000;
+    Energy_rem = energy % 1000000;
+    Energy_since_us = now_us;
+
+    uint32_t current_ua = 0;
+    if (Chip_led_on) {
+        current_ua = ((uint32_t)Stats.lit_leds * LED_CURRENT_PER_LED_UA * (Chip_level + 1)) / 16;
+    }
+    Power_uw = (uint32_t)(((uint64_t)current_ua * LED_SUPPLY_MV) / 1000);
+    Stats.pwm_level = Chip_level;
+    Stats.current_ma = current_ua / 1000;
+    if (Stats.current_ma > Stats.peak_current_ma) {
+        Stats.peak_current_ma = Stats.current_ma;
+    }
+}
+
+// Lit LEDs of a frame (set bits over red, green and blue). SWAR popcount: bits are summed
+// into per-byte counts two rows at a time, bytes are added across words (at most 8 each,
+// so 24 words cannot overflow a byte) and folded into halfwords once at the end.
+uint16_t count_lit(const view_frame_t *frame) {
+    const uint16_t *channels[3] = {frame->red, frame->green, frame->blue};
+    uint32_t byte_counts = 0;
+
+    for (uint8_t channel = 0; channel < 3; channel++) {
+        const uint16_t *rows = channels[channel];
+        for (uint8_t row = 0; row < 16; row += 2) {
+            uint32_t x = ((uint32_t)rows[row] << 16) | rows[row + 1];
+            x = x - ((x >> 1) & 0x55555555);
+            x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+            byte_counts += (x + (x >> 4)) & 0x0F0F0F0F;
+        }
+    }
+    byte_counts = (byte_counts & 0x00FF00FF) + ((byte_counts >> 8) & 0x00FF00FF);
+    return (uint16_t)((byte_counts + (byte_counts >> 16)) & 0xFFFF);
+}
+
+void record_frame_stats(uint32_t frame_ns) {
+    Stats.num_frames++;
+    Stats.last_frame_ns = frame_ns;
+    if (frame_ns > Stats.max_frame_ns) {
+        Stats.max_frame_ns = frame_ns;
+    }
+    Total_frame_ns += frame_ns;
+    Stats.avg_frame_ns = (uint32_t)(Total_frame_ns / Stats.num_frames);
+    Stats.bytes_per_frame = Frame_bytes;
+    Stats.bits_per_frame = Frame_bits;
+    Stats.transactions_per_frame = Frame_transactions;
+    if (Frame_transactions == 0) {
+        Stats.num_skipped_frames++;
+    }
+    Total_bits += Frame_bits;
+    Stats.avg_bits_per_frame = (uint32_t)(Total_bits / Stats.num_frames);
+}
+
+#if LED_TRANSPORT == LED_TRANSPORT_SPI
+static void spi_transport_init(void) {
+    Spi__Init_bus(DATA_PIN, CLK_PIN);
+    for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        Spi_handles[panel][0] = Spi__Add_device(SPI_MODE, Panels[panel].cs_red);
+        Spi_handles[panel][1] = Spi__Add_device(SPI_MODE, Panels[panel].cs_blue);
+    }
+#if RD_PIN >= 0
+    gpio_reset_pin(RD_PIN);
+    gpio_set_direction(RD_PIN, GPIO_MODE_OUTPUT);
+    gpio_set_level(RD_PIN, 1);
+#endif
+}
+
+static void spi_transport_set_clock(uint32_t clock_hz) {
+    for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        Spi_handles[panel][0] = Spi__Set_clock_hz(Spi_handles[panel][0], SPI_MODE, Panels[panel].cs_red, clock_hz);
+        Spi_handles[panel][1] = Spi__Set_clock_hz(Spi_handles[panel][1], SPI_MODE, Panels[panel].cs_blue, clock_hz);
+    }
+}
+
+static spi_device_handle_t get_spi_handle(uint8_t dev) {
+    for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        if (dev == Panels[panel].cs_red) {
+            return Spi_handles[panel][0];
+        }
+        if (dev == Panels[panel].cs_blue) {
+            return Spi_handles[panel][1];
+        }
+    }
+    return Spi_handles[0][0];
+}
+
+#if RD_PIN >= 0
+static int spi_transport_read(uint8_t dev, uint8_t *tx_buffer, uint16_t num_bits_buffer, uint8_t *rx_nibbles, uint8_t num_nibbles) {
+    return Spi__Read(get_spi_handle(dev), DATA_PIN, RD_PIN, tx_buffer, num_bits_buffer, rx_nibbles, num_nibbles);
+}
+#endif
+
+static void spi_transport_write(uint8_t dev, uint8_t * tx_buffer, uint16_t num_bits_buffer) {
+    Spi__Queue_write(get_spi_handle(dev), tx_buffer, num_bits_buffer);
+}
+
+#elif LED_TRANSPORT == LED_TRANSPORT_BIT_BANG
+static void bit_bang_transport_init(void) {
+    for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        Bit_bang__Setup_cs(Panels[panel].cs_red);
+        Bit_bang__Setup_cs(Panels[panel].cs_blue);
+    }
+    Bit_bang__Setup(CLK_PIN, DATA_PIN);
+}
+
+static void bit_bang_transport_write(uint8_t dev, uint8_t * tx_buffer, uint16_t num_bits_buffer) {
+    Bit_bang__Set_cs(dev, CS_ACTIVE);
+    Bit_bang__Write(CLK_PIN, DATA_PIN, tx_buffer, num_bits_buffer);
+    Bit_bang__Set_cs(dev, CS_INACTIVE);
+}
+
+// Half a clock period each for setup (clk low) and hold (clk high)
+static void bit_bang_transport_set_clock(uint32_t clock_hz) {
+    bit_bang_timing_t timing = {
+        .setup_ns = 500000000UL / clock_hz,
+        .hold_ns = 500000000UL / clock_hz,
+        .cs_setup_ns = BIT_BANG_CS_SETUP_NS,
+        .cs_hold_ns = BIT_BANG_CS_HOLD_NS,
+    };
+    Bit_bang__Set_timing(&timing);
+}
+#endif
+
+// Build the write mode stream for all 96 addresses, bytes in wire order.
+// Each RAM row is 4 successive addresses, MSB nibble first, so the data section is just
+// the 24 rows back to back. The 10 bit header leaves every row 2 bits into a byte:
+// emit byte 0 from the header, then shift 4 rows (64 bits) at a time right by 2, carrying
+// the 2 bits that spill into the next word.
+uint16_t pack_RAM_stream(uint8_t *tx_buffer, const uint16_t *RAM_mem) {
+    uint8_t *out = tx_buffer;
+    *out++ = (uint8_t)(SET_WRITE_MODE >> 2);        // 101A AAAA (address 0)
+    uint64_t carry = SET_WRITE_MODE & 0x3;          // Last 2 address bits
+
+    for(uint8_t row = 0; row < 24; row += 4) {
+        uint64_t word = ((uint64_t)RAM_mem[row] << 48) | ((uint64_t)RAM_mem[row + 1] << 32) |
+                        ((uint64_t)RAM_mem[row + 2] << 16) | (uint64_t)RAM_mem[row + 3];
+        uint64_t shifted = (carry << 62) | (word >> 2);
+        carry = word & 0x3;
+
+        out[0] = (uint8_t)(shifted >> 56);
+        out[1] = (uint8_t)(shifted >> 48);
+        out[2] = (uint8_t)(shifted >> 40);
+        out[3] = (uint8_t)(shifted >> 32);
+        out[4] = (uint8_t)(shifted >> 24);
+        out[5] = (uint8_t)(shifted >> 16);
+        out[6] = (uint8_t)(shifted >> 8);
+        out[7] = (uint8_t)shifted;
+        out += 8;
+    }
+    *out = (uint8_t)(carry << 6);
+
+    return RAM_STREAM_BITS;
+}
+
+static inline void bits_begin(bit_writer_t *writer, uint8_t *buf) {
+    writer->buf = buf;
+    writer->acc = 0;
+    writer->acc_bits = 0;
+    writer->num_bits = 0;
+}
+
+// Append the low num_bits (<= 16) of value, MSB first
+static inline void bits_put(bit_writer_t *writer, uint16_t value, uint8_t num_bits) {
+    writer->acc = (writer->acc << num_bits) | (value & ((1UL << num_bits) - 1));
+    writer->acc_bits += num_bits;
+    writer->num_bits += num_bits;
+    while(writer->acc_bits >= 8) {
+        writer->acc_bits -= 8;
+        *writer->buf++ = (uint8_t)(writer->acc >> writer->acc_bits);
+    }
+}
+
+// Flush partial byte (left aligned), return number of stream bits
+static inline uint16_t bits_end(bit_writer_t *writer) {
+    if(writer->acc_bits > 0) {
+        *writer->buf++ = (uint8_t)(writer->acc << (8 - writer->acc_bits));
+        writer->acc_bits = 0;
+    }
+    return writer->num_bits;
+}
+
+// Gather view lines into both chips' RAM rows, expanded from the wiring table (panel_wiring.h)
+void translate_view_to_RAM(const view_frame_t *frame, RAM_image_t *RAM) {
+    view_frame_t oriented;
+    uint8_t orientation = Orientation;
+    if (orientation != LED_ORIENT_0) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        orient_frame(frame, &oriented, orientation);
+        uint32_t cycles = (uint32_t)(esp_cpu_get_cycle_count() - start);
+        if (cycles > Stats.orient_max_cycles) {
+            Stats.orient_max_cycles = cycles;
+        }
+        if (cycles > LED_ORIENT_CYCLE_BUDGET) {
+            Stats.num_orient_over_budget++;
+        }
+        frame = &oriented;
+    }
+
+#define GATHER_RED(ram_row, plane, view_idx)    RAM->red[ram_row] = PANEL_ROW_BITS(frame->plane[PANEL_VIEW_IDX(view_idx)]);
+#define GATHER_BLUE(ram_row, plane, view_idx)   RAM->blue[ram_row] = PANEL_ROW_BITS(frame->plane[PANEL_VIEW_IDX(view_idx)]);
+    PANEL_WIRING_RED(GATHER_RED)
+    PANEL_WIRING_BLUE(GATHER_BLUE)
+#undef GATHER_RED
+#undef GATHER_BLUE
+}
+
+// Every quarter turn and mirror is a combination of transpose, row reverse (H) and
+// row order reverse (V): 90 = H(T), 180 = V(H), 270 = V(T), mirror toggles H
+void orient_frame(const view_frame_t *in, view_frame_t *out, uint8_t orientation) {
+    static const uint8_t turn_transpose[4] = {0, 1, 0, 1};
+    static const uint8_t turn_flip_h[4] = {0, 1, 1, 0};
+    static const uint8_t turn_flip_v[4] = {0, 0, 1, 1};
+    uint8_t turn = orientation & LED_ORIENT_270;
+    uint8_t transpose = turn_transpose[turn];
+    uint8_t flip_h = turn_flip_h[turn] ^ ((orientation & LED_ORIENT_MIRROR) ? 1 : 0);
+    uint8_t flip_v = turn_flip_v[turn];
+
+    orient_rows(in->red, out->red, transpose, flip_h, flip_v);
+    orient_rows(in->green, out->green, transpose, flip_h, flip_v);
+    orient_rows(in->blue, out->blue, transpose, flip_h, flip_v);
+}
+
+void orient_rows(const uint16_t *in, uint16_t *out, uint8_t transpose, uint8_t flip_h, uint8_t flip_v) {
+    uint16_t rows[16];
+    memcpy(rows, in, sizeof(rows));
+    if (transpose) {
+        transpose_16x16(rows);
+    }
+    for (uint8_t row = 0; row < 16; row++) {
+        uint16_t bits = rows[flip_v ? (15 - row) : row];
+        out[row] = flip_h ? reverse_bits_16(bits) : bits;
+    }
+}
+
+// In place: bit c of row r <-> bit r of row c. Swaps off-diagonal blocks of 8, then 4, 2, 1:
+// the upper half bits of row k trade places with the lower half bits of row k + j, 16/j
+// pixels per operation.
+static inline void transpose_16x16(uint16_t *rows) {
+    uint16_t mask = 0x00FF;
+    for (uint8_t j = 8; j != 0; j >>= 1, mask ^= (uint16_t)(mask << j)) {
+        for (uint8_t k = 0; k < 16; k = ((k | j) + 1) & ~j) {
+            uint16_t t = ((rows[k] >> j) ^ rows[k | j]) & mask;
+            rows[k | j] ^= t;
+            rows[k] ^= (uint16_t)(t << j);
+        }
+    }
 }
\ No newline at end of file
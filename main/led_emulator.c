@@ -0,0 +1,259 @@
+/* Emulated HT1632 LED driver pair.
+    Decodes the same bitstreams the real chips receive (command mode, write mode)
+    into a RAM image per chip select, so the packing path can be exercised and timed
+    without a board. No ESP driver dependencies (only esp_timer) so it also builds for host.
+
+    Duty capture integrates how long every RAM bit has been on, to check grayscale
+    (bit-plane) timing the way the eye would see it.
+*/
+
+#include <string.h>
+#include "esp_timer.h"
+
+#include "led_emulator.h"
+
+// PRIVATE variables
+static led_emulator_chip_t Chips[LED_EMULATOR_MAX_CHIPS];
+static uint32_t Clock_hz;
+static uint32_t Error_clock_hz = LED_EMULATOR_ERROR_CLOCK_HZ;
+static uint32_t Error_seed = 1;
+
+// Duty capture: on time per RAM bit since Led_emulator__Start_duty_capture
+static uint64_t On_time_us[LED_EMULATOR_MAX_CHIPS][LED_EMULATOR_RAM_NIBBLES * 4];
+static int64_t Last_change_us[LED_EMULATOR_MAX_CHIPS];
+static int64_t Capture_start_us;
+static uint8_t Capture_on;
+
+// PRIVATE method prototypes
+static led_emulator_chip_t *get_chip(uint8_t cs_pin);
+static uint16_t read_bits(const uint8_t *tx_buffer, uint16_t *bit_pos, uint8_t count);
+static void apply_command(led_emulator_chip_t *chip, uint8_t cmd);
+static void integrate_duty(led_emulator_chip_t *chip, int64_t now_us);
+
+const led_transport_t Led_transport_emulator = {
+    .name = "emulator",
+    .init = Led_emulator__Reset,
+    .write = Led_emulator__Write,
+    .set_clock_hz = Led_emulator__Set_clock_hz,
+    .read = Led_emulator__Read,
+};
+
+// PUBLIC methods
+
+void Led_emulator__Reset(void) {
+    memset(Chips, 0, sizeof(Chips));
+}
+
+// Decode one transaction (CS low -> CS high) for the chip at cs_pin
+void Led_emulator__Write(uint8_t cs_pin, uint8_t *tx_buffer, uint16_t num_bits) {
+    led_emulator_chip_t *chip = get_chip(cs_pin);
+    if (!chip || num_bits < 3) {
+        return;
+    }
+
+    uint16_t bit_pos = 0;
+    uint8_t corrupted[64];
+
+    chip->num_transactions++;
+    chip->num_bits += num_bits;
+
+    // Too fast for the chip: flip one bit past the mode bits
+    if (Error_clock_hz > 0 && Clock_hz > Error_clock_hz && num_bits > 3 && ((num_bits + 7) / 8) <= sizeof(corrupted)) {
+        memcpy(corrupted, tx_buffer, (num_bits + 7) / 8);
+        Error_seed = (Error_seed * 1103515245) + 12345;
+        uint16_t pos = 3 + ((Error_seed >> 16) % (num_bits - 3));
+        corrupted[pos / 8] ^= (0x80 >> (pos % 8));
+        tx_buffer = corrupted;
+        chip->num_injected++;
+    }
+
+    integrate_duty(chip, esp_timer_get_time());
+
+    uint8_t mode = read_bits(tx_buffer, &bit_pos, 3);
+    if (mode == LED_EMULATOR_MODE_CMD) {
+        // 100 C7..C0 X, repeated
+        while ((num_bits - bit_pos) >= 9) {
+            uint16_t cmd_bits = read_bits(tx_buffer, &bit_pos, 9);
+            apply_command(chip, (uint8_t)(cmd_bits >> 1));
+        }
+    } else if (mode == LED_EMULATOR_MODE_WRITE) {
+        // 101 A6..A0 D D D D, successive nibbles auto-increment the address
+        if ((num_bits - bit_pos) < 7) {
+            chip->num_errors++;
+            return;
+        }
+        uint8_t addr = read_bits(tx_buffer, &bit_pos, 7);
+        while ((num_bits - bit_pos) >= 4) {
+            chip->ram[addr % LED_EMULATOR_RAM_NIBBLES] = read_bits(tx_buffer, &bit_pos, 4);
+            addr = (addr + 1) % LED_EMULATOR_RAM_NIBBLES;
+        }
+    } else {
+        chip->num_errors++;
+    }
+}
+
+const led_emulator_chip_t *Led_emulator__Get_chip(uint8_t cs_pin) {
+    for (uint8_t i = 0; i < LED_EMULATOR_MAX_CHIPS; i++) {
+        if (Chips[i].in_use && Chips[i].cs_pin == cs_pin) {
+            return &Chips[i];
+        }
+    }
+    return NULL;
+}
+
+// Reassemble RAM image into the driver's row layout (4 nibbles per row, MSB nibble = lowest address)
+void Led_emulator__Get_RAM_rows(uint8_t cs_pin, uint16_t *rows) {
+    const led_emulator_chip_t *chip = Led_emulator__Get_chip(cs_pin);
+    for (uint8_t row = 0; row < LED_EMULATOR_RAM_ROWS; row++) {
+        if (!chip) {
+            rows[row] = 0;
+            continue;
+        }
+        const uint8_t *nib = &chip->ram[row * 4];
+        rows[row] = (uint16_t)((nib[0] << 12) | (nib[1] << 8) | (nib[2] << 4) | nib[3]);
+    }
+}
+
+void Led_emulator__Set_clock_hz(uint32_t clock_hz) {
+    Clock_hz = clock_hz;
+}
+
+void Led_emulator__Set_error_clock_hz(uint32_t clock_hz) {
+    Error_clock_hz = clock_hz;
+}
+
+void Led_emulator__Start_duty_capture(void) {
+    int64_t now_us = esp_timer_get_time();
+    memset(On_time_us, 0, sizeof(On_time_us));
+    for (uint8_t i = 0; i < LED_EMULATOR_MAX_CHIPS; i++) {
+        Last_change_us[i] = now_us;
+        Chips[i].pwm_duty_peak = Chips[i].pwm_duty;
+    }
+    Capture_start_us = now_us;
+    Capture_on = 1;
+}
+
+// Fraction of the capture window (0-1) that bit of addr was on. Bit 3 is the first bit clocked.
+float Led_emulator__Get_duty(uint8_t cs_pin, uint8_t addr, uint8_t bit) {
+    led_emulator_chip_t *chip = get_chip(cs_pin);
+    if (!chip || !Capture_on || addr >= LED_EMULATOR_RAM_NIBBLES || bit > 3) {
+        return 0;
+    }
+    int64_t now_us = esp_timer_get_time();
+    integrate_duty(chip, now_us);
+    if (now_us <= Capture_start_us) {
+        return 0;
+    }
+    uint8_t idx = (uint8_t)(chip - Chips);
+    return (float)On_time_us[idx][(addr * 4) + bit] / (float)(now_us - Capture_start_us);
+}
+
+// READ mode: 110 A6..A0, then the chip shifts out successive nibbles
+int Led_emulator__Read(uint8_t cs_pin, uint8_t *tx_buffer, uint16_t num_bits, uint8_t *rx_nibbles, uint8_t num_nibbles) {
+    led_emulator_chip_t *chip = get_chip(cs_pin);
+    if (!chip || num_bits < 10) {
+        return -1;
+    }
+
+    uint16_t bit_pos = 0;
+    if (read_bits(tx_buffer, &bit_pos, 3) != LED_EMULATOR_MODE_READ) {
+        chip->num_errors++;
+        return -1;
+    }
+    uint8_t addr = read_bits(tx_buffer, &bit_pos, 7);
+    for (uint8_t i = 0; i < num_nibbles; i++) {
+        rx_nibbles[i] = chip->ram[(addr + i) % LED_EMULATOR_RAM_NIBBLES];
+    }
+    chip->num_transactions++;
+    return 0;
+}
+
+// Corrupt chip RAM in place (glitch on the lines while the chip was idle)
+void Led_emulator__Flip_RAM_bit(uint8_t cs_pin, uint8_t addr, uint8_t bit) {
+    led_emulator_chip_t *chip = get_chip(cs_pin);
+    if (!chip || addr >= LED_EMULATOR_RAM_NIBBLES || bit > 3) {
+        return;
+    }
+    integrate_duty(chip, esp_timer_get_time());
+    chip->ram[addr] ^= (1 << bit);
+    chip->num_injected++;
+}
+
+// PRIVATE METHODS
+
+// Find chip registered for cs_pin, or claim a free slot on first use
+static led_emulator_chip_t *get_chip(uint8_t cs_pin) {
+    led_emulator_chip_t *free_slot = NULL;
+    for (uint8_t i = 0; i < LED_EMULATOR_MAX_CHIPS; i++) {
+        if (Chips[i].in_use && Chips[i].cs_pin == cs_pin) {
+            return &Chips[i];
+        }
+        if (!Chips[i].in_use && !free_slot) {
+            free_slot = &Chips[i];
+        }
+    }
+    if (free_slot) {
+        free_slot->in_use = 1;
+        free_slot->cs_pin = cs_pin;
+    }
+    return free_slot;
+}
+
+// Read count bits MSB first, starting at stream bit *bit_pos (wire order)
+static uint16_t read_bits(const uint8_t *tx_buffer, uint16_t *bit_pos, uint8_t count) {
+    uint16_t value = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t pos = *bit_pos;
+        uint8_t byte = tx_buffer[pos / 8];
+        uint8_t bit = (byte >> (7 - (pos % 8))) & 1;
+        value = (value << 1) | bit;
+        (*bit_pos)++;
+    }
+    return value;
+}
+
+// Credit time since the last RAM change to every bit that is on
+static void integrate_duty(led_emulator_chip_t *chip, int64_t now_us) {
+    if (!Capture_on) {
+        return;
+    }
+    uint8_t idx = (uint8_t)(chip - Chips);
+    uint64_t elapsed_us = (uint64_t)(now_us - Last_change_us[idx]);
+    for (uint8_t addr = 0; addr < LED_EMULATOR_RAM_NIBBLES; addr++) {
+        uint8_t nibble = chip->ram[addr];
+        for (uint8_t bit = 0; bit < 4; bit++) {
+            if ((nibble >> bit) & 1) {
+                On_time_us[idx][(addr * 4) + bit] += elapsed_us;
+            }
+        }
+    }
+    Last_change_us[idx] = now_us;
+}
+
+static void apply_command(led_emulator_chip_t *chip, uint8_t cmd) {
+    if ((cmd & 0xF0) == 0xA0) {         // 101X DDDD: PWM duty
+        chip->pwm_duty = cmd & 0x0F;
+        if (chip->pwm_duty > chip->pwm_duty_peak) {
+            chip->pwm_duty_peak = chip->pwm_duty;
+        }
+    } else if ((cmd & 0xF0) == 0x20) {  // 0010 ABXX: COM option
+        chip->com_option = cmd;
+    } else if ((cmd & 0xF8) == 0x18) {  // 0001 10XX: master mode
+        chip->is_master = 1;
+    } else if ((cmd & 0xF8) == 0x10) {  // 0001 0XXX: slave mode
+        chip->is_master = 0;
+    } else if (cmd == 0x00) {           // SYS DIS
+        chip->sys_on = 0;
+        chip->led_on = 0;
+    } else if (cmd == 0x01) {           // SYS ON
+        chip->sys_on = 1;
+    } else if (cmd == 0x02) {           // LED OFF
+        chip->led_on = 0;
+    } else if (cmd == 0x03) {           // LED ON
+        chip->led_on = 1;
+    } else if (cmd == 0x08) {           // BLINK OFF
+        chip->blink_on = 0;
+    } else if (cmd == 0x09) {           // BLINK ON
+        chip->blink_on = 1;
+    }
+}
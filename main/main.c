@@ -27,6 +27,7 @@
 #include "local_time.h"
 #include "provisioning.h"
 #include "provisioning_view.h"
+#include "tasks.h"
 
 #include "esp_tls.h"
 #include "esp_wifi.h"
@@ -46,6 +47,9 @@ TaskHandle_t periodicTaskHandle_server = NULL;
 static void periodic_task_check_server(void *);
 TaskHandle_t periodicTaskHandle_heartbeat = NULL;
 static void periodic_task_heartbeat(void *);
+#if VIEW_PROFILE
+static void publish_render_profile(void);
+#endif
 static void periodic_task_wifi_reconnect(void *);
 static void event_listener_task(void *);  // Handles provisioning button press
 
@@ -53,6 +57,7 @@ static void event_listener_task(void *);  // Handles provisioning button press
 static void startup_wifi(void);
 static void handle_wifi_connection_failure(void);
 static void start_connected_services(void);
+static void setup_led_clock(void);
 static void on_got_ip(void* arg, esp_event_base_t base, int32_t event_id, void* event_data);
 
 // One-time start guard for network-dependent services
@@ -69,6 +74,15 @@ void app_main(void) {
 
     // Initialize device config from NVS first
     Device_Config__Init();
+
+    // LED bus clock: calibrated value from NVS, or calibrate now and store it
+    setup_led_clock();
+
+    // Panel orientation for how this unit is mounted
+    uint8_t led_orientation;
+    if (Device_Config__Get_Led_orientation(&led_orientation) == 0) {
+        Led_driver__Set_orientation(led_orientation);
+    }
     
     Ui__Initialize();
 
@@ -79,14 +93,7 @@ void app_main(void) {
     startup_wifi();
 
     // Start event listener task to handle provisioning button
-    xTaskCreate(
-        event_listener_task,            // Task function
-        "EventListenerTask",            // Task name (for debugging)
-        (2*configMINIMAL_STACK_SIZE),   // Stack size (words)
-        NULL,                           // Task parameter
-        6,                              // Task priority
-        NULL                            // Task handle
-    );
+    Tasks__Create(TASK_EVENT_LISTENER, event_listener_task, NULL, NULL);
 
     // Main loop just sleeps - all work is done in tasks and event handlers
     while (1) {
@@ -97,6 +104,23 @@ void app_main(void) {
 
 // PRIVATE METHODS
 
+// Stored clock, else calibrate (needs read-back), else the slowest step, which every chip handles
+static void setup_led_clock(void) {
+    static const uint32_t clock_steps_hz[] = LED_CLOCK_STEPS_HZ;
+    uint32_t clock_hz = 0;
+    if (Device_Config__Get_Led_clock_hz(&clock_hz) == 0) {
+        Led_driver__Set_clock_hz(clock_hz);
+        return;
+    }
+#if LED_CLOCK_CALIBRATION
+    if (Led_driver__Calibrate_clock(&clock_hz) == 0) {
+        Device_Config__Set_Led_clock_hz(clock_hz);
+        return;
+    }
+#endif
+    Led_driver__Set_clock_hz(clock_steps_hz[0]);
+}
+
 // Start up Wifi actions
 static void startup_wifi(void) {
     // Attempt WiFi connection (will return after connect or failure)
@@ -149,34 +173,13 @@ static void start_connected_services(void) {
 
     // Start tasks that depend on MQTT/network being up
     if (periodicTaskHandle_sleep == NULL) {
-        xTaskCreate(
-            periodic_task_sleep_wake,       // Task function
-            "PeriodicTask_SleepWake",       // Task name (for debugging)
-            (2*configMINIMAL_STACK_SIZE),   // Stack size (words)
-            NULL,                           // Task parameter
-            5,                              // Task priority
-            &periodicTaskHandle_sleep       // Task handle
-        );
+        Tasks__Create(TASK_SLEEP_WAKE, periodic_task_sleep_wake, NULL, &periodicTaskHandle_sleep);
     }
     if (periodicTaskHandle_server == NULL) {
-        xTaskCreate(
-            periodic_task_check_server,     // Task function
-            "PeriodicTask_CheckServer",     // Task name (for debugging)
-            (2*configMINIMAL_STACK_SIZE),   // Stack size (words)
-            NULL,                           // Task parameter
-            5,                              // Task priority
-            &periodicTaskHandle_server      // Task handle
-        );
+        Tasks__Create(TASK_CHECK_SERVER, periodic_task_check_server, NULL, &periodicTaskHandle_server);
     }
     if (periodicTaskHandle_heartbeat == NULL) {
-        xTaskCreate(
-            periodic_task_heartbeat,        // Task function
-            "PeriodicTask_Heartbeat",       // Task name (for debugging)
-            (2*configMINIMAL_STACK_SIZE),   // Stack size (words)
-            NULL,                           // Task parameter
-            5,                              // Task priority
-            &periodicTaskHandle_heartbeat   // Task handle
-        );
+        Tasks__Create(TASK_HEARTBEAT, periodic_task_heartbeat, NULL, &periodicTaskHandle_heartbeat);
     }
 }
 
@@ -275,15 +278,8 @@ static void handle_wifi_connection_failure(void) {
     // Continuing without WiFi but with credentials - start background retry task
     ESP_LOGI(TAG, "Continuing in offline mode (will retry WiFi connection in background)");
     
-    // Create background task to retry WiFi connection periodically
-    xTaskCreate(
-        periodic_task_wifi_reconnect,
-        "PeriodicTask_WiFiReconnect",
-        (2*configMINIMAL_STACK_SIZE),
-        NULL,
-        4,  // Lower priority than main tasks
-        NULL
-    );
+    // Create background task to retry WiFi connection periodically (lower priority than main tasks)
+    Tasks__Create(TASK_WIFI_RECONNECT, periodic_task_wifi_reconnect, NULL, NULL);
 }
 
 
@@ -395,12 +391,58 @@ static void periodic_task_heartbeat(void *pvParameters) {
         } else {
             ESP_LOGE(TAG, "Failed to read device name for heartbeat");
         }
+
+        // LED power estimate rides along with the heartbeat
+        led_driver_stats_t led_stats;
+        Led_driver__Get_stats(&led_stats);
+        mqtt_power_report_t power = {
+            .energy_j = (uint32_t)(led_stats.energy_uj / 1000000),
+            .current_ma = (uint16_t)led_stats.current_ma,
+            .peak_current_ma = (uint16_t)led_stats.peak_current_ma,
+            .budget_ma = Led_driver__Get_current_budget(),
+            .num_capped_frames = led_stats.num_capped_frames,
+        };
+        int power_len = mqtt_protocol_build_power_report(&power, heartbeat_msg, sizeof(heartbeat_msg));
+        if (power_len > 0) {
+            Mqtt__Publish(MQTT_TOPIC_HEARTBEAT, heartbeat_msg, power_len);
+        }
+
+#if VIEW_PROFILE
+        publish_render_profile();
+#endif
+        // CPU use per task and core over the last heartbeat period
+        Tasks__Log_stats();
         
         vTaskDelayUntil(&time_start_task, heartbeat_interval);
     }
 }
 
 
+#if VIEW_PROFILE
+// Per-view render cost, sent along with the heartbeat
+static void publish_render_profile(void) {
+    mqtt_render_profile_t profiles[NUM_MAIN_VIEWS];
+    uint8_t profile_msg[MQTT_PROTOCOL_HEADER_SIZE + MQTT_PROTOCOL_MAX_PAYLOAD];
+
+    for (uint8_t view = 0; view < NUM_MAIN_VIEWS; view++) {
+        view_render_times_t times;
+        View__Get_render_times(view, &times);
+        profiles[view].num_samples = times.num_samples;
+        profiles[view].min_cycles = times.min_cycles;
+        profiles[view].avg_cycles = times.avg_cycles;
+        profiles[view].max_cycles = times.max_cycles;
+        profiles[view].p99_cycles = times.p99_cycles;
+    }
+    View__Log_render_times();
+
+    int profile_len = mqtt_protocol_build_render_profile(profiles, NUM_MAIN_VIEWS, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+                                                         profile_msg, sizeof(profile_msg));
+    if (profile_len > 0) {
+        Mqtt__Publish(MQTT_TOPIC_HEARTBEAT, profile_msg, profile_len);
+    }
+}
+#endif
+
 // Event listener task: Monitors system events for provisioning button
 static void event_listener_task(void *pvParameters) {
     system_event_t event;
@@ -29,7 +29,9 @@
 #include "local_time.h"
 #include "weather.h"
 #include "etchsketch.h"
+#include "view.h"
 #include "ota.h"
+#include "latency.h"
 #include "main.h"
 
 // PRIVATE VARIABLE
@@ -51,6 +53,8 @@ static void process_current_weather(const uint8_t *payload, uint8_t payload_len)
 static void process_forecast_weather(const uint8_t *payload, uint8_t payload_len);
 static void check_and_trigger_ota_update(uint16_t server_version);
 static void process_etch_update_frame(const uint8_t *payload, uint8_t payload_len);
+static void publish_latency_report(void);
+static void publish_recorder_dump(void);
 
 static const char *TAG = "WEATHER_STATION: MQTT";
 
@@ -436,6 +440,10 @@ static void incoming_mqtt_handler(esp_mqtt_event_handle_t event) {
             if (mqtt_protocol_parse_version(payload, header.length, &version) == 0) {
                 check_and_trigger_ota_update(version.version);
             }
+        } else if (header.type == MSG_TYPE_LATENCY_GET) {
+            publish_latency_report();
+        } else if (header.type == MSG_TYPE_RECORDER_GET) {
+            publish_recorder_dump();
         } else {
             ESP_LOGW(TAG, "Unknown device-specific message type: 0x%02X", header.type);
         }
@@ -455,6 +463,48 @@ static void check_and_trigger_ota_update(uint16_t server_version) {
     }
 }
 
+// Reply to a latency request with the per-stage histograms, and dump them to the log
+static void publish_latency_report(void) {
+    latency_histogram_t histograms[LATENCY_NUM_STAGES];
+    uint8_t report_msg[MQTT_PROTOCOL_HEADER_SIZE + MQTT_PROTOCOL_MAX_PAYLOAD];
+
+    for (uint8_t stage = 0; stage < LATENCY_NUM_STAGES; stage++) {
+        Latency__Get_histogram(stage, &histograms[stage]);
+    }
+    Latency__Log();
+
+    int report_len = mqtt_protocol_build_latency_report(histograms, Latency__Get_num_unchanged(), report_msg, sizeof(report_msg));
+    if (report_len > 0) {
+        Mqtt__Publish(MQTT_TOPIC_LATENCY, report_msg, report_len);
+    }
+}
+
+// Reply to a recorder request with the frame flight recorder, split over as many messages as needed
+static void publish_recorder_dump(void) {
+    uint8_t chunk_msg[MQTT_PROTOCOL_HEADER_SIZE + MQTT_PROTOCOL_MAX_PAYLOAD];
+    uint8_t *dump = malloc(VIEW_RECORDER_DUMP_LEN);
+    if (dump == NULL) {
+        ESP_LOGE(TAG, "No memory for recorder dump");
+        return;
+    }
+
+    int dump_len = View__Recorder_dump(dump, VIEW_RECORDER_DUMP_LEN);
+    if (dump_len > 0) {
+        uint8_t num_chunks = (uint8_t)((dump_len + MQTT_RECORDER_CHUNK_DATA - 1) / MQTT_RECORDER_CHUNK_DATA);
+        for (uint8_t chunk = 0; chunk < num_chunks; chunk++) {
+            int offset = chunk * MQTT_RECORDER_CHUNK_DATA;
+            int data_len = (dump_len - offset < MQTT_RECORDER_CHUNK_DATA) ? (dump_len - offset) : MQTT_RECORDER_CHUNK_DATA;
+            int msg_len = mqtt_protocol_build_recorder_chunk(chunk, num_chunks, &dump[offset], (uint8_t)data_len,
+                                                             chunk_msg, sizeof(chunk_msg));
+            if (msg_len > 0) {
+                Mqtt__Publish(MQTT_TOPIC_RECORDER, chunk_msg, msg_len);
+            }
+        }
+        ESP_LOGI(TAG, "Recorder dump: %d bytes in %u messages", dump_len, num_chunks);
+    }
+    free(dump);
+}
+
 // Process current weather message
 static void process_current_weather(const uint8_t *payload, uint8_t payload_len) {
     mqtt_current_weather_t weather;
@@ -478,9 +528,7 @@ static void process_etch_update_frame(const uint8_t *payload, uint8_t payload_le
         return;
     }
     Etchsketch__Apply_remote_frame(&frame);
-    if (displayUpdateSemaphore) {
-        xSemaphoreGive(displayUpdateSemaphore);
-    }
+    View__Request_update();
 }
 
 // Process forecast weather message
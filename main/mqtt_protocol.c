@@ -226,6 +226,40 @@ int mqtt_protocol_build_heartbeat(const char *device_name, uint8_t *buffer, uint
     return total_len;
 }
 
+int mqtt_protocol_build_power_report(const mqtt_power_report_t *report, uint8_t *buffer, uint8_t buffer_size) {
+    if (report == NULL || buffer == NULL) {
+        ESP_LOGE(TAG, "NULL pointer passed to build_power_report");
+        return -1;
+    }
+
+    const uint8_t payload_len = 14;
+    const uint8_t total_len = MQTT_PROTOCOL_HEADER_SIZE + payload_len;
+    if (buffer_size < total_len) {
+        ESP_LOGE(TAG, "Buffer too small for power report: %d (required %d)", buffer_size, total_len);
+        return -1;
+    }
+
+    uint8_t idx = 0;
+    buffer[idx++] = MSG_TYPE_POWER_REPORT;
+    buffer[idx++] = payload_len;
+    buffer[idx++] = (uint8_t)(report->energy_j >> 24);
+    buffer[idx++] = (uint8_t)(report->energy_j >> 16);
+    buffer[idx++] = (uint8_t)(report->energy_j >> 8);
+    buffer[idx++] = (uint8_t)report->energy_j;
+    buffer[idx++] = (uint8_t)(report->current_ma >> 8);
+    buffer[idx++] = (uint8_t)report->current_ma;
+    buffer[idx++] = (uint8_t)(report->peak_current_ma >> 8);
+    buffer[idx++] = (uint8_t)report->peak_current_ma;
+    buffer[idx++] = (uint8_t)(report->budget_ma >> 8);
+    buffer[idx++] = (uint8_t)report->budget_ma;
+    buffer[idx++] = (uint8_t)(report->num_capped_frames >> 24);
+    buffer[idx++] = (uint8_t)(report->num_capped_frames >> 16);
+    buffer[idx++] = (uint8_t)(report->num_capped_frames >> 8);
+    buffer[idx++] = (uint8_t)report->num_capped_frames;
+
+    return total_len;
+}
+
 int mqtt_protocol_build_etch_get_frame(uint8_t *buffer, uint8_t buffer_size) {
     if (buffer == NULL || buffer_size < MQTT_PROTOCOL_HEADER_SIZE) {
         ESP_LOGE(TAG, "Invalid buffer for etch get frame request");
@@ -288,3 +322,104 @@ int mqtt_protocol_build_etch_update_frame(const mqtt_etch_sketch_frame_t *frame,
 
     return total_len;
 }
+
+int mqtt_protocol_build_latency_report(const latency_histogram_t *histograms, uint32_t num_unchanged, uint8_t *buffer, uint16_t buffer_size) {
+    if (histograms == NULL || buffer == NULL) {
+        ESP_LOGE(TAG, "NULL pointer passed to build_latency_report");
+        return -1;
+    }
+
+    const uint16_t payload_len = 2 + (LATENCY_NUM_STAGES * (8 + (LATENCY_NUM_BUCKETS * 2))) + 4;
+    const uint16_t total_len = MQTT_PROTOCOL_HEADER_SIZE + payload_len;
+    if (payload_len > MQTT_PROTOCOL_MAX_PAYLOAD || buffer_size < total_len) {
+        ESP_LOGE(TAG, "Buffer too small for latency report: %d (required %d)", buffer_size, total_len);
+        return -1;
+    }
+
+    uint16_t idx = 0;
+    buffer[idx++] = MSG_TYPE_LATENCY_REPORT;
+    buffer[idx++] = (uint8_t)payload_len;
+    buffer[idx++] = LATENCY_NUM_STAGES;
+    buffer[idx++] = LATENCY_NUM_BUCKETS;
+
+    for (uint8_t stage = 0; stage < LATENCY_NUM_STAGES; stage++) {
+        const latency_histogram_t *histogram = &histograms[stage];
+        uint32_t words[2] = {histogram->num_samples, histogram->max_us};
+        for (uint8_t i = 0; i < 2; i++) {
+            buffer[idx++] = (uint8_t)(words[i] >> 24);
+            buffer[idx++] = (uint8_t)(words[i] >> 16);
+            buffer[idx++] = (uint8_t)(words[i] >> 8);
+            buffer[idx++] = (uint8_t)words[i];
+        }
+        for (uint8_t bucket = 0; bucket < LATENCY_NUM_BUCKETS; bucket++) {
+            uint16_t count = (histogram->bucket[bucket] > 0xFFFF) ? 0xFFFF : (uint16_t)histogram->bucket[bucket];
+            buffer[idx++] = (uint8_t)(count >> 8);
+            buffer[idx++] = (uint8_t)count;
+        }
+    }
+
+    buffer[idx++] = (uint8_t)(num_unchanged >> 24);
+    buffer[idx++] = (uint8_t)(num_unchanged >> 16);
+    buffer[idx++] = (uint8_t)(num_unchanged >> 8);
+    buffer[idx++] = (uint8_t)num_unchanged;
+
+    return total_len;
+}
+
+int mqtt_protocol_build_recorder_chunk(uint8_t chunk_index, uint8_t num_chunks, const uint8_t *data, uint8_t data_len,
+                                       uint8_t *buffer, uint16_t buffer_size) {
+    if (data == NULL || buffer == NULL) {
+        ESP_LOGE(TAG, "NULL pointer passed to build_recorder_chunk");
+        return -1;
+    }
+
+    const uint16_t payload_len = 2 + data_len;
+    const uint16_t total_len = MQTT_PROTOCOL_HEADER_SIZE + payload_len;
+    if (data_len > MQTT_RECORDER_CHUNK_DATA || buffer_size < total_len) {
+        ESP_LOGE(TAG, "Buffer too small for recorder chunk: %d (required %d)", buffer_size, total_len);
+        return -1;
+    }
+
+    buffer[0] = MSG_TYPE_RECORDER_CHUNK;
+    buffer[1] = (uint8_t)payload_len;
+    buffer[2] = chunk_index;
+    buffer[3] = num_chunks;
+    memcpy(&buffer[4], data, data_len);
+
+    return total_len;
+}
+
+int mqtt_protocol_build_render_profile(const mqtt_render_profile_t *profiles, uint8_t num_views, uint16_t cpu_mhz,
+                                       uint8_t *buffer, uint16_t buffer_size) {
+    if (profiles == NULL || buffer == NULL) {
+        ESP_LOGE(TAG, "NULL pointer passed to build_render_profile");
+        return -1;
+    }
+
+    const uint16_t payload_len = 3 + (num_views * 20);
+    const uint16_t total_len = MQTT_PROTOCOL_HEADER_SIZE + payload_len;
+    if (payload_len > MQTT_PROTOCOL_MAX_PAYLOAD || buffer_size < total_len) {
+        ESP_LOGE(TAG, "Buffer too small for render profile: %d (required %d)", buffer_size, total_len);
+        return -1;
+    }
+
+    uint16_t idx = 0;
+    buffer[idx++] = MSG_TYPE_RENDER_PROFILE;
+    buffer[idx++] = (uint8_t)payload_len;
+    buffer[idx++] = (uint8_t)(cpu_mhz >> 8);
+    buffer[idx++] = (uint8_t)cpu_mhz;
+    buffer[idx++] = num_views;
+
+    for (uint8_t view = 0; view < num_views; view++) {
+        const mqtt_render_profile_t *profile = &profiles[view];
+        uint32_t words[5] = {profile->num_samples, profile->min_cycles, profile->avg_cycles, profile->max_cycles, profile->p99_cycles};
+        for (uint8_t i = 0; i < 5; i++) {
+            buffer[idx++] = (uint8_t)(words[i] >> 24);
+            buffer[idx++] = (uint8_t)(words[i] >> 16);
+            buffer[idx++] = (uint8_t)(words[i] >> 8);
+            buffer[idx++] = (uint8_t)words[i];
+        }
+    }
+
+    return total_len;
+}
@@ -11,6 +11,7 @@
 
 #include "ota.h"
 #include "device_config.h"
+#include "tasks.h"
 
 static const char *TAG = "ota";
 
@@ -78,14 +79,7 @@ void OTA__Init(void) {
     ESP_LOGI(TAG, "Running from partition: %s", running->label);
     
     // Create OTA download task that waits for trigger semaphore
-    xTaskCreate(
-        ota_download_task,              // Task function
-        "OTA_Download",                 // Task name
-        (4*configMINIMAL_STACK_SIZE),   // Stack size (needs more for HTTPS)
-        NULL,                           // Task parameter
-        4,                              // Task priority (lower than MQTT)
-        &otaTaskHandle                  // Task handle
-    );
+    Tasks__Create(TASK_OTA_DOWNLOAD, ota_download_task, NULL, &otaTaskHandle);
 }
 
 // OTA download task - waits for semaphore and performs HTTPS OTA update
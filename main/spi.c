@@ -3,8 +3,13 @@
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "driver/spi_master.h"
-#include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_sys.h"
+#include "esp_rom_gpio.h"
+#include "driver/gpio.h"
+#include "soc/spi_periph.h"
 #include "spi.h"
 
 const static char *TAG_SPI = "WEATHER_STATION: SPI";
@@ -12,8 +17,28 @@ const static char *TAG_SPI = "WEATHER_STATION: SPI";
 esp_err_t ret;
 spi_device_handle_t spi;
 
-spi_device_handle_t Spi__Init(uint8_t data_pin, uint8_t clk_pin, uint8_t mode, uint8_t cs_pin) {
-    spi_device_handle_t spi_handle;
+// Queued transactions. Each slot owns a DMA capable buffer that lives as long as the bus,
+// so callers can reuse their own buffer as soon as Spi__Queue_write returns.
+// Slots are used as a ring: spi_device_get_trans_result hands back each device's
+// transactions in queue order, so the oldest slot is always the next one to finish.
+typedef struct {
+    spi_transaction_t trans;
+    spi_device_handle_t handle;
+    volatile int64_t done_us;       // Set by post_cb when the transaction leaves the wire
+} spi_slot_t;
+
+static spi_slot_t Slots[SPI_QUEUE_SIZE];
+static uint8_t *Slot_buffers = NULL;
+static uint8_t Slot_head;           // Oldest in flight
+static uint8_t Slot_count;
+static int64_t Last_done_us;        // Latest completion among slots reclaimed since the last flush, 0 = none
+static uint32_t Clock_hz = SPI_CLOCK_SPEED_HZ;
+
+static void reclaim_oldest_slot(void);
+static void IRAM_ATTR spi_post_cb(spi_transaction_t *trans);
+
+// Initialize the bus once, then attach each chip with Spi__Add_device
+void Spi__Init_bus(uint8_t data_pin, uint8_t clk_pin) {
     spi_bus_config_t buscfg = {                                         // Provide details to the SPI_bus_sturcture of pins and maximum data size
         .miso_io_num = -1,                                              // master in, slave out: data pin
         .mosi_io_num = data_pin,                                        // master out, slave in: data pin
@@ -23,64 +48,176 @@ spi_device_handle_t Spi__Init(uint8_t data_pin, uint8_t clk_pin, uint8_t mode, u
         .max_transfer_sz = 0                                            // Max transfer size (bytes). If 0, defaults 4092 (DMA enabled) or SOC_SPI_MAXIMUM_BUFFER_SIZE (DMA disabled)
     };
 
+    ret = spi_bus_initialize(SPI_HOST, &buscfg, DMA_CHANNEL);           // Initialize the SPI bus
+    ESP_ERROR_CHECK(ret);
+
+    if(Slot_buffers == NULL) {
+        Slot_buffers = heap_caps_malloc(SPI_QUEUE_SIZE * SPI_TRANS_MAX_BYTES, MALLOC_CAP_DMA);
+        if(Slot_buffers == NULL) {
+            ESP_LOGE(TAG_SPI, "Failed to allocate DMA buffers\n");
+        }
+    }
+}
+
+// Attach one chip (its own chip select) to the bus at the current clock
+spi_device_handle_t Spi__Add_device(uint8_t mode, uint8_t cs_pin) {
+    spi_device_handle_t spi_handle;
     spi_device_interface_config_t devcfg = {
-        .clock_speed_hz = SPI_CLOCK_SPEED_HZ,                           // Clock out at 1 kHz
+        .clock_speed_hz = Clock_hz,                                     // SPI_CLOCK_SPEED_HZ until calibrated
         .mode = mode,                                                   // SPI mode 0: CPOL:-0 and CPHA:-0
         .spics_io_num = cs_pin,                                         // This field is used to specify the GPIO pin that is to be used as CS'
-        .queue_size = 1,                                                // We want to be able to queue 7 transactions at a time
+        .queue_size = SPI_QUEUE_SIZE,                                   // Every write of a frame can be queued without blocking
+        .post_cb = spi_post_cb,                                         // Timestamp completion for frame-done reporting
     };
 
-    // Lazy implementation for now: Only initialize bus once! Just for 8 (CS_RED) because it happens to be called first
-    if(cs_pin==8) {
-        ret = spi_bus_initialize(SPI_HOST, &buscfg, DMA_CHANNEL);           // Initialize the SPI bus
-        ESP_ERROR_CHECK(ret);
-    }
-
     ret = spi_bus_add_device(SPI_HOST, &devcfg, &spi_handle);           // Attach the Slave device to the SPI bus
     ESP_ERROR_CHECK(ret);
 
     return(spi_handle);
 }
 
-void Spi__Write(spi_device_handle_t spi_handle, uint8_t* buffer, uint16_t num_bits_data) {
-    static SemaphoreHandle_t spi_mutex = NULL;
-    
-    // Create mutex on first call
-    if (spi_mutex == NULL) {
-        spi_mutex = xSemaphoreCreateMutex();
+// Re-attach device with a new clock. Waits for anything queued first.
+// The clock applies to devices added later too.
+spi_device_handle_t Spi__Set_clock_hz(spi_device_handle_t spi_handle, uint8_t mode, uint8_t cs_pin, uint32_t clock_hz) {
+    Spi__Flush();
+    Clock_hz = clock_hz;
+
+    ret = spi_bus_remove_device(spi_handle);
+    ESP_ERROR_CHECK(ret);
+
+    return(Spi__Add_device(mode, cs_pin));
+}
+
+uint32_t Spi__Get_clock_hz(void) {
+    return Clock_hz;
+}
+
+// HT1632 read back. Clocks the READ mode header with CS held low, then hands the data line
+// to the chip and pulses RD, sampling each bit while RD is low (chip shifts out on falling RD).
+// Data pin is routed back to the SPI peripheral afterwards.
+int Spi__Read(spi_device_handle_t spi_handle, uint8_t data_pin, uint8_t rd_pin, uint8_t* buffer, uint16_t num_bits_header, uint8_t* rx_nibbles, uint8_t num_nibbles) {
+    uint32_t half_period_us = (500000 + Clock_hz - 1) / Clock_hz;
+    spi_transaction_t trans_desc;
+    int result = 0;
+
+    Spi__Flush();
+    ret = spi_device_acquire_bus(spi_handle, portMAX_DELAY);
+    if (ret != ESP_OK) {
+        return -1;
     }
-    
-    // Take mutex to ensure only one transaction at a time
-    if (xSemaphoreTake(spi_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        spi_transaction_t trans_desc;
-        memset(&trans_desc, 0, sizeof(trans_desc));
-
-        //flip bytes in buffer: first byte->last byte, 2nd byte->2nd to last byte...
-        uint8_t num_bytes = num_bits_data / 8;
-        uint8_t leftover_bits = num_bits_data % 8;
-        if(leftover_bits > 0) {
-            num_bytes ++;
-        }
-        uint8_t new_buffer[num_bytes];
-        for(uint8_t i_byte = 0; i_byte < num_bytes; i_byte++) {
-            uint8_t buf_idx = (num_bytes - 1) - i_byte;
-            new_buffer[i_byte] = buffer[buf_idx];
-        }
-        
-        // Configure the transaction_structure
-        trans_desc.length = num_bits_data;                                   // Length of (address + data) is 16 bits
-        trans_desc.tx_buffer = new_buffer;
-
-        // Use queued transmit to block until the bus is free instead of erroring when a prior polling transaction is in-flight.
-        ret = spi_device_transmit(spi_handle, &trans_desc);
-        if (ret != ESP_OK)
-        {
-            ESP_LOGE(TAG_SPI, "SPI operation failed\n");
-        }
-        
-        xSemaphoreGive(spi_mutex);
+
+    memset(&trans_desc, 0, sizeof(trans_desc));
+    trans_desc.flags = SPI_TRANS_CS_KEEP_ACTIVE;
+    trans_desc.length = num_bits_header;
+    trans_desc.tx_buffer = buffer;
+    ret = spi_device_polling_transmit(spi_handle, &trans_desc);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG_SPI, "SPI read header failed\n");
+        result = -1;
     } else {
-        ESP_LOGE(TAG_SPI, "Failed to acquire SPI mutex\n");
+        gpio_set_direction(data_pin, GPIO_MODE_INPUT);
+        for (uint8_t i = 0; i < num_nibbles; i++) {
+            uint8_t nibble = 0;
+            for (uint8_t bit = 0; bit < 4; bit++) {
+                gpio_set_level(rd_pin, 0);
+                esp_rom_delay_us(half_period_us);
+                nibble = (nibble << 1) | (gpio_get_level(data_pin) & 1);
+                gpio_set_level(rd_pin, 1);
+                esp_rom_delay_us(half_period_us);
+            }
+            rx_nibbles[i] = nibble;
+        }
+        gpio_set_direction(data_pin, GPIO_MODE_OUTPUT);
+        esp_rom_gpio_connect_out_signal(data_pin, spi_periph_signal[SPI_HOST].spid_out, false, false);
+    }
+
+    // Empty transaction without KEEP_ACTIVE releases CS
+    memset(&trans_desc, 0, sizeof(trans_desc));
+    spi_device_polling_transmit(spi_handle, &trans_desc);
+    spi_device_release_bus(spi_handle);
+
+    return result;
+}
+
+// Queue a transaction without waiting for it. Buffer is copied into a slot, so it can be reused
+// right away. Only blocks when all slots are in flight (waits for the oldest one).
+// Not thread safe: callers serialize access to the bus (led_driver holds its bus mutex).
+void Spi__Queue_write(spi_device_handle_t spi_handle, uint8_t* buffer, uint16_t num_bits_data) {
+    uint16_t num_bytes = (num_bits_data + 7) / 8;
+    if(Slot_buffers == NULL || num_bytes > SPI_TRANS_MAX_BYTES) {
+        ESP_LOGE(TAG_SPI, "SPI write rejected: %u bits\n", num_bits_data);
+        return;
+    }
+
+    if(Slot_count == SPI_QUEUE_SIZE) {
+        reclaim_oldest_slot();
+    }
+
+    uint8_t idx = (Slot_head + Slot_count) % SPI_QUEUE_SIZE;
+    spi_slot_t *slot = &Slots[idx];
+    uint8_t *dma_buffer = &Slot_buffers[idx * SPI_TRANS_MAX_BYTES];
+    memcpy(dma_buffer, buffer, num_bytes);
+
+    // Buffer is already in wire order (first bit = MSB of buffer[0])
+    memset(&slot->trans, 0, sizeof(slot->trans));
+    slot->trans.length = num_bits_data;
+    slot->trans.tx_buffer = dma_buffer;
+    slot->trans.user = slot;
+    slot->handle = spi_handle;
+    slot->done_us = 0;
+
+    ret = spi_device_queue_trans(spi_handle, &slot->trans, portMAX_DELAY);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SPI, "SPI queue failed\n");
+        return;
+    }
+    Slot_count++;
+}
+
+// Wait for every queued transaction, return time (esp_timer us) the last one finished.
+// 0 when nothing went out since the previous flush: an older completion time would
+// make the caller's frame end before it started.
+int64_t Spi__Flush(void) {
+    while(Slot_count > 0) {
+        reclaim_oldest_slot();
+    }
+    int64_t done_us = Last_done_us;
+    Last_done_us = 0;
+    return done_us;
+}
+
+// Blocking write: queue and wait until it is on the wire
+void Spi__Write(spi_device_handle_t spi_handle, uint8_t* buffer, uint16_t num_bits_data) {
+    Spi__Queue_write(spi_handle, buffer, num_bits_data);
+    Spi__Flush();
+}
+
+static void reclaim_oldest_slot(void) {
+    spi_slot_t *slot = &Slots[Slot_head];
+    spi_transaction_t *done_trans;
+
+    ret = spi_device_get_trans_result(slot->handle, &done_trans, portMAX_DELAY);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SPI, "SPI operation failed\n");
+    }
+    // post_cb runs before the driver puts the transaction on the result queue, so done_us is
+    // already set here. Devices finish in queue order, but keep the max to be safe.
+    int64_t done_us = slot->done_us ? slot->done_us : esp_timer_get_time();
+    if (done_us > Last_done_us) {
+        Last_done_us = done_us;
+    }
+
+    Slot_head = (Slot_head + 1) % SPI_QUEUE_SIZE;
+    Slot_count--;
+}
+
+// Runs in ISR context when a transaction completes
+static void IRAM_ATTR spi_post_cb(spi_transaction_t *trans) {
+    spi_slot_t *slot = (spi_slot_t *)trans->user;
+    if(slot) {
+        slot->done_us = esp_timer_get_time();
     }
 }
 
@@ -99,62 +236,3 @@ void Spi__Write(spi_device_handle_t spi_handle, uint8_t* buffer, uint16_t num_bi
 //         ESP_LOGE(TAG_SPI, "SPI operation failed\n");
 //     }
 // }
-
-void Spi__BitBang_Setup(uint8_t clk_pin, uint8_t data_pin) {
-    // gpio config clk and data pins
-    gpio_reset_pin(clk_pin);
-    gpio_reset_pin(data_pin);
-    gpio_set_direction(clk_pin, GPIO_MODE_OUTPUT);
-    gpio_set_direction(data_pin, GPIO_MODE_OUTPUT);
-    gpio_set_level(clk_pin, CLK_HI);
-    gpio_set_level(data_pin, 0);
-}
-
-// Clock idles high. Pull clk low, wait, set data, wait, pull clock high (device reads on rising clk edge), wait
-// cmd write = #-####-###X, len=9
-// start_write = 101 AAAAAAA, len=10
-// successive_write = DDDD, len=4
-void Spi__BitBang_Write(uint8_t clk_pin, uint8_t data_pin, uint8_t* tx_buffer, uint16_t num_bits_data) {
-    // set MSB first
-    uint8_t num_bytes = num_bits_data / 8;
-    if((num_bytes % 8) > 0) {
-        num_bytes += 1;
-    }
-
-#if DEBUG
-    printf("num_bits: %u  num_bytes: %u\n", num_bits_data, num_bytes);
-    // uint16_t count_bits = 0;
-#endif
-
-    // Iterate over each byte in buffer MSB->LSB
-    uint8_t curr_byte = num_bytes;  // 1-based: need last byte to be 1 for while loop to work properly
-    while(curr_byte > 0) {
-        uint8_t data_byte = tx_buffer[curr_byte-1];
-
-        // Set data according to each bit in byte MSB->LSB
-        for(uint8_t bit = 8; bit > 0; bit--) {
-            uint8_t bit_index = bit - 1;
-            uint8_t level = ((data_byte >> bit_index) & 1);
-            
-            gpio_set_level(clk_pin, CLK_LO);
-            vTaskDelay(pdMS_TO_TICKS(MS_DELAY_DATA));
-            gpio_set_level(data_pin, level);
-            vTaskDelay(pdMS_TO_TICKS(MS_DELAY_DATA));
-            gpio_set_level(clk_pin, CLK_HI);
-            vTaskDelay(pdMS_TO_TICKS(MS_DELAY_DATA));
-        #if DEBUG
-            printf("%u", level);
-            //     count_bits ++;
-            //     if(count_bits >= num_bits_data) {break;}
-        #endif
-        }
-#if DEBUG 
-        printf(":");
-#endif
-        curr_byte --;
-    }
-
-#if DEBUG
-    printf("\n");
-#endif
-}
\ No newline at end of file
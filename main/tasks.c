@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#include "tasks.h"
+
+static const char *TAG = "WEATHER_STATION: TASKS";
+
+typedef struct {
+    const char *name;
+    uint8_t core;
+    uint8_t priority;
+    uint32_t stack_depth;       // As xTaskCreate takes it (bytes on ESP-IDF)
+    StackType_t *stack;         // Static tasks: stack and TCB live here, NULL = allocate on create
+    StaticTask_t *tcb;
+} task_config_t;
+
+// Tasks that run for the life of the firmware get static stacks: no heap at boot, and
+// they can never fail to start once WiFi / TLS have fragmented the heap.
+// Stack sizes are what the task uses on the target (Tasks__Log_stats, every heartbeat) plus
+// TASKS_STACK_MARGIN; grow an entry when the log warns. Display and scrub have no target
+// reading yet: their sizes come from test_task_stacks on the host and stand until one does.
+static StackType_t Display_stack[5120];
+static StackType_t Led_transmit_stack[2*configMINIMAL_STACK_SIZE];
+static StackType_t Led_scrub_stack[3*configMINIMAL_STACK_SIZE];
+static StackType_t Button_stack[2*configMINIMAL_STACK_SIZE];
+static StackType_t Encoder_stack[2*configMINIMAL_STACK_SIZE];
+static StackType_t Event_dispatcher_stack[3*configMINIMAL_STACK_SIZE];
+static StackType_t Event_listener_stack[2*configMINIMAL_STACK_SIZE];
+static StaticTask_t Display_tcb;
+static StaticTask_t Led_transmit_tcb;
+static StaticTask_t Led_scrub_tcb;
+static StaticTask_t Button_tcb;
+static StaticTask_t Encoder_tcb;
+static StaticTask_t Event_dispatcher_tcb;
+static StaticTask_t Event_listener_tcb;
+
+#define STATIC_STACK(stack, tcb)    sizeof(stack) / sizeof(StackType_t), stack, &tcb
+
+// Priorities: input > LED bus > display > everything else
+static const task_config_t Task_table[NUM_TASKS] = {
+    [TASK_DISPLAY]          = {"BlockingTask_UpdateDisplay", TASKS_CORE_DISPLAY, 8, STATIC_STACK(Display_stack, Display_tcb)},
+    [TASK_LED_TRANSMIT]     = {"LedDriver_Transmit", TASKS_CORE_DISPLAY, 9, STATIC_STACK(Led_transmit_stack, Led_transmit_tcb)},
+    [TASK_LED_SCRUB]        = {"LedDriver_Scrub", TASKS_CORE_DISPLAY, 1, STATIC_STACK(Led_scrub_stack, Led_scrub_tcb)},
+    [TASK_BUTTON]           = {"ButtonEventTask", TASKS_CORE_DISPLAY, 10, STATIC_STACK(Button_stack, Button_tcb)},
+    [TASK_ENCODER]          = {"EncoderPollTask", TASKS_CORE_DISPLAY, 10, STATIC_STACK(Encoder_stack, Encoder_tcb)},
+    [TASK_EVENT_DISPATCHER] = {"EventDispatcher", TASKS_CORE_DISPLAY, 12, STATIC_STACK(Event_dispatcher_stack, Event_dispatcher_tcb)},
+    [TASK_EVENT_LISTENER]   = {"EventListenerTask", TASKS_CORE_DISPLAY, 6, STATIC_STACK(Event_listener_stack, Event_listener_tcb)},
+    [TASK_SLEEP_WAKE]       = {"PeriodicTask_SleepWake", TASKS_CORE_NETWORK, 5, 2*configMINIMAL_STACK_SIZE, NULL, NULL},
+    [TASK_CHECK_SERVER]     = {"PeriodicTask_CheckServer", TASKS_CORE_NETWORK, 5, 2*configMINIMAL_STACK_SIZE, NULL, NULL},
+    [TASK_HEARTBEAT]        = {"PeriodicTask_Heartbeat", TASKS_CORE_NETWORK, 5, 4*configMINIMAL_STACK_SIZE, NULL, NULL},  // Report buffers, no target reading yet
+    [TASK_WIFI_RECONNECT]   = {"PeriodicTask_WiFiReconnect", TASKS_CORE_NETWORK, 4, 2*configMINIMAL_STACK_SIZE, NULL, NULL},
+    [TASK_OTA_DOWNLOAD]     = {"OTA_Download", TASKS_CORE_NETWORK, 4, 4*configMINIMAL_STACK_SIZE, NULL, NULL},      // HTTPS
+    [TASK_ETCH_FLUSH]       = {"FlushWorker", TASKS_CORE_NETWORK, 6, 3072, NULL, NULL},
+    [TASK_BLE_SCAN]         = {"BleScanTask", TASKS_CORE_NETWORK, 5, 4*configMINIMAL_STACK_SIZE, NULL, NULL},
+};
+
+// Run time counters from the previous Tasks__Get_stats, to report usage over the interval
+typedef struct {
+    UBaseType_t task_number;
+    configRUN_TIME_COUNTER_TYPE run_time;
+} task_run_time_t;
+
+static task_run_time_t Prev_run_times[TASKS_MAX_STATS];
+static uint8_t Num_prev_run_times;
+static configRUN_TIME_COUNTER_TYPE Prev_total_run_time;
+
+// PRIVATE method prototypes
+configRUN_TIME_COUNTER_TYPE prev_run_time(UBaseType_t);
+const task_config_t *table_entry(const char*);
+
+// PUBLIC methods
+
+// Create task from its table entry; handle (optional) receives the task handle
+int Tasks__Create(task_id_t task, TaskFunction_t function, void *param, TaskHandle_t *handle) {
+    if (task >= NUM_TASKS || !function) {
+        return -1;
+    }
+    const task_config_t *config = &Task_table[task];
+    TaskHandle_t created = NULL;
+
+    if (config->stack) {
+        created = xTaskCreateStaticPinnedToCore(function, config->name, config->stack_depth, param, config->priority,
+                                                config->stack, config->tcb, config->core);
+    } else if (xTaskCreatePinnedToCore(function, config->name, config->stack_depth, param, config->priority,
+                                       &created, config->core) != pdPASS) {
+        created = NULL;
+    }
+
+    if (created == NULL) {
+        ESP_LOGE(TAG, "Failed to create %s", config->name);
+        return -1;
+    }
+    if (handle) {
+        *handle = created;
+    }
+    ESP_LOGI(TAG, "%s: core %u, priority %u, stack %lu%s", config->name, config->core, config->priority,
+             (unsigned long)config->stack_depth, config->stack ? " (static)" : "");
+    return 0;
+}
+
+// Fill stats for up to max_stats tasks (all tasks in the system, not only ours).
+// Returns number filled, or -1 when run time stats are not enabled in sdkconfig.
+int Tasks__Get_stats(task_stats_t *stats, uint8_t max_stats) {
+#if (configUSE_TRACE_FACILITY == 1) && (configGENERATE_RUN_TIME_STATS == 1)
+    if (!stats || max_stats == 0) {
+        return -1;
+    }
+    // uxTaskGetSystemState fills nothing unless every task fits; slack for tasks created meanwhile
+    UBaseType_t num_tasks = uxTaskGetNumberOfTasks() + 2;
+    TaskStatus_t *status = malloc(num_tasks * sizeof(TaskStatus_t));
+    if (!status) {
+        return -1;
+    }
+    configRUN_TIME_COUNTER_TYPE total_run_time = 0;
+    num_tasks = uxTaskGetSystemState(status, num_tasks, &total_run_time);
+
+    // Counter differences, so a wrapping 32-bit counter is fine between calls
+    configRUN_TIME_COUNTER_TYPE interval = total_run_time - Prev_total_run_time;
+    uint8_t num_stats = 0;
+    for (UBaseType_t i = 0; i < num_tasks; i++) {
+        configRUN_TIME_COUNTER_TYPE busy = status[i].ulRunTimeCounter - prev_run_time(status[i].xTaskNumber);
+        uint64_t percent = interval ? ((uint64_t)busy * 100 / interval) : 0;
+
+        if (num_stats < max_stats) {
+            task_stats_t *task = &stats[num_stats++];
+            snprintf(task->name, sizeof(task->name), "%s", status[i].pcTaskName);
+            BaseType_t core = xTaskGetCoreID(status[i].xHandle);
+            task->core = (core == tskNO_AFFINITY) ? -1 : (int8_t)core;
+            task->priority = (uint8_t)status[i].uxCurrentPriority;
+            task->cpu_percent = (percent > 100) ? 100 : (uint8_t)percent;
+            task->stack_free = status[i].usStackHighWaterMark;
+            const task_config_t *config = table_entry(status[i].pcTaskName);
+            task->stack_size = config ? config->stack_depth : 0;
+        }
+    }
+
+    // Deleted tasks drop out here
+    Num_prev_run_times = 0;
+    for (UBaseType_t i = 0; i < num_tasks && Num_prev_run_times < TASKS_MAX_STATS; i++) {
+        Prev_run_times[Num_prev_run_times].task_number = status[i].xTaskNumber;
+        Prev_run_times[Num_prev_run_times].run_time = status[i].ulRunTimeCounter;
+        Num_prev_run_times++;
+    }
+    Prev_total_run_time = total_run_time;
+    free(status);
+    return num_stats;
+#else
+    return -1;
+#endif
+}
+
+// One line per task: core, priority, CPU % since the last call, stack left
+void Tasks__Log_stats(void) {
+    task_stats_t *stats = malloc(TASKS_MAX_STATS * sizeof(task_stats_t));
+    if (!stats) {
+        return;
+    }
+    int num_stats = Tasks__Get_stats(stats, TASKS_MAX_STATS);
+    if (num_stats < 0) {
+        ESP_LOGW(TAG, "Task stats need CONFIG_FREERTOS_USE_TRACE_FACILITY and CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS");
+    }
+    for (int i = 0; i < num_stats; i++) {
+        char core[5] = "-";
+        if (stats[i].core >= 0) {
+            snprintf(core, sizeof(core), "%d", stats[i].core);
+        }
+        ESP_LOGI(TAG, "%-16s core %s prio %2u cpu %3u%% stack free %lu", stats[i].name, core, stats[i].priority,
+                 stats[i].cpu_percent, (unsigned long)stats[i].stack_free);
+        if (stats[i].stack_size && stats[i].stack_free < TASKS_STACK_MARGIN) {
+            ESP_LOGW(TAG, "%s: %lu of %lu stack bytes free, under the %u byte margin: size it %lu", stats[i].name,
+                     (unsigned long)stats[i].stack_free, (unsigned long)stats[i].stack_size, TASKS_STACK_MARGIN,
+                     (unsigned long)(stats[i].stack_size - stats[i].stack_free + TASKS_STACK_MARGIN));
+        }
+    }
+    free(stats);
+}
+
+// PRIVATE METHODS
+
+// Run time counter of task at the previous Tasks__Get_stats, 0 if it is new since
+configRUN_TIME_COUNTER_TYPE prev_run_time(UBaseType_t task_number) {
+    for (uint8_t i = 0; i < Num_prev_run_times; i++) {
+        if (Prev_run_times[i].task_number == task_number) {
+            return Prev_run_times[i].run_time;
+        }
+    }
+    return 0;
+}
+
+// Task_table entry of a running task, NULL for tasks created elsewhere (IDF). Running tasks
+// carry their name cut to configMAX_TASK_NAME_LEN.
+const task_config_t *table_entry(const char *name) {
+    for (uint8_t task = 0; task < NUM_TASKS; task++) {
+        if (strncmp(name, Task_table[task].name, configMAX_TASK_NAME_LEN - 1) == 0) {
+            return &Task_table[task];
+        }
+    }
+    return NULL;
+}
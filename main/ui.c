@@ -10,6 +10,7 @@
 #include "led_driver.h"
 #include "view.h"
 #include "animation.h"
+#include "tasks.h"
 
 static const char *TAG = "WEATHER_STATION: UI";
 
@@ -31,6 +32,9 @@ static void button_isr_handler(void *arg);
 // last observed button pin levels (indexed by button index)
 static volatile uint8_t button_last_level[4] = {0,0,0,0};
 
+// esp_timer us of the last edge seen by the ISR (indexed by button index), event timestamp
+static volatile uint32_t button_edge_us[4] = {0,0,0,0};
+
 // Built-in button (GPIO 0) long-press detection using interrupts
 static volatile uint32_t builtin_btn_press_time_ms = 0;
 static volatile uint8_t builtin_btn_longpress_detected = 0;
@@ -166,23 +170,8 @@ void Ui__Initialize(void) {
     }
     
     // start consumer tasks
-    xTaskCreate(
-        button_event_task,              // Task function
-        "ButtonEventTask",             // Task name (for debugging)
-        (2*configMINIMAL_STACK_SIZE),   // Stack size (words)
-        (void*)button_isr_queue,        // Task parameter -> queue handle
-        10,                             // Task priority
-        &periodicTaskHandle_btn         // Task handle
-    );
-    
-    xTaskCreate(
-        encoder_poll_task,              // Task function
-        "EncoderPollTask",             // Task name (for debugging)
-        (2*configMINIMAL_STACK_SIZE),   // Stack size (words)
-        NULL,                           // Task parameter
-        10,                             // Task priority
-        NULL                            // Task handle
-    );
+    Tasks__Create(TASK_BUTTON, button_event_task, (void*)button_isr_queue, &periodicTaskHandle_btn);
+    Tasks__Create(TASK_ENCODER, encoder_poll_task, NULL, NULL);
     
     // Setup built-in button (GPIO 0) for long-press detection via interrupt
     gpio_config_t builtin_btn_config = {
@@ -204,6 +193,7 @@ void Ui__Initialize(void) {
 }
 
 // Poll PCNT counters and post events when movement detected
+// (event timestamp = the poll that saw the count change, up to 10ms after the detent)
 static void encoder_poll_task(void *arg) {
     int prev_count1 = 0, prev_count2 = 0;
     int accum1 = 0, accum2 = 0;  // Accumulate counts to detect 4-count boundaries
@@ -276,6 +266,7 @@ static void IRAM_ATTR button_isr_handler(void *arg) {
 
     // update last level (done in ISR context)
     button_last_level[idx] = level;
+    button_edge_us[idx] = (uint32_t)esp_timer_get_time();
 
     xQueueSendFromISR(button_isr_queue, &pin, &xHigherPriorityTaskWoken);
     if (xHigherPriorityTaskWoken) portYIELD_FROM_ISR();
@@ -324,14 +315,14 @@ void button_event_task(void *pvParameters) {
                 pressed[idx] = 1;
                 button_pressed_state[idx] = 1;  // Update shared state for encoder task
                 ESP_LOGI(TAG, "Button %d DOWN", idx + 1);
-                EventSystem_PostEvent(EVENT_UI_BUTTON_DOWN, (1 << idx), NULL);
+                EventSystem_PostEventAt(EVENT_UI_BUTTON_DOWN, (1 << idx), NULL, button_edge_us[idx]);
             } 
             else if (!is_pressed && pressed[idx]) {
                 // Button just released
                 pressed[idx] = 0;
                 button_pressed_state[idx] = 0;  // Update shared state for encoder task
                 ESP_LOGI(TAG, "Button %d UP", idx + 1);
-                EventSystem_PostEvent(EVENT_UI_BUTTON_UP, (1 << idx), NULL);
+                EventSystem_PostEventAt(EVENT_UI_BUTTON_UP, (1 << idx), NULL, button_edge_us[idx]);
                 
                 // Set refractory period to avoid bounce
                 next_allowed[idx] = xTaskGetTickCount() + refractory_ticks;
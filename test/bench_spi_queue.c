@@ -0,0 +1,195 @@
+/* SPI transport on the host SPI master model: queued DMA ring throughput against blocking
+    writes, ns per Led_driver__Update_RAM and bytes per frame, and the completion time
+    Spi__Flush reports (post_cb stamps a slot before it is reclaimed; a flush with nothing
+    sent reports 0, not the previous completion).
+    Wire time is real time at the bus clock, so the numbers are host CPU against a modeled
+    bus: compare the two paths with each other, not with the target.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "host_spi.h"
+#include "esp_timer.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+#include "spi.h"
+
+// led_driver.c internals
+typedef struct {
+    uint16_t red[24];
+    uint16_t blue[24];
+} RAM_image_t;
+void bus_take(void);
+int64_t bus_give(void);
+uint16_t pack_RAM_stream(uint8_t*, const uint16_t*);
+void translate_view_to_RAM(const view_frame_t*, RAM_image_t*);
+extern spi_device_handle_t Spi_handles[LED_NUM_PANELS][2];
+
+#define BENCH_CLOCK_HZ      1000000
+#define BENCH_WRITES        (4 * SPI_QUEUE_SIZE)
+#define BENCH_FRAMES        50
+#define STREAM_BITS         394
+#define BENCH_RUNS          5       // Fastest run counts: the host scheduler only ever adds time
+
+static uint8_t Stream[52];
+
+static void wait_frames(uint32_t num_frames) {
+    led_driver_stats_t stats;
+    int64_t give_up_us = esp_timer_get_time() + 5000000;
+    do {
+        Led_driver__Get_stats(&stats);
+    } while (stats.num_frames < num_frames && esp_timer_get_time() < give_up_us);
+}
+
+static uint64_t time_blocking(spi_device_handle_t device) {
+    bus_take();
+    uint64_t start_ns = test_now_ns();
+    for (uint16_t i = 0; i < BENCH_WRITES; i++) {
+        Spi__Write(device, Stream, STREAM_BITS);
+    }
+    uint64_t blocking_ns = test_now_ns() - start_ns;
+    bus_give();
+    return blocking_ns;
+}
+
+static uint64_t time_queued(spi_device_handle_t device, uint64_t *burst_ns) {
+    host_spi_reset_stats();
+    bus_take();
+    uint64_t start_ns = test_now_ns();
+    for (uint16_t i = 0; i < SPI_QUEUE_SIZE; i++) {
+        Spi__Queue_write(device, Stream, STREAM_BITS);
+    }
+    *burst_ns = test_now_ns() - start_ns;
+    for (uint16_t i = SPI_QUEUE_SIZE; i < BENCH_WRITES; i++) {
+        Spi__Queue_write(device, Stream, STREAM_BITS);
+    }
+    uint64_t queued_ns = test_now_ns() - start_ns;
+    bus_give();
+    return queued_ns;
+}
+
+// Ring against one transaction at a time, same bits
+static void bench_ring(void) {
+    spi_device_handle_t device = Spi_handles[0][0];
+    host_spi_stats_t bus;
+    uint64_t wire_ns = (uint64_t)STREAM_BITS * 1000000000ULL / BENCH_CLOCK_HZ;
+    uint64_t blocking_ns = UINT64_MAX;
+    uint64_t queued_ns = UINT64_MAX;
+    uint64_t burst_ns = UINT64_MAX;
+
+    for (uint8_t run = 0; run < BENCH_RUNS; run++) {
+        uint64_t run_burst_ns;
+        uint64_t ns = time_blocking(device);
+        blocking_ns = (ns < blocking_ns) ? ns : blocking_ns;
+        ns = time_queued(device, &run_burst_ns);
+        queued_ns = (ns < queued_ns) ? ns : queued_ns;
+        burst_ns = (run_burst_ns < burst_ns) ? run_burst_ns : burst_ns;
+    }
+    host_spi_get_stats(&bus);
+
+    printf("%u writes of %u bits at %u Hz (wire %llu us each)\n", BENCH_WRITES, STREAM_BITS, BENCH_CLOCK_HZ,
+           (unsigned long long)(wire_ns / 1000));
+    printf("  blocking: %8llu us, %6llu kbit/s\n", (unsigned long long)(blocking_ns / 1000),
+           (unsigned long long)((uint64_t)BENCH_WRITES * STREAM_BITS * 1000000ULL / blocking_ns));
+    printf("  queued:   %8llu us, %6llu kbit/s, caller blocked %llu us for a %u deep burst, %u in flight at most\n",
+           (unsigned long long)(queued_ns / 1000),
+           (unsigned long long)((uint64_t)BENCH_WRITES * STREAM_BITS * 1000000ULL / queued_ns),
+           (unsigned long long)(burst_ns / 1000), SPI_QUEUE_SIZE, bus.max_queued);
+
+    // A burst that fits the ring does not wait for the wire
+    CHECK(burst_ns < wire_ns * SPI_QUEUE_SIZE / 2);
+    CHECK(bus.max_queued <= SPI_QUEUE_SIZE);
+    CHECK_EQ(bus.num_transactions, BENCH_WRITES);
+    // Back to back on the wire: no slower than waiting for each one
+    CHECK(queued_ns <= blocking_ns + blocking_ns / 10);
+}
+
+static void check_flush_time(void) {
+    spi_device_handle_t device = Spi_handles[0][0];
+    uint64_t wire_us = (uint64_t)STREAM_BITS * 1000000ULL / BENCH_CLOCK_HZ;
+
+    bus_take();
+    int64_t start_us = esp_timer_get_time();
+    for (uint8_t i = 0; i < 4; i++) {
+        Spi__Queue_write(device, Stream, STREAM_BITS);
+    }
+    int64_t done_us = Spi__Flush();
+    int64_t now_us = esp_timer_get_time();
+    // Nothing sent since: no completion time, not the one above again
+    int64_t empty_us = Spi__Flush();
+    bus_give();
+
+    CHECK(done_us >= start_us + (int64_t)(4 * wire_us));
+    CHECK(done_us <= now_us);
+    CHECK_EQ(empty_us, 0);
+}
+
+static void bench_update_RAM(void) {
+    view_frame_t frame;
+    led_driver_stats_t stats;
+    uint32_t seed = 0x5EED;
+    uint64_t update_ns = 0;
+    uint64_t bytes = 0;
+
+    Led_driver__Get_stats(&stats);
+    uint32_t num_frames = stats.num_frames;
+    for (uint16_t i = 0; i < BENCH_FRAMES; i++) {
+        for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+            frame.rows[row] = (uint16_t)test_random(&seed);
+        }
+        uint64_t start_ns = test_now_ns();
+        Led_driver__Update_RAM(&frame);
+        update_ns += test_now_ns() - start_ns;
+
+        wait_frames(++num_frames);
+        Led_driver__Get_stats(&stats);
+        bytes += stats.bytes_per_frame;
+    }
+    printf("Led_driver__Update_RAM: %llu ns per call, %llu bytes per frame, last frame %lu us on the wire\n",
+           (unsigned long long)(update_ns / BENCH_FRAMES), (unsigned long long)(bytes / BENCH_FRAMES),
+           (unsigned long)(stats.last_frame_ns / 1000));
+    CHECK_EQ(stats.num_frames, num_frames);
+
+    // Chips hold the last frame
+    RAM_image_t expected;
+    uint16_t rows[LED_EMULATOR_RAM_ROWS];
+    translate_view_to_RAM(&frame, &expected);
+    Led_emulator__Get_RAM_rows(CS_RED, rows);
+    CHECK(memcmp(rows, expected.red, sizeof(rows)) == 0);
+    Led_emulator__Get_RAM_rows(CS_BLUE, rows);
+    CHECK(memcmp(rows, expected.blue, sizeof(rows)) == 0);
+
+    // Same frame again: nothing to send, and the frame time must not go negative
+    Led_driver__Update_RAM(&frame);
+    wait_frames(++num_frames);
+    Led_driver__Get_stats(&stats);
+    CHECK_EQ(stats.transactions_per_frame, 0);
+    CHECK(stats.last_frame_ns < 1000000000);
+
+    // Chip RAM invalidated: the same frame is written in full to every chip
+    Led_driver__Invalidate_RAM();
+    Led_driver__Update_RAM(&frame);
+    wait_frames(++num_frames);
+    Led_driver__Get_stats(&stats);
+    CHECK_EQ(stats.transactions_per_frame, 2 * LED_NUM_PANELS);
+    CHECK_EQ(stats.bits_per_frame, 2 * LED_NUM_PANELS * STREAM_BITS);
+}
+
+int main(void) {
+    uint16_t RAM[24];
+    for (uint8_t row = 0; row < 24; row++) {
+        RAM[row] = 0xA55A ^ (row * 0x1111);
+    }
+    CHECK_EQ(pack_RAM_stream(Stream, RAM), STREAM_BITS);
+
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+    Led_driver__Set_clock_hz(BENCH_CLOCK_HZ);
+
+    bench_ring();
+    check_flush_time();
+    bench_update_RAM();
+    return TEST_RESULT();
+}
@@ -0,0 +1,87 @@
+/* Stand-ins for the firmware modules the host tests leave out (network, BLE, input).
+    Views call into these; nothing here has behavior beyond a fixed answer, except
+    Mqtt__Publish which keeps the last message so tests can look at it.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "view.h"
+#include "mqtt.h"
+#include "local_time.h"
+#include "provisioning.h"
+#include "ui.h"
+#include "ble_sensor_view.h"
+#include "host_stubs.h"
+
+TaskHandle_t periodicTaskHandle = NULL;
+
+host_mqtt_message_t Host_last_publish;
+
+// MQTT
+
+bool Mqtt__Is_connected(void) {
+    return false;
+}
+
+bool Mqtt__Is_offline(void) {
+    return true;
+}
+
+void Mqtt__Publish(char *topic, const uint8_t *data, uint16_t data_len) {
+    snprintf(Host_last_publish.topic, sizeof(Host_last_publish.topic), "%s", topic);
+    Host_last_publish.len = (data_len < sizeof(Host_last_publish.data)) ? data_len : sizeof(Host_last_publish.data);
+    memcpy(Host_last_publish.data, data, Host_last_publish.len);
+    Host_last_publish.count++;
+}
+
+void Mqtt__Send_debug_msg(char *msg) {
+}
+
+// LOCAL TIME: a fixed Wednesday
+
+uint8_t Local_Time__Get_letter_day_of_week(void) {
+    return 'W';
+}
+
+void Local_Time__Get_current_time_str(char *str) {
+    strcpy(str, "12:00");
+}
+
+// PROVISIONING
+
+int Provisioning__Is_Active(void) {
+    return 0;
+}
+
+// UI
+
+uint8_t Ui__Is_Button_Pressed(uint8_t button_num) {
+    return NOT_PRESSED;
+}
+
+// BLE SENSOR VIEW (needs Bluedroid): blank
+
+void Ble_Sensor_View__Initialize(void) {
+}
+
+void Ble_Sensor_View__Get_frame(view_frame_t *frame) {
+    memset(frame, 0, sizeof(*frame));
+}
+
+void Ble_Sensor_View__UI_Button(uint8_t btn) {
+}
+
+void Ble_Sensor_View__UI_Encoder_Top(uint8_t direction) {
+}
+
+void Ble_Sensor_View__UI_Encoder_Side(uint8_t direction) {
+}
+
+uint32_t Ble_Sensor_View__Get_refresh_rate_ms(void) {
+    return 0;
+}
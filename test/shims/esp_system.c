@@ -0,0 +1,120 @@
+/* Host versions of the small ESP-IDF services: log, random, CPU cycles, ROM delay, heap */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_cpu.h"
+#include "esp_system.h"
+#include "esp_rom_sys.h"
+#include "esp_heap_caps.h"
+
+esp_log_level_t host_log_level = ESP_LOG_WARN;
+
+static pthread_mutex_t Log_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t Random_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t Random_state = 0x853C49E6748FEA9BULL;
+
+// LOG
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    pthread_mutex_lock(&Log_lock);
+    vfprintf(stdout, format, args);
+    fflush(stdout);
+    pthread_mutex_unlock(&Log_lock);
+    va_end(args);
+}
+
+uint32_t esp_log_timestamp(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        default: return "UNKNOWN ERROR";
+    }
+}
+
+// RANDOM: splitmix64, so a run is repeatable from its seed
+
+uint32_t esp_random(void) {
+    pthread_mutex_lock(&Random_lock);
+    uint64_t z = (Random_state += 0x9E3779B97F4A7C15ULL);
+    pthread_mutex_unlock(&Random_lock);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+void esp_fill_random(void *buf, size_t len) {
+    uint8_t *out = buf;
+    for (size_t i = 0; i < len; i++) {
+        out[i] = (uint8_t)esp_random();
+    }
+}
+
+void host_random_seed(uint32_t seed) {
+    pthread_mutex_lock(&Random_lock);
+    Random_state = seed;
+    pthread_mutex_unlock(&Random_lock);
+}
+
+// CPU
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t ns = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+    return (esp_cpu_cycle_count_t)(ns * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ / 1000);
+}
+
+void esp_rom_delay_us(uint32_t us) {
+    int64_t until = esp_timer_get_time() + us;
+    while (esp_timer_get_time() < until) {
+    }
+}
+
+uint32_t esp_rom_get_cpu_ticks_per_us(void) {
+    return CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+}
+
+// SYSTEM
+
+void esp_restart(void) {
+    fprintf(stderr, "esp_restart\n");
+    exit(1);
+}
+
+uint32_t esp_get_free_heap_size(void) {
+    return 256 * 1024;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+    return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    return calloc(n, size);
+}
+
+void heap_caps_free(void *ptr) {
+    free(ptr);
+}
@@ -0,0 +1,191 @@
+/* Host esp_timer: one dispatcher thread runs every callback, earliest alarm first.
+    Time is CLOCK_MONOTONIC in us since the first call, like esp_timer_get_time counts
+    from boot.
+*/
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "esp_timer.h"
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+    int64_t alarm_us;
+    uint64_t period_us;         // 0: one shot
+    uint8_t armed;
+    struct esp_timer *next;     // All timers, armed or not
+};
+
+static pthread_mutex_t Lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Cond;
+static pthread_once_t Once = PTHREAD_ONCE_INIT;
+static pthread_t Dispatcher;
+static struct esp_timer *Timers;
+static struct timespec Start;
+
+// PRIVATE method prototypes
+static void init(void);
+static void *dispatcher(void *arg);
+static struct esp_timer *earliest(void);
+static esp_err_t start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us);
+
+// PUBLIC methods
+
+int64_t esp_timer_get_time(void) {
+    pthread_once(&Once, init);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - Start.tv_sec) * 1000000 + (now.tv_nsec - Start.tv_nsec) / 1000;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle) {
+    if (!create_args || !create_args->callback || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_once(&Once, init);
+    struct esp_timer *timer = calloc(1, sizeof(*timer));
+    if (!timer) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    timer->name = create_args->name;
+
+    pthread_mutex_lock(&Lock);
+    timer->next = Timers;
+    Timers = timer;
+    pthread_mutex_unlock(&Lock);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    return start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+    return start(timer, period, period);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&Lock);
+    esp_err_t err = timer->armed ? ESP_OK : ESP_ERR_INVALID_STATE;
+    timer->armed = 0;
+    pthread_mutex_unlock(&Lock);
+    return err;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&Lock);
+    if (timer->armed) {
+        pthread_mutex_unlock(&Lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (struct esp_timer **link = &Timers; *link; link = &(*link)->next) {
+        if (*link == timer) {
+            *link = timer->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&Lock);
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+    pthread_mutex_lock(&Lock);
+    bool armed = timer && timer->armed;
+    pthread_mutex_unlock(&Lock);
+    return armed;
+}
+
+// PRIVATE METHODS
+
+static void init(void) {
+    clock_gettime(CLOCK_MONOTONIC, &Start);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&Cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_create(&Dispatcher, NULL, dispatcher, NULL);
+    pthread_detach(Dispatcher);
+}
+
+// Callbacks run without the lock, so they can start and stop timers (their own too)
+static void *dispatcher(void *arg) {
+    pthread_mutex_lock(&Lock);
+    for (;;) {
+        struct esp_timer *timer = earliest();
+        if (!timer) {
+            pthread_cond_wait(&Cond, &Lock);
+            continue;
+        }
+        int64_t now = esp_timer_get_time();
+        if (timer->alarm_us > now) {
+            struct timespec deadline = Start;
+            deadline.tv_sec += timer->alarm_us / 1000000;
+            deadline.tv_nsec += (timer->alarm_us % 1000000) * 1000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&Cond, &Lock, &deadline);
+            continue;
+        }
+
+        if (timer->period_us) {
+            timer->alarm_us += timer->period_us;
+            // Fell behind (debugger, loaded host): skip the missed periods
+            if (timer->alarm_us < now) {
+                timer->alarm_us = now + timer->period_us;
+            }
+        } else {
+            timer->armed = 0;
+        }
+        esp_timer_cb_t callback = timer->callback;
+        void *callback_arg = timer->arg;
+        pthread_mutex_unlock(&Lock);
+        callback(callback_arg);
+        pthread_mutex_lock(&Lock);
+    }
+    return NULL;
+}
+
+static struct esp_timer *earliest(void) {
+    struct esp_timer *first = NULL;
+    for (struct esp_timer *timer = Timers; timer; timer = timer->next) {
+        if (timer->armed && (!first || timer->alarm_us < first->alarm_us)) {
+            first = timer;
+        }
+    }
+    return first;
+}
+
+static esp_err_t start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us) {
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int64_t now = esp_timer_get_time();
+    pthread_mutex_lock(&Lock);
+    if (timer->armed) {
+        pthread_mutex_unlock(&Lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->alarm_us = now + (int64_t)timeout_us;
+    timer->period_us = period_us;
+    timer->armed = 1;
+    pthread_cond_broadcast(&Cond);
+    pthread_mutex_unlock(&Lock);
+    return ESP_OK;
+}
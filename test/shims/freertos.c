@@ -0,0 +1,799 @@
+/* FreeRTOS API on POSIX threads for the host tests (see freertos/FreeRTOS.h).
+    Blocking calls wait on condition variables with CLOCK_MONOTONIC deadlines; a tick is
+    portTICK_PERIOD_MS of wall time. Threads that were not created as tasks (the test's
+    main) get a task record the first time they use a task API, so they can wait for
+    notifications and hold mutexes too.
+*/
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "freertos/timers.h"
+#include "esp_timer.h"
+
+#define HOST_MAX_TASKS          64
+#define HOST_STACK_PAINT        0xA5
+// Host frames are not target frames: every task runs on a stack this much bigger than
+// its configured depth, and the high water mark tells how much of the depth it used
+#define HOST_STACK_EXTRA        (256 * 1024)
+
+struct tskTaskControlBlock {
+    pthread_t thread;
+    char name[configMAX_TASK_NAME_LEN];
+    TaskFunction_t function;
+    void *param;
+    UBaseType_t priority;
+    BaseType_t core;
+    UBaseType_t number;
+    uint8_t is_thread;          // Adopted thread (not created through xTaskCreate*)
+    uint8_t deleted;
+
+    uint32_t stack_depth;
+    uint8_t *stack;             // Host stack, painted below the entry frame
+    size_t stack_size;
+    uint8_t *stack_entry;       // Frame of the task function's caller
+    clockid_t cpu_clock;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify_value;
+    uint8_t notify_pending;
+};
+
+struct QueueDefinition {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint8_t *items;
+    UBaseType_t item_size;      // 0: semaphore
+    UBaseType_t length;
+    UBaseType_t count;
+    UBaseType_t head;
+    uint8_t is_mutex;
+    TaskHandle_t holder;
+};
+
+struct EventGroupDef_t {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    EventBits_t bits;
+};
+
+struct tmrTimerControl {
+    esp_timer_handle_t timer;
+    const char *name;
+    TickType_t period;
+    UBaseType_t auto_reload;
+    void *id;
+    TimerCallbackFunction_t callback;
+};
+
+static pthread_mutex_t Tasks_lock = PTHREAD_MUTEX_INITIALIZER;
+static TaskHandle_t Tasks[HOST_MAX_TASKS];
+static UBaseType_t Num_tasks;
+static UBaseType_t Next_task_number = 1;
+static __thread TaskHandle_t Current_task;
+
+static pthread_mutex_t Critical_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+// PRIVATE method prototypes
+static void init_cond(pthread_cond_t *cond);
+static struct timespec deadline_after(TickType_t ticks);
+static int wait_until(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, const struct timespec *deadline);
+static TaskHandle_t new_task(const char *name, uint32_t stack_depth, UBaseType_t priority, BaseType_t core);
+static void *task_entry(void *arg);
+static TaskHandle_t create_task(TaskFunction_t function, const char *name, uint32_t stack_depth, void *param,
+                                UBaseType_t priority, BaseType_t core);
+static QueueHandle_t new_queue(UBaseType_t length, UBaseType_t item_size);
+static BaseType_t queue_put(QueueHandle_t queue, const void *item, TickType_t ticks, uint8_t to_front);
+static BaseType_t queue_get(QueueHandle_t queue, void *item, TickType_t ticks, uint8_t peek);
+static uint32_t stack_used(TaskHandle_t task);
+static void timer_callback(void *arg);
+
+// CRITICAL SECTIONS
+
+void host_critical_enter(portMUX_TYPE *mux) {
+    pthread_mutex_lock(&Critical_lock);
+    if (mux) {
+        mux->count++;
+    }
+}
+
+void host_critical_exit(portMUX_TYPE *mux) {
+    if (mux) {
+        mux->count--;
+    }
+    pthread_mutex_unlock(&Critical_lock);
+}
+
+// TASKS
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth, void *param,
+                       UBaseType_t priority, TaskHandle_t *created_task) {
+    return xTaskCreatePinnedToCore(function, name, stack_depth, param, priority, created_task, tskNO_AFFINITY);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id) {
+    TaskHandle_t task = create_task(function, name, stack_depth, param, priority, core_id);
+    if (created_task) {
+        *created_task = task;
+    }
+    return task ? pdPASS : pdFAIL;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char *name, uint32_t stack_depth, void *param,
+                               UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb) {
+    return xTaskCreateStaticPinnedToCore(function, name, stack_depth, param, priority, stack, tcb, tskNO_AFFINITY);
+}
+
+// The caller's stack buffer only has to exist, the thread runs on a painted host stack
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth, void *param,
+                                           UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb, BaseType_t core_id) {
+    if (!stack || !tcb) {
+        return NULL;
+    }
+    return create_task(function, name, stack_depth, param, priority, core_id);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL || task == xTaskGetCurrentTaskHandle()) {
+        TaskHandle_t self = xTaskGetCurrentTaskHandle();
+        self->deleted = 1;
+        pthread_exit(NULL);
+    }
+    // Other tasks cannot be stopped from outside on the host; only mark them
+    task->deleted = 1;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec deadline = deadline_after(ticks);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment) {
+    xTaskDelayUntil(previous_wake, increment);
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *previous_wake, TickType_t increment) {
+    *previous_wake += increment;
+    int32_t remaining = (int32_t)(*previous_wake - xTaskGetTickCount());
+    if (remaining <= 0) {
+        return pdFALSE;
+    }
+    vTaskDelay((TickType_t)remaining);
+    return pdTRUE;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / (portTICK_PERIOD_MS * 1000));
+}
+
+TickType_t xTaskGetTickCountFromISR(void) {
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    if (Current_task == NULL) {
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "thread%lu", (unsigned long)Next_task_number);
+        Current_task = new_task(name, 0, 1, tskNO_AFFINITY);
+        if (Current_task) {
+            Current_task->thread = pthread_self();
+            Current_task->is_thread = 1;
+            pthread_getcpuclockid(Current_task->thread, &Current_task->cpu_clock);
+        }
+    }
+    return Current_task;
+}
+
+BaseType_t xTaskGetCoreID(TaskHandle_t task) {
+    task = task ? task : xTaskGetCurrentTaskHandle();
+    return task->core;
+}
+
+char *pcTaskGetName(TaskHandle_t task) {
+    task = task ? task : xTaskGetCurrentTaskHandle();
+    return task->name;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+    task = task ? task : xTaskGetCurrentTaskHandle();
+    return task->priority;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+    pthread_mutex_lock(&Tasks_lock);
+    UBaseType_t num_tasks = Num_tasks;
+    pthread_mutex_unlock(&Tasks_lock);
+    return num_tasks;
+}
+
+// Bytes of the configured depth never touched so far, 0 once the task went past it
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    task = task ? task : xTaskGetCurrentTaskHandle();
+    if (task->is_thread) {
+        return 0;
+    }
+    uint32_t used = stack_used(task);
+    return (used < task->stack_depth) ? (task->stack_depth - used) : 0;
+}
+
+// Nothing is filled unless every task fits, like FreeRTOS. Run time is thread CPU time
+// in us, the total is wall time since the first esp_timer use.
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t max_status, configRUN_TIME_COUNTER_TYPE *total_run_time) {
+    pthread_mutex_lock(&Tasks_lock);
+    if (max_status < Num_tasks) {
+        pthread_mutex_unlock(&Tasks_lock);
+        return 0;
+    }
+    UBaseType_t num_tasks = Num_tasks;
+    for (UBaseType_t i = 0; i < num_tasks; i++) {
+        TaskHandle_t task = Tasks[i];
+        struct timespec cpu = {0, 0};
+        clock_gettime(task->cpu_clock, &cpu);
+
+        memset(&status[i], 0, sizeof(status[i]));
+        status[i].xHandle = task;
+        status[i].pcTaskName = task->name;
+        status[i].xTaskNumber = task->number;
+        status[i].eCurrentState = task->deleted ? eDeleted : eBlocked;
+        status[i].uxCurrentPriority = task->priority;
+        status[i].uxBasePriority = task->priority;
+        status[i].ulRunTimeCounter = (configRUN_TIME_COUNTER_TYPE)((uint64_t)cpu.tv_sec * 1000000 + cpu.tv_nsec / 1000);
+        status[i].pxStackBase = task->stack;
+        status[i].xCoreID = task->core;
+    }
+    pthread_mutex_unlock(&Tasks_lock);
+
+    for (UBaseType_t i = 0; i < num_tasks; i++) {
+        status[i].usStackHighWaterMark = uxTaskGetStackHighWaterMark(status[i].xHandle);
+    }
+    if (total_run_time) {
+        *total_run_time = (configRUN_TIME_COUNTER_TYPE)esp_timer_get_time();
+    }
+    return num_tasks;
+}
+
+// NOTIFICATIONS
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    BaseType_t result = pdPASS;
+
+    pthread_mutex_lock(&task->lock);
+    switch (action) {
+        case eSetBits:
+            task->notify_value |= value;
+            break;
+        case eIncrement:
+            task->notify_value++;
+            break;
+        case eSetValueWithOverwrite:
+            task->notify_value = value;
+            break;
+        case eSetValueWithoutOverwrite:
+            if (task->notify_pending) {
+                result = pdFAIL;
+            } else {
+                task->notify_value = value;
+            }
+            break;
+        case eNoAction:
+        default:
+            break;
+    }
+    task->notify_pending = 1;
+    pthread_cond_broadcast(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return result;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t *woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xTaskNotify(task, value, action);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+    xTaskNotifyFromISR(task, 0, eIncrement, woken);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = deadline_after(ticks);
+    BaseType_t result = pdTRUE;
+
+    pthread_mutex_lock(&self->lock);
+    if (!self->notify_pending) {
+        self->notify_value &= ~clear_on_entry;
+    }
+    while (!self->notify_pending) {
+        if (wait_until(&self->cond, &self->lock, ticks, &deadline) != 0) {
+            break;
+        }
+    }
+    if (value) {
+        *value = self->notify_value;
+    }
+    if (self->notify_pending) {
+        self->notify_value &= ~clear_on_exit;
+    } else {
+        result = pdFALSE;
+    }
+    self->notify_pending = 0;
+    pthread_mutex_unlock(&self->lock);
+    return result;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&self->lock);
+    while (self->notify_value == 0) {
+        if (wait_until(&self->cond, &self->lock, ticks, &deadline) != 0) {
+            break;
+        }
+    }
+    uint32_t value = self->notify_value;
+    if (value) {
+        self->notify_value = clear_on_exit ? 0 : value - 1;
+    }
+    self->notify_pending = 0;
+    pthread_mutex_unlock(&self->lock);
+    return value;
+}
+
+// QUEUES AND SEMAPHORES
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    return new_queue(length, item_size);
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    if (queue) {
+        free(queue->items);
+        free(queue);
+    }
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queue_put(queue, item, ticks, 0);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queue_put(queue, item, ticks, 1);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return queue_put(queue, item, 0, 0);
+}
+
+// Length 1 queues only (mailbox), as in FreeRTOS
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item) {
+    pthread_mutex_lock(&queue->lock);
+    memcpy(queue->items, item, queue->item_size);
+    queue->head = 0;
+    queue->count = 1;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    return queue_get(queue, item, ticks, 0);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks) {
+    return queue_get(queue, item, ticks, 1);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->count = 0;
+    queue->head = 0;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return new_queue(1, 0);
+}
+
+// Created given, as in FreeRTOS
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    SemaphoreHandle_t mutex = new_queue(1, 0);
+    if (mutex) {
+        mutex->is_mutex = 1;
+        mutex->count = 1;
+    }
+    return mutex;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    SemaphoreHandle_t semaphore = new_queue(max_count, 0);
+    if (semaphore) {
+        semaphore->count = initial_count;
+    }
+    return semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    BaseType_t result = queue_get(semaphore, NULL, ticks, 0);
+    if (result == pdTRUE && semaphore->is_mutex) {
+        semaphore->holder = xTaskGetCurrentTaskHandle();
+    }
+    return result;
+}
+
+// Giving a mutex the caller does not hold is an error in FreeRTOS: abort so a test
+// catches it rather than silently corrupting the count
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    if (semaphore->is_mutex) {
+        if (semaphore->holder != xTaskGetCurrentTaskHandle()) {
+            fprintf(stderr, "xSemaphoreGive: mutex not held by %s\n", pcTaskGetName(NULL));
+            abort();
+        }
+        semaphore->holder = NULL;
+    }
+    return queue_put(semaphore, NULL, 0, 0);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return queue_put(semaphore, NULL, 0, 0);
+}
+
+BaseType_t xSemaphoreTakeFromISR(SemaphoreHandle_t semaphore, BaseType_t *woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return queue_get(semaphore, NULL, 0, 0);
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore) {
+    return uxQueueMessagesWaiting(semaphore);
+}
+
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t semaphore) {
+    return semaphore->is_mutex ? semaphore->holder : NULL;
+}
+
+// EVENT GROUPS
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    EventGroupHandle_t group = calloc(1, sizeof(*group));
+    if (group) {
+        pthread_mutex_init(&group->lock, NULL);
+        init_cond(&group->cond);
+    }
+    return group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->lock);
+    group->bits |= bits;
+    EventBits_t now = group->bits;
+    pthread_cond_broadcast(&group->cond);
+    pthread_mutex_unlock(&group->lock);
+    return now;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->lock);
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->lock);
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    pthread_mutex_lock(&group->lock);
+    EventBits_t bits = group->bits;
+    pthread_mutex_unlock(&group->lock);
+    return bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks) {
+    struct timespec deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&group->lock);
+    for (;;) {
+        EventBits_t set = group->bits & bits;
+        if (wait_for_all ? (set == bits) : (set != 0)) {
+            break;
+        }
+        if (wait_until(&group->cond, &group->lock, ticks, &deadline) != 0) {
+            break;
+        }
+    }
+    EventBits_t result = group->bits;
+    EventBits_t set = result & bits;
+    if (clear_on_exit && (wait_for_all ? (set == bits) : (set != 0))) {
+        group->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&group->lock);
+    return result;
+}
+
+// SOFTWARE TIMERS
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload, void *timer_id,
+                           TimerCallbackFunction_t callback) {
+    TimerHandle_t timer = calloc(1, sizeof(*timer));
+    if (!timer) {
+        return NULL;
+    }
+    timer->name = name;
+    timer->period = period;
+    timer->auto_reload = auto_reload;
+    timer->id = timer_id;
+    timer->callback = callback;
+
+    const esp_timer_create_args_t args = {
+        .callback = timer_callback,
+        .arg = timer,
+        .name = name,
+    };
+    if (esp_timer_create(&args, &timer->timer) != ESP_OK) {
+        free(timer);
+        return NULL;
+    }
+    return timer;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks) {
+    return xTimerReset(timer, ticks);
+}
+
+// (Re)start the period from now
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticks) {
+    uint64_t period_us = (uint64_t)timer->period * portTICK_PERIOD_MS * 1000;
+    esp_timer_stop(timer->timer);
+    esp_err_t err = timer->auto_reload ? esp_timer_start_periodic(timer->timer, period_us)
+                                       : esp_timer_start_once(timer->timer, period_us);
+    return (err == ESP_OK) ? pdPASS : pdFAIL;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks) {
+    esp_timer_stop(timer->timer);
+    return pdPASS;
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t ticks) {
+    timer->period = period;
+    return xTimerReset(timer, ticks);
+}
+
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks) {
+    esp_timer_stop(timer->timer);
+    esp_timer_delete(timer->timer);
+    free(timer);
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer) {
+    return esp_timer_is_active(timer->timer) ? pdTRUE : pdFALSE;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer) {
+    return timer->id;
+}
+
+// PRIVATE METHODS
+
+static void init_cond(pthread_cond_t *cond) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static struct timespec deadline_after(TickType_t ticks) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    if (ticks != portMAX_DELAY) {
+        uint64_t ns = (uint64_t)ticks * portTICK_PERIOD_MS * 1000000;
+        deadline.tv_sec += ns / 1000000000;
+        deadline.tv_nsec += ns % 1000000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+    return deadline;
+}
+
+// One wait on cond; non-zero once the deadline passed (ticks 0: immediately)
+static int wait_until(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, const struct timespec *deadline) {
+    if (ticks == 0) {
+        return ETIMEDOUT;
+    }
+    if (ticks == portMAX_DELAY) {
+        return pthread_cond_wait(cond, lock);
+    }
+    return pthread_cond_timedwait(cond, lock, deadline);
+}
+
+static TaskHandle_t new_task(const char *name, uint32_t stack_depth, UBaseType_t priority, BaseType_t core) {
+    TaskHandle_t task = calloc(1, sizeof(*task));
+    if (!task) {
+        return NULL;
+    }
+    snprintf(task->name, sizeof(task->name), "%s", name ? name : "");
+    task->stack_depth = stack_depth;
+    task->priority = priority;
+    task->core = core;
+    pthread_mutex_init(&task->lock, NULL);
+    init_cond(&task->cond);
+
+    pthread_mutex_lock(&Tasks_lock);
+    if (Num_tasks >= HOST_MAX_TASKS) {
+        pthread_mutex_unlock(&Tasks_lock);
+        free(task);
+        return NULL;
+    }
+    task->number = Next_task_number++;
+    Tasks[Num_tasks++] = task;
+    pthread_mutex_unlock(&Tasks_lock);
+    return task;
+}
+
+static void *task_entry(void *arg) {
+    TaskHandle_t task = arg;
+    Current_task = task;
+    task->stack_entry = __builtin_frame_address(0);
+    task->function(task->param);
+
+    // Returning from a task function is a bug on FreeRTOS
+    fprintf(stderr, "Task %s returned\n", task->name);
+    abort();
+    return NULL;
+}
+
+static TaskHandle_t create_task(TaskFunction_t function, const char *name, uint32_t stack_depth, void *param,
+                                UBaseType_t priority, BaseType_t core) {
+    if (!function || priority >= configMAX_PRIORITIES) {
+        return NULL;
+    }
+    TaskHandle_t task = new_task(name, stack_depth, priority, core);
+    if (!task) {
+        return NULL;
+    }
+    task->function = function;
+    task->param = param;
+    task->stack_size = stack_depth + HOST_STACK_EXTRA;
+    if (task->stack_size < PTHREAD_STACK_MIN) {
+        task->stack_size = PTHREAD_STACK_MIN;
+    }
+    task->stack = malloc(task->stack_size);
+    if (!task->stack) {
+        return NULL;
+    }
+    memset(task->stack, HOST_STACK_PAINT, task->stack_size);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, task->stack, task->stack_size);
+    int err = pthread_create(&task->thread, &attr, task_entry, task);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        return NULL;
+    }
+    pthread_getcpuclockid(task->thread, &task->cpu_clock);
+    return task;
+}
+
+static QueueHandle_t new_queue(UBaseType_t length, UBaseType_t item_size) {
+    QueueHandle_t queue = calloc(1, sizeof(*queue));
+    if (!queue) {
+        return NULL;
+    }
+    if (item_size > 0) {
+        queue->items = malloc((size_t)length * item_size);
+        if (!queue->items) {
+            free(queue);
+            return NULL;
+        }
+    }
+    queue->item_size = item_size;
+    queue->length = length;
+    pthread_mutex_init(&queue->lock, NULL);
+    init_cond(&queue->cond);
+    return queue;
+}
+
+static BaseType_t queue_put(QueueHandle_t queue, const void *item, TickType_t ticks, uint8_t to_front) {
+    struct timespec deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count >= queue->length) {
+        if (wait_until(&queue->cond, &queue->lock, ticks, &deadline) != 0) {
+            pthread_mutex_unlock(&queue->lock);
+            return errQUEUE_FULL;
+        }
+    }
+    if (queue->item_size > 0) {
+        UBaseType_t slot;
+        if (to_front) {
+            queue->head = (queue->head + queue->length - 1) % queue->length;
+            slot = queue->head;
+        } else {
+            slot = (queue->head + queue->count) % queue->length;
+        }
+        memcpy(&queue->items[slot * queue->item_size], item, queue->item_size);
+    }
+    queue->count++;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+static BaseType_t queue_get(QueueHandle_t queue, void *item, TickType_t ticks, uint8_t peek) {
+    struct timespec deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (wait_until(&queue->cond, &queue->lock, ticks, &deadline) != 0) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+    if (queue->item_size > 0 && item) {
+        memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    }
+    if (!peek) {
+        if (queue->item_size > 0) {
+            queue->head = (queue->head + 1) % queue->length;
+        }
+        queue->count--;
+        pthread_cond_broadcast(&queue->cond);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+// Painted bytes are scanned up from the bottom; everything from the first overwritten byte
+// to the task's entry frame has been used
+static uint32_t stack_used(TaskHandle_t task) {
+    if (!task->stack || !task->stack_entry) {
+        return 0;
+    }
+    uint8_t *low = task->stack;
+    while (low < task->stack_entry && *low == HOST_STACK_PAINT) {
+        low++;
+    }
+    return (uint32_t)(task->stack_entry - low);
+}
+
+static void timer_callback(void *arg) {
+    TimerHandle_t timer = arg;
+    timer->callback(timer);
+}
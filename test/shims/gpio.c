@@ -0,0 +1,65 @@
+/* Host GPIO: levels are remembered per pin, nothing else happens */
+
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "esp_rom_gpio.h"
+
+static uint8_t Levels[GPIO_NUM_MAX];
+static gpio_mode_t Modes[GPIO_NUM_MAX];
+
+esp_err_t gpio_config(const gpio_config_t *config) {
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        if (config->pin_bit_mask & (1ULL << pin)) {
+            Modes[pin] = config->mode;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num) {
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    Modes[gpio_num] = GPIO_MODE_INPUT;
+    Levels[gpio_num] = 0;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode) {
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    Modes[gpio_num] = mode;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    Levels[gpio_num] = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return 0;
+    }
+    return Levels[gpio_num];
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, gpio_pull_mode_t pull) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int flags) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args) {
+    return ESP_OK;
+}
+
+void esp_rom_gpio_connect_out_signal(uint32_t gpio_num, uint32_t signal_idx, bool out_inv, bool oen_inv) {
+}
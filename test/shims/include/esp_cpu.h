@@ -0,0 +1,12 @@
+#ifndef ESP_CPU_H
+#define ESP_CPU_H
+
+#include <stdint.h>
+
+// Host: monotonic clock scaled to CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, so cycle budgets and
+// profiles read in the same units as on the target (host speed, not target speed)
+typedef uint32_t esp_cpu_cycle_count_t;
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
+
+#endif
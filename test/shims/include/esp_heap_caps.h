@@ -0,0 +1,15 @@
+#ifndef ESP_HEAP_CAPS_H
+#define ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_DMA          (1 << 3)
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+#define MALLOC_CAP_DEFAULT      (1 << 12)
+
+void *heap_caps_malloc(size_t size, uint32_t caps);
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps);
+void heap_caps_free(void *ptr);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// Host log: "I (ms) tag: message" on stdout like the IDF console. Debug and verbose are
+// compiled in but only printed once host_log_level is raised.
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+extern esp_log_level_t host_log_level;
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+uint32_t esp_log_timestamp(void);
+
+#define ESP_LOG_LEVEL_LOCAL(level, letter, tag, format, ...) do {                                  \
+        if (host_log_level >= (level)) {                                                            \
+            esp_log_write(level, tag, letter " (%lu) %s: " format "\n",                             \
+                          (unsigned long)esp_log_timestamp(), tag, ##__VA_ARGS__);                  \
+        }                                                                                           \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_DEBUG, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)  ESP_LOG_LEVEL_LOCAL(ESP_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
+
+#endif
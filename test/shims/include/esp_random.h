@@ -0,0 +1,12 @@
+#ifndef ESP_RANDOM_H
+#define ESP_RANDOM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Host: deterministic sequence from host_random_seed, so unseeded runs repeat too
+uint32_t esp_random(void);
+void esp_fill_random(void *buf, size_t len);
+void host_random_seed(uint32_t seed);
+
+#endif
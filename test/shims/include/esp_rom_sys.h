@@ -0,0 +1,9 @@
+#ifndef ESP_ROM_SYS_H
+#define ESP_ROM_SYS_H
+
+#include <stdint.h>
+
+void esp_rom_delay_us(uint32_t us);
+uint32_t esp_rom_get_cpu_ticks_per_us(void);
+
+#endif
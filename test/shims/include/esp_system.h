@@ -0,0 +1,10 @@
+#ifndef ESP_SYSTEM_H
+#define ESP_SYSTEM_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+void esp_restart(void) __attribute__((noreturn));
+uint32_t esp_get_free_heap_size(void);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+/* Host FreeRTOS shim (test/shims/freertos.c).
+    Tasks are POSIX threads with the ESP-IDF FreeRTOS API on top: notifications, queues,
+    semaphores, event groups and software timers. Priorities and core affinity are
+    recorded for the stats but not enforced; the host schedules threads itself.
+    Critical sections are one recursive mutex for the whole process, so they exclude
+    each other like the spinlocks do, just without disabling interrupts.
+    Stack depth is in bytes like on ESP-IDF; stacks are painted so
+    uxTaskGetStackHighWaterMark reports what the task used (host frame sizes).
+*/
+
+typedef uint8_t StackType_t;    // ESP-IDF: stack depths are in bytes
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef struct QueueDefinition *QueueHandle_t;
+typedef QueueHandle_t SemaphoreHandle_t;
+typedef struct EventGroupDef_t *EventGroupHandle_t;
+typedef struct tmrTimerControl *TimerHandle_t;
+typedef TickType_t EventBits_t;
+typedef void (*TaskFunction_t)(void *);
+
+// Static task control block storage, contents unused on the host
+typedef struct {
+    uint8_t reserved[32];
+} StaticTask_t;
+
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED    {0, 0}
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+#define errQUEUE_FULL           ((BaseType_t)0)
+
+#define portMAX_DELAY           ((TickType_t)0xFFFFFFFF)
+#define configTICK_RATE_HZ      CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS      ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#define pdTICKS_TO_MS(ticks)    ((TickType_t)(((uint64_t)(ticks) * 1000U) / configTICK_RATE_HZ))
+
+#define configMINIMAL_STACK_SIZE        CONFIG_FREERTOS_IDLE_TASK_STACKSIZE
+#define configMAX_PRIORITIES            25
+#define configMAX_TASK_NAME_LEN         CONFIG_FREERTOS_MAX_TASK_NAME_LEN
+#define configUSE_TRACE_FACILITY        CONFIG_FREERTOS_USE_TRACE_FACILITY
+#define configGENERATE_RUN_TIME_STATS   CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+#define configRUN_TIME_COUNTER_TYPE     uint32_t
+#define configNUMBER_OF_CORES           2
+#define tskNO_AFFINITY                  ((BaseType_t)0x7FFFFFFF)
+
+#define BIT0    0x00000001
+#define BIT1    0x00000002
+#define BIT2    0x00000004
+#define BIT3    0x00000008
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+void host_critical_enter(portMUX_TYPE *mux);
+void host_critical_exit(portMUX_TYPE *mux);
+
+#define portENTER_CRITICAL(mux)         host_critical_enter(mux)
+#define portEXIT_CRITICAL(mux)          host_critical_exit(mux)
+#define portENTER_CRITICAL_ISR(mux)     host_critical_enter(mux)
+#define portEXIT_CRITICAL_ISR(mux)      host_critical_exit(mux)
+#define taskENTER_CRITICAL(mux)         host_critical_enter(mux)
+#define taskEXIT_CRITICAL(mux)          host_critical_exit(mux)
+#define taskENTER_CRITICAL_ISR(mux)     host_critical_enter(mux)
+#define taskEXIT_CRITICAL_ISR(mux)      host_critical_exit(mux)
+#define portYIELD_FROM_ISR(...)         do {} while (0)
+
+#endif
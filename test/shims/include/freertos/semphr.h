@@ -0,0 +1,18 @@
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include "queue.h"
+
+// Semaphores are queues without items, as in FreeRTOS. A mutex remembers its holder.
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *woken);
+BaseType_t xSemaphoreTakeFromISR(SemaphoreHandle_t semaphore, BaseType_t *woken);
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore);
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t semaphore);
+#define vSemaphoreDelete(semaphore)     vQueueDelete(semaphore)
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef enum {
+    eRunning,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid
+} eTaskState;
+
+typedef enum {
+    eNoAction,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite
+} eNotifyAction;
+
+typedef struct {
+    TaskHandle_t xHandle;
+    const char *pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    configRUN_TIME_COUNTER_TYPE ulRunTimeCounter;
+    StackType_t *pxStackBase;
+    uint32_t usStackHighWaterMark;
+    BaseType_t xCoreID;
+} TaskStatus_t;
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth, void *param,
+                       UBaseType_t priority, TaskHandle_t *created_task);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id);
+TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char *name, uint32_t stack_depth, void *param,
+                               UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb);
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth, void *param,
+                                           UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb, BaseType_t core_id);
+void vTaskDelete(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment);
+BaseType_t xTaskDelayUntil(TickType_t *previous_wake, TickType_t increment);
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskGetCoreID(TaskHandle_t task);
+char *pcTaskGetName(TaskHandle_t task);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t max_status, configRUN_TIME_COUNTER_TYPE *total_run_time);
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t *woken);
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks);
+#define xTaskNotifyGive(task)   xTaskNotify((task), 0, eIncrement)
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+
+#endif
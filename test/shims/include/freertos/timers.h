@@ -0,0 +1,19 @@
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include "FreeRTOS.h"
+
+// Software timers on the esp_timer dispatcher thread (the host has no timer service task)
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload, void *timer_id,
+                           TimerCallbackFunction_t callback);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks);
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticks);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks);
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t ticks);
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks);
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer);
+void *pvTimerGetTimerID(TimerHandle_t timer);
+
+#endif
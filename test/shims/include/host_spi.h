@@ -0,0 +1,17 @@
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <stdint.h>
+
+// Bus counters of the host SPI master model (driver/spi_master.h)
+typedef struct {
+    uint32_t num_transactions;
+    uint64_t num_bits;
+    uint64_t busy_us;           // Wire time of all transactions
+    uint32_t max_queued;        // Most transactions queued at once (all devices)
+} host_spi_stats_t;
+
+void host_spi_get_stats(host_spi_stats_t *stats);
+void host_spi_reset_stats(void);
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef HOST_STUBS_H
+#define HOST_STUBS_H
+
+#include <stdint.h>
+
+// Last Mqtt__Publish seen by the host stub (shims/app_stubs.c)
+typedef struct {
+    char topic[64];
+    uint8_t data[2048];
+    uint16_t len;
+    uint32_t count;
+} host_mqtt_message_t;
+
+extern host_mqtt_message_t Host_last_publish;
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef LED_PANELS_HOST_H
+#define LED_PANELS_HOST_H
+
+/* Panel chains for the multi-panel host builds, picked by HOST_NUM_PANELS. Force-included
+    after sdkconfig.h by those targets (test/CMakeLists.txt) so led_driver.h takes this
+    LED_PANELS instead of its single panel default. Chip selects as the led_driver.h example,
+    every chip but the first red one follows SYNC.
+*/
+
+#define HOST_PANEL(red, blue)   { .cs_red = red, .cs_blue = blue, .sync_red = SET_SLAVE, .sync_blue = SET_SLAVE }
+
+#if HOST_NUM_PANELS == 2
+#define LED_NUM_PANELS  2
+#define LED_PANELS      { \
+    { .cs_red = CS_RED, .cs_blue = CS_BLUE, .sync_red = SET_MASTER, .sync_blue = SET_SLAVE }, \
+    HOST_PANEL(6, 5), \
+}
+#elif HOST_NUM_PANELS == 4
+#define LED_NUM_PANELS  4
+#define LED_PANELS      { \
+    { .cs_red = CS_RED, .cs_blue = CS_BLUE, .sync_red = SET_MASTER, .sync_blue = SET_SLAVE }, \
+    HOST_PANEL(6, 5), \
+    HOST_PANEL(4, 3), \
+    HOST_PANEL(2, 1), \
+}
+#else
+#error "HOST_NUM_PANELS must be 2 or 4"
+#endif
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+/* Host build configuration.
+    Mirrors the sdkconfig values the firmware sources read, with the IDF "linux" target
+    selected so the LED driver defaults to the emulator transport and bit bang to its
+    pin trace. Force-included into every host translation unit (test/CMakeLists.txt).
+*/
+
+#define CONFIG_IDF_TARGET_LINUX                     1
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ             160
+#define CONFIG_FREERTOS_HZ                          100
+#define CONFIG_FREERTOS_IDLE_TASK_STACKSIZE         1536
+#define CONFIG_FREERTOS_MAX_TASK_NAME_LEN           16
+#define CONFIG_FREERTOS_USE_TRACE_FACILITY          1
+#define CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS     1
+#define CONFIG_LED_PANEL_WIRING_REV1                1
+#define CONFIG_LED_CURRENT_BUDGET_MA                0
+
+#endif
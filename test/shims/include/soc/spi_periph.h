@@ -0,0 +1,14 @@
+#ifndef SOC_SPI_PERIPH_H
+#define SOC_SPI_PERIPH_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t spiclk_out;
+    uint32_t spid_out;
+    uint32_t spics_out[6];
+} spi_signal_conn_t;
+
+extern const spi_signal_conn_t spi_periph_signal[3];
+
+#endif
@@ -0,0 +1,235 @@
+/* Host SPI master model (see driver/spi_master.h).
+    One bus, one "DMA" thread. Transactions of every device go out in the order they were
+    queued; each is held for its wire time at the device clock (bits / clock_hz) before
+    post_cb runs and it lands in its device's done queue. Bits go to the emulated chip on
+    the device's CS pin, at that clock, so emulator error injection applies as on the wire.
+*/
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "driver/spi_master.h"
+#include "soc/spi_periph.h"
+#include "host_spi.h"
+#include "led_emulator.h"
+
+#define HOST_SPI_MAX_QUEUED     64
+
+struct spi_device_t {
+    spi_device_interface_config_t config;
+    spi_transaction_t *done[HOST_SPI_MAX_QUEUED];   // Finished, not collected yet
+    uint8_t done_head;
+    uint8_t done_count;
+    uint8_t in_flight;          // Queued or done, not collected yet
+    uint8_t removed;
+};
+
+typedef struct {
+    spi_device_handle_t device;
+    spi_transaction_t *trans;
+} host_spi_queued_t;
+
+static pthread_mutex_t Lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Cond;             // Anything changed: queued, done, collected
+static pthread_once_t Once = PTHREAD_ONCE_INIT;
+static pthread_t Dma_thread;
+static host_spi_queued_t Queue[HOST_SPI_MAX_QUEUED];
+static uint8_t Queue_head;
+static uint8_t Queue_count;
+static uint8_t Bus_initialized;
+static host_spi_stats_t Stats;
+
+const spi_signal_conn_t spi_periph_signal[3] = {
+    {.spiclk_out = 0, .spid_out = 1},
+    {.spiclk_out = 63, .spid_out = 65},
+    {.spiclk_out = 101, .spid_out = 103},
+};
+
+// PRIVATE method prototypes
+static void init(void);
+static void *dma_thread(void *arg);
+static void wire_wait(uint64_t ns);
+
+// PUBLIC methods
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t *bus_config, spi_dma_chan_t dma_chan) {
+    pthread_once(&Once, init);
+    pthread_mutex_lock(&Lock);
+    esp_err_t err = Bus_initialized ? ESP_ERR_INVALID_STATE : ESP_OK;
+    Bus_initialized = 1;
+    pthread_mutex_unlock(&Lock);
+    return err;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host_id) {
+    pthread_mutex_lock(&Lock);
+    Bus_initialized = 0;
+    pthread_mutex_unlock(&Lock);
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host_id, const spi_device_interface_config_t *dev_config, spi_device_handle_t *handle) {
+    if (!dev_config || !handle || dev_config->clock_speed_hz <= 0 || dev_config->queue_size > HOST_SPI_MAX_QUEUED) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    spi_device_handle_t device = calloc(1, sizeof(*device));
+    if (!device) {
+        return ESP_ERR_NO_MEM;
+    }
+    device->config = *dev_config;
+    *handle = device;
+    return ESP_OK;
+}
+
+// Like the IDF, a device with transactions not collected yet cannot be removed
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle) {
+    pthread_mutex_lock(&Lock);
+    if (handle->in_flight) {
+        pthread_mutex_unlock(&Lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->removed = 1;
+    pthread_mutex_unlock(&Lock);
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans_desc, TickType_t ticks_to_wait) {
+    pthread_mutex_lock(&Lock);
+    while (handle->in_flight >= handle->config.queue_size || Queue_count >= HOST_SPI_MAX_QUEUED) {
+        if (ticks_to_wait == 0) {
+            pthread_mutex_unlock(&Lock);
+            return ESP_ERR_TIMEOUT;
+        }
+        pthread_cond_wait(&Cond, &Lock);
+    }
+    Queue[(Queue_head + Queue_count) % HOST_SPI_MAX_QUEUED] = (host_spi_queued_t){handle, trans_desc};
+    Queue_count++;
+    handle->in_flight++;
+    if (Queue_count > Stats.max_queued) {
+        Stats.max_queued = Queue_count;
+    }
+    pthread_cond_broadcast(&Cond);
+    pthread_mutex_unlock(&Lock);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc, TickType_t ticks_to_wait) {
+    pthread_mutex_lock(&Lock);
+    while (handle->done_count == 0) {
+        if (ticks_to_wait == 0) {
+            pthread_mutex_unlock(&Lock);
+            return ESP_ERR_TIMEOUT;
+        }
+        pthread_cond_wait(&Cond, &Lock);
+    }
+    *trans_desc = handle->done[handle->done_head];
+    handle->done_head = (handle->done_head + 1) % HOST_SPI_MAX_QUEUED;
+    handle->done_count--;
+    handle->in_flight--;
+    pthread_cond_broadcast(&Cond);
+    pthread_mutex_unlock(&Lock);
+    return ESP_OK;
+}
+
+// The IDF forbids mixing these with queued transactions not collected yet; so does the model
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc) {
+    if (handle->in_flight) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    spi_transaction_t *done;
+    esp_err_t err = spi_device_queue_trans(handle, trans_desc, portMAX_DELAY);
+    if (err == ESP_OK) {
+        err = spi_device_get_trans_result(handle, &done, portMAX_DELAY);
+    }
+    return err;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc) {
+    return spi_device_transmit(handle, trans_desc);
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t device, TickType_t wait) {
+    return ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t dev) {
+}
+
+void host_spi_get_stats(host_spi_stats_t *stats) {
+    pthread_mutex_lock(&Lock);
+    *stats = Stats;
+    pthread_mutex_unlock(&Lock);
+}
+
+void host_spi_reset_stats(void) {
+    pthread_mutex_lock(&Lock);
+    memset(&Stats, 0, sizeof(Stats));
+    pthread_mutex_unlock(&Lock);
+}
+
+// PRIVATE METHODS
+
+static void init(void) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&Cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_create(&Dma_thread, NULL, dma_thread, NULL);
+    pthread_detach(Dma_thread);
+}
+
+static void *dma_thread(void *arg) {
+    pthread_mutex_lock(&Lock);
+    for (;;) {
+        while (Queue_count == 0) {
+            pthread_cond_wait(&Cond, &Lock);
+        }
+        host_spi_queued_t queued = Queue[Queue_head];
+        const spi_device_interface_config_t *config = &queued.device->config;
+        spi_transaction_t *trans = queued.trans;
+        pthread_mutex_unlock(&Lock);
+
+        if (config->pre_cb) {
+            config->pre_cb(trans);
+        }
+        uint64_t wire_ns = (uint64_t)trans->length * 1000000000ULL / (uint32_t)config->clock_speed_hz;
+        wire_wait(wire_ns);
+        if (trans->length > 0) {
+            const uint8_t *tx = (trans->flags & SPI_TRANS_USE_TXDATA) ? trans->tx_data : trans->tx_buffer;
+            Led_emulator__Set_clock_hz((uint32_t)config->clock_speed_hz);
+            Led_emulator__Write((uint8_t)config->spics_io_num, (uint8_t *)tx, (uint16_t)trans->length);
+        }
+        if (config->post_cb) {
+            config->post_cb(trans);
+        }
+
+        pthread_mutex_lock(&Lock);
+        Queue_head = (Queue_head + 1) % HOST_SPI_MAX_QUEUED;
+        Queue_count--;
+        spi_device_handle_t device = queued.device;
+        device->done[(device->done_head + device->done_count) % HOST_SPI_MAX_QUEUED] = trans;
+        device->done_count++;
+        Stats.num_transactions++;
+        Stats.num_bits += trans->length;
+        Stats.busy_us += wire_ns / 1000;
+        pthread_cond_broadcast(&Cond);
+    }
+    return NULL;
+}
+
+static void wire_wait(uint64_t ns) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += ns / 1000000000;
+    deadline.tv_nsec += ns % 1000000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+}
@@ -0,0 +1,188 @@
+/* Bit bang transport against the pin trace of the host mock (virtual ns time, see
+    bit_bang.h): setup / hold / CS timing of every edge, the level the chip latches on each
+    rising clock, and what the emulated chips decode from a whole frame sent by the driver.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "esp_timer.h"
+#include "bit_bang.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+
+// led_driver.c internals
+typedef struct {
+    uint16_t red[24];
+    uint16_t blue[24];
+} RAM_image_t;
+void translate_view_to_RAM(const view_frame_t*, RAM_image_t*);
+
+typedef struct {
+    uint16_t num_bits;
+    uint32_t min_low_ns;        // Clock low before each rising edge (data setup)
+    uint32_t min_high_ns;       // Clock high after each rising edge (hold)
+    uint32_t cs_setup_ns;       // CS low to the first clock edge
+    uint32_t cs_hold_ns;        // Last rising edge to CS high
+    uint8_t data_changes_while_high;
+    uint8_t bits[64];           // Data level at each rising edge, wire order
+} waveform_t;
+
+// Walk the trace of one CS low .. high window
+static void decode_trace(uint8_t cs_pin, waveform_t *wave) {
+    const bit_bang_edge_t *trace;
+    uint16_t count = Bit_bang__Get_trace(&trace);
+    uint8_t clk = CLK_HI;
+    uint8_t data = 0;
+    uint32_t cs_low_ns = 0;
+    uint32_t clk_fall_ns = 0;
+    uint32_t clk_rise_ns = 0;
+    uint8_t cs_active = 0;
+    uint8_t first_edge = 1;
+
+    memset(wave, 0, sizeof(*wave));
+    wave->min_low_ns = UINT32_MAX;
+    wave->min_high_ns = UINT32_MAX;
+    for (uint16_t i = 0; i < count; i++) {
+        const bit_bang_edge_t *edge = &trace[i];
+        if (edge->pin == cs_pin) {
+            if (edge->level == 0) {
+                cs_active = 1;
+                cs_low_ns = edge->t_ns;
+            } else if (cs_active) {
+                wave->cs_hold_ns = edge->t_ns - clk_rise_ns;
+                return;
+            }
+        } else if (edge->pin == DATA_PIN) {
+            if (cs_active && clk == CLK_HI && edge->level != data) {
+                wave->data_changes_while_high = 1;
+            }
+            data = edge->level;
+        } else if (edge->pin == CLK_PIN && cs_active) {
+            if (first_edge) {
+                wave->cs_setup_ns = edge->t_ns - cs_low_ns;
+                first_edge = 0;
+            }
+            if (edge->level == CLK_LO) {
+                if (wave->num_bits > 0 && edge->t_ns - clk_rise_ns < wave->min_high_ns) {
+                    wave->min_high_ns = edge->t_ns - clk_rise_ns;
+                }
+                clk_fall_ns = edge->t_ns;
+            } else {
+                if (edge->t_ns - clk_fall_ns < wave->min_low_ns) {
+                    wave->min_low_ns = edge->t_ns - clk_fall_ns;
+                }
+                clk_rise_ns = edge->t_ns;
+                if (wave->num_bits < sizeof(wave->bits)) {
+                    wave->bits[wave->num_bits] = data;
+                }
+                wave->num_bits++;
+            }
+            clk = edge->level;
+        }
+    }
+}
+
+// One command straight through the transport calls, default timing
+static void test_command_waveform(void) {
+    // 100 0000-0001 X: SYS_ON
+    uint8_t stream[2] = {0x80, 0x20};
+    const uint8_t expected[12] = {1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0};
+    waveform_t wave;
+
+    Led_emulator__Reset();
+    Bit_bang__Setup_cs(CS_RED);
+    Bit_bang__Setup(CLK_PIN, DATA_PIN);
+    Bit_bang__Clear_trace();
+    Bit_bang__Set_cs(CS_RED, CS_ACTIVE);
+    Bit_bang__Write(CLK_PIN, DATA_PIN, stream, 12);
+    Bit_bang__Set_cs(CS_RED, CS_INACTIVE);
+
+    decode_trace(CS_RED, &wave);
+    CHECK_EQ(wave.num_bits, 12);
+    CHECK(memcmp(wave.bits, expected, sizeof(expected)) == 0);
+    CHECK_EQ(wave.min_low_ns, BIT_BANG_SETUP_NS);
+    CHECK_EQ(wave.min_high_ns, BIT_BANG_HOLD_NS);
+    CHECK_EQ(wave.cs_setup_ns, BIT_BANG_CS_SETUP_NS);
+    CHECK(wave.cs_hold_ns >= BIT_BANG_CS_HOLD_NS);
+    CHECK(!wave.data_changes_while_high);
+
+    // Padding past num_bits is never clocked: the chip got exactly SYS_ON
+    const led_emulator_chip_t *chip = Led_emulator__Get_chip(CS_RED);
+    CHECK(chip != NULL);
+    if (chip) {
+        CHECK_EQ(chip->sys_on, 1);
+        CHECK_EQ(chip->num_bits, 12);
+        CHECK_EQ(chip->num_errors, 0);
+    }
+}
+
+// Clock changes go to the half periods
+static void test_clock_timing(void) {
+    uint8_t stream[2] = {0x80, 0x20};
+    waveform_t wave;
+
+    Led_driver__Set_clock_hz(100000);
+    Bit_bang__Clear_trace();
+    Bit_bang__Set_cs(CS_BLUE, CS_ACTIVE);
+    Bit_bang__Write(CLK_PIN, DATA_PIN, stream, 12);
+    Bit_bang__Set_cs(CS_BLUE, CS_INACTIVE);
+
+    decode_trace(CS_BLUE, &wave);
+    CHECK_EQ(wave.num_bits, 12);
+    CHECK_EQ(wave.min_low_ns, 5000);
+    CHECK_EQ(wave.min_high_ns, 5000);
+}
+
+// Whole frame through the driver: both chips decode the image translate_view_to_RAM makes
+static void test_frame(void) {
+    view_frame_t frame;
+    RAM_image_t expected;
+    uint16_t rows[LED_EMULATOR_RAM_ROWS];
+    led_driver_stats_t stats;
+    uint32_t seed = 99;
+
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        frame.rows[row] = (uint16_t)test_random(&seed);
+    }
+    Led_driver__Get_stats(&stats);
+    uint32_t num_frames = stats.num_frames;
+    Bit_bang__Clear_trace();
+    Led_driver__Update_RAM(&frame);
+    int64_t give_up_us = esp_timer_get_time() + 5000000;
+    while (stats.num_frames == num_frames && esp_timer_get_time() < give_up_us) {
+        Led_driver__Get_stats(&stats);
+    }
+    CHECK_EQ(stats.num_frames, num_frames + 1);
+
+    translate_view_to_RAM(&frame, &expected);
+    Led_emulator__Get_RAM_rows(CS_RED, rows);
+    CHECK(memcmp(rows, expected.red, sizeof(rows)) == 0);
+    Led_emulator__Get_RAM_rows(CS_BLUE, rows);
+    CHECK(memcmp(rows, expected.blue, sizeof(rows)) == 0);
+
+    // Every bit of the frame is in the trace, one rising edge each
+    const bit_bang_edge_t *trace;
+    uint16_t count = Bit_bang__Get_trace(&trace);
+    uint32_t rising = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        rising += (trace[i].pin == CLK_PIN && trace[i].level == CLK_HI);
+    }
+    CHECK(count < BIT_BANG_TRACE_LEN);
+    CHECK_EQ(rising, stats.bits_per_frame);
+}
+
+int main(void) {
+    test_command_waveform();
+
+    Led_emulator__Reset();
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+    const led_emulator_chip_t *chip = Led_emulator__Get_chip(CS_RED);
+    CHECK(chip && chip->sys_on && chip->led_on);
+
+    test_clock_timing();
+    test_frame();
+    return TEST_RESULT();
+}
@@ -0,0 +1,194 @@
+/* Blink in the LED driver. Led_driver__Set_blink sends the chip BLINK command. A region blink
+    (Led_driver__Set_blink_region) alternates the chip RAM between the frame and the frame with
+    the masked pixels cleared, with no frame handed over, and stops cleanly. After
+    Led_driver__Set_orientation the masked pixels are the rotated ones. Prints the bus cost of
+    a region blink phase against the software blink it replaces (a frame per phase).
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+
+// led_driver.c internals
+typedef struct {
+    uint16_t red[24];
+    uint16_t blue[24];
+} RAM_image_t;
+void translate_view_to_RAM(const view_frame_t*, RAM_image_t*);
+void translate_blink_mask(const view_frame_t*, RAM_image_t*);
+
+#define BLINK_PERIOD_MS     100
+#define NUM_PHASES          10
+#define CURSOR_ROW          2
+#define CURSOR_COL          5
+
+static void show_frame(const view_frame_t *frame) {
+    led_driver_stats_t stats;
+    view_frame_t copy = *frame;
+    Led_driver__Get_stats(&stats);
+    uint32_t num_frames = stats.num_frames;
+    Led_driver__Update_RAM(&copy);
+    int64_t give_up_us = esp_timer_get_time() + 5000000;
+    while (stats.num_frames == num_frames && esp_timer_get_time() < give_up_us) {
+        Led_driver__Get_stats(&stats);
+    }
+    vTaskDelay(2);
+}
+
+// Until the transmit task has written the next region blink phase
+static uint8_t wait_toggle(void) {
+    led_driver_stats_t stats;
+    Led_driver__Get_stats(&stats);
+    uint32_t num_toggles = stats.num_blink_toggles;
+    int64_t give_up_us = esp_timer_get_time() + 5000000;
+    while (stats.num_blink_toggles == num_toggles && esp_timer_get_time() < give_up_us) {
+        vTaskDelay(1);
+        Led_driver__Get_stats(&stats);
+    }
+    return stats.num_blink_toggles != num_toggles;
+}
+
+static void read_chips(RAM_image_t *ram) {
+    Led_emulator__Get_RAM_rows(CS_RED, ram->red);
+    Led_emulator__Get_RAM_rows(CS_BLUE, ram->blue);
+}
+
+static uint32_t bus_bits(void) {
+    return Led_emulator__Get_chip(CS_RED)->num_bits + Led_emulator__Get_chip(CS_BLUE)->num_bits;
+}
+
+// RAM of the frame as rendered and with the mask cleared, at the current orientation
+static void expected_banks(const view_frame_t *frame, const view_frame_t *mask, RAM_image_t *lit, RAM_image_t *dark) {
+    RAM_image_t RAM_mask;
+    translate_view_to_RAM(frame, lit);
+    translate_blink_mask(mask, &RAM_mask);
+    for (uint8_t row = 0; row < 24; row++) {
+        dark->red[row] = lit->red[row] & ~RAM_mask.red[row];
+        dark->blue[row] = lit->blue[row] & ~RAM_mask.blue[row];
+    }
+}
+
+static void make_frames(view_frame_t *frame, view_frame_t *mask) {
+    uint32_t seed = 0xB11C;
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        frame->rows[row] = (uint16_t)test_random(&seed);
+    }
+    frame->red[CURSOR_ROW] |= (uint16_t)(1 << CURSOR_COL);
+    memset(mask, 0, sizeof(*mask));
+    mask->red[CURSOR_ROW] = (uint16_t)(1 << CURSOR_COL);
+}
+
+static void test_chip_blink(void) {
+    Led_driver__Set_blink(1);
+    vTaskDelay(2);
+    CHECK(Led_emulator__Get_chip(CS_RED)->blink_on);
+    CHECK(Led_emulator__Get_chip(CS_BLUE)->blink_on);
+    Led_driver__Set_blink(0);
+    vTaskDelay(2);
+    CHECK(!Led_emulator__Get_chip(CS_RED)->blink_on);
+    CHECK(!Led_emulator__Get_chip(CS_BLUE)->blink_on);
+}
+
+// Every phase written is one of the two banks, they alternate, and no frame is sent
+static void check_phases(const RAM_image_t *lit, const RAM_image_t *dark, const char *what) {
+    RAM_image_t ram;
+    uint8_t num_dark = 0;
+    int8_t last_dark = -1;
+
+    for (uint8_t phase = 0; phase < NUM_PHASES; phase++) {
+        CHECK(wait_toggle());
+        read_chips(&ram);
+        int8_t is_dark = (memcmp(&ram, dark, sizeof(ram)) == 0);
+        if (!is_dark && memcmp(&ram, lit, sizeof(ram)) != 0) {
+            printf("FAIL %s phase %u: chip RAM is neither bank\n", what, phase);
+            Test_failures++;
+            return;
+        }
+        if (is_dark == last_dark) {
+            printf("FAIL %s phase %u: same bank twice\n", what, phase);
+            Test_failures++;
+        }
+        last_dark = is_dark;
+        num_dark += is_dark;
+    }
+    CHECK(num_dark >= NUM_PHASES / 2 - 1);
+}
+
+static void test_region_blink(void) {
+    view_frame_t frame;
+    view_frame_t mask;
+    view_frame_t dark_frame;
+    RAM_image_t lit;
+    RAM_image_t dark;
+    RAM_image_t ram;
+    led_driver_stats_t before;
+    led_driver_stats_t after;
+
+    make_frames(&frame, &mask);
+    show_frame(&frame);
+    expected_banks(&frame, &mask, &lit, &dark);
+
+    Led_driver__Get_stats(&before);
+    uint32_t bits = bus_bits();
+    Led_driver__Set_blink_region(&mask, BLINK_PERIOD_MS);
+    wait_toggle();      // The restore written on every new region
+    check_phases(&lit, &dark, "region");
+    Led_driver__Get_stats(&after);
+    uint32_t region_bits = bus_bits() - bits;
+    CHECK_EQ(after.num_frames, before.num_frames);
+
+    // Stopped: the frame as rendered comes back and stays
+    Led_driver__Set_blink_region(NULL, 0);
+    wait_toggle();
+    vTaskDelay(pdMS_TO_TICKS(BLINK_PERIOD_MS));
+    read_chips(&ram);
+    CHECK(memcmp(&ram, &lit, sizeof(ram)) == 0);
+
+    // Software blink: a frame per phase from the render side
+    dark_frame = frame;
+    dark_frame.red[CURSOR_ROW] &= (uint16_t)~(1 << CURSOR_COL);
+    Led_driver__Get_stats(&before);
+    bits = bus_bits();
+    for (uint8_t phase = 0; phase < NUM_PHASES + 1; phase++) {
+        show_frame((phase % 2) ? &frame : &dark_frame);
+    }
+    Led_driver__Get_stats(&after);
+    uint32_t software_bits = bus_bits() - bits;
+
+    printf("%u blink phases: region %lu bits, 0 frames; software %lu bits, %lu frames\n", NUM_PHASES + 1,
+           (unsigned long)region_bits, (unsigned long)software_bits, (unsigned long)(after.num_frames - before.num_frames));
+    CHECK(region_bits <= software_bits);
+}
+
+// Rotated mount: the region follows the pixel, not the chip RAM bit it used to be
+static void test_orientation(void) {
+    view_frame_t frame;
+    view_frame_t mask;
+    RAM_image_t lit;
+    RAM_image_t dark;
+
+    make_frames(&frame, &mask);
+    Led_driver__Set_blink_region(&mask, BLINK_PERIOD_MS);
+    Led_driver__Set_orientation(LED_ORIENT_90);
+    show_frame(&frame);
+    expected_banks(&frame, &mask, &lit, &dark);
+    check_phases(&lit, &dark, "rotated");
+
+    Led_driver__Set_blink_region(NULL, 0);
+    Led_driver__Set_orientation(LED_ORIENT_0);
+}
+
+int main(void) {
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+    test_chip_blink();
+    test_region_blink();
+    test_orientation();
+    return TEST_RESULT();
+}
@@ -0,0 +1,67 @@
+/* Clock calibration on the emulator transport, whose chips corrupt writes clocked above
+    LED_EMULATOR_ERROR_CLOCK_HZ: the driver must settle on the fastest step below it and
+    put the frame that was showing back on the chips afterwards.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "esp_timer.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+
+// led_driver.c internals
+typedef struct {
+    uint16_t red[24];
+    uint16_t blue[24];
+} RAM_image_t;
+void translate_view_to_RAM(const view_frame_t*, RAM_image_t*);
+
+static void wait_frames(uint32_t num_frames) {
+    led_driver_stats_t stats;
+    int64_t give_up_us = esp_timer_get_time() + 5000000;
+    do {
+        Led_driver__Get_stats(&stats);
+    } while (stats.num_frames < num_frames && esp_timer_get_time() < give_up_us);
+}
+
+int main(void) {
+    static const uint32_t clock_steps_hz[] = LED_CLOCK_STEPS_HZ;
+    view_frame_t frame;
+    RAM_image_t expected;
+    uint16_t rows[LED_EMULATOR_RAM_ROWS];
+    uint32_t seed = 5;
+    uint32_t clock_hz = 0;
+
+    CHECK_EQ(LED_CLOCK_CALIBRATION, 1);
+
+    Led_driver__Initialize();
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        frame.rows[row] = (uint16_t)test_random(&seed);
+    }
+    Led_driver__Update_RAM(&frame);
+    wait_frames(1);
+
+    CHECK_EQ(Led_driver__Calibrate_clock(&clock_hz), 0);
+    uint32_t best_hz = 0;
+    for (uint8_t step = 0; step < sizeof(clock_steps_hz) / sizeof(clock_steps_hz[0]); step++) {
+        if (clock_steps_hz[step] <= LED_EMULATOR_ERROR_CLOCK_HZ) {
+            best_hz = clock_steps_hz[step];
+        }
+    }
+    printf("calibrated %lu Hz\n", (unsigned long)clock_hz);
+    CHECK_EQ(clock_hz, best_hz);
+    CHECK_EQ(Led_driver__Get_clock_hz(), best_hz);
+
+    // Test patterns gone, frame back, display on
+    translate_view_to_RAM(&frame, &expected);
+    Led_emulator__Get_RAM_rows(CS_RED, rows);
+    CHECK(memcmp(rows, expected.red, sizeof(rows)) == 0);
+    Led_emulator__Get_RAM_rows(CS_BLUE, rows);
+    CHECK(memcmp(rows, expected.blue, sizeof(rows)) == 0);
+    CHECK(Led_emulator__Get_chip(CS_RED)->led_on);
+    CHECK(Led_emulator__Get_chip(CS_BLUE)->led_on);
+
+    return TEST_RESULT();
+}
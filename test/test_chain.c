@@ -0,0 +1,144 @@
+/* Chained panels (led_driver.h LED_PANELS), built with 2 and 4 panels from
+    shims/include/led_panels_host.h. Every chip gets its setup and SYNC role. Led_driver__Update_RAM_panels
+    puts each panel's own frame in that panel's chips, and Led_driver__Update_RAM the same frame
+    in all of them. A full rewrite costs 788 bits in 2 transactions per panel. Prints the
+    frame time (host clock) and the wire time at 1 MHz per chain length.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+
+// led_driver.c internals
+typedef struct {
+    uint16_t red[24];
+    uint16_t blue[24];
+} RAM_image_t;
+void translate_view_to_RAM(const view_frame_t*, RAM_image_t*);
+
+#define FULL_REWRITE_BITS   788     // Per panel, led_driver.h
+#define WIRE_CLOCK_HZ       1000000
+
+static const led_panel_t Panels[LED_NUM_PANELS] = LED_PANELS;
+
+static void wait_frame(uint32_t num_frames) {
+    led_driver_stats_t stats;
+    int64_t give_up_us = esp_timer_get_time() + 5000000;
+    do {
+        Led_driver__Get_stats(&stats);
+    } while (stats.num_frames == num_frames && esp_timer_get_time() < give_up_us);
+    vTaskDelay(2);
+}
+
+static uint32_t frames_sent(void) {
+    led_driver_stats_t stats;
+    Led_driver__Get_stats(&stats);
+    return stats.num_frames;
+}
+
+static void random_frame(view_frame_t *frame, uint32_t *seed) {
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        frame->rows[row] = (uint16_t)test_random(seed);
+    }
+}
+
+static void check_panel(uint8_t panel, const view_frame_t *frame, const char *what) {
+    RAM_image_t expected;
+    uint16_t rows[LED_EMULATOR_RAM_ROWS];
+
+    translate_view_to_RAM(frame, &expected);
+    Led_emulator__Get_RAM_rows(Panels[panel].cs_red, rows);
+    if (memcmp(rows, expected.red, sizeof(rows)) != 0) {
+        printf("FAIL %s: panel %u red chip RAM differs\n", what, panel);
+        Test_failures++;
+    }
+    Led_emulator__Get_RAM_rows(Panels[panel].cs_blue, rows);
+    if (memcmp(rows, expected.blue, sizeof(rows)) != 0) {
+        printf("FAIL %s: panel %u blue chip RAM differs\n", what, panel);
+        Test_failures++;
+    }
+}
+
+static void test_setup(void) {
+    for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        const led_emulator_chip_t *red = Led_emulator__Get_chip(Panels[panel].cs_red);
+        const led_emulator_chip_t *blue = Led_emulator__Get_chip(Panels[panel].cs_blue);
+        CHECK(red->sys_on && red->led_on);
+        CHECK(blue->sys_on && blue->led_on);
+        CHECK_EQ(red->is_master, Panels[panel].sync_red == SET_MASTER);
+        CHECK_EQ(blue->is_master, Panels[panel].sync_blue == SET_MASTER);
+    }
+}
+
+static void test_own_frames(void) {
+    view_frame_t frames[LED_NUM_PANELS];
+    view_frame_t sent[LED_NUM_PANELS];
+    uint32_t seed = 0xC4A1;
+
+    for (uint8_t round = 0; round < 20; round++) {
+        for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+            random_frame(&frames[panel], &seed);
+        }
+        memcpy(sent, frames, sizeof(sent));
+        uint32_t num_frames = frames_sent();
+        Led_driver__Update_RAM_panels(sent);
+        wait_frame(num_frames);
+        for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+            check_panel(panel, &frames[panel], "own frames");
+        }
+    }
+}
+
+static void test_same_frame(void) {
+    view_frame_t frame;
+    view_frame_t sent;
+    uint32_t seed = 0x5A3E;
+
+    random_frame(&frame, &seed);
+    sent = frame;
+    uint32_t num_frames = frames_sent();
+    Led_driver__Update_RAM(&sent);
+    wait_frame(num_frames);
+    for (uint8_t panel = 0; panel < LED_NUM_PANELS; panel++) {
+        check_panel(panel, &frame, "same frame");
+    }
+}
+
+// Chip RAM invalidated: the next frame goes out in full on every panel
+static void test_full_rewrite(void) {
+    view_frame_t frame;
+    led_driver_stats_t stats;
+    uint32_t seed = 0xF011;
+
+    random_frame(&frame, &seed);
+    Led_driver__Invalidate_RAM();
+    uint32_t num_frames = frames_sent();
+    Led_driver__Update_RAM(&frame);
+    wait_frame(num_frames);
+    Led_driver__Get_stats(&stats);
+
+    CHECK_EQ(stats.bits_per_frame, FULL_REWRITE_BITS * LED_NUM_PANELS);
+    CHECK_EQ(stats.transactions_per_frame, 2 * LED_NUM_PANELS);
+    CHECK(stats.last_frame_ns > 0);
+    printf("%u panels: full rewrite %lu bits in %lu transactions, %lu us on the host, %lu us on the wire at 1 MHz\n",
+           LED_NUM_PANELS, (unsigned long)stats.bits_per_frame, (unsigned long)stats.transactions_per_frame,
+           (unsigned long)(stats.last_frame_ns / 1000),
+           (unsigned long)((uint64_t)stats.bits_per_frame * 1000000 / WIRE_CLOCK_HZ));
+}
+
+int main(void) {
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+    Led_driver__Set_clock_hz(WIRE_CLOCK_HZ);
+    test_setup();
+    test_own_frames();
+    test_same_frame();
+    test_full_rewrite();
+    return TEST_RESULT();
+}
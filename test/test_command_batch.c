@@ -0,0 +1,172 @@
+/* Command batching on the SPI transport: brightness and on/off requests made close together
+    go out as one command mode stream per chip, in the same bus pass as the next frame.
+    Prints transactions and modeled bus time per UI interaction, batched against sending
+    each command on its own (what the driver did before), and checks what the emulated
+    chips end up with.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "host_spi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+
+// led_driver.c internals
+typedef struct {
+    uint16_t red[24];
+    uint16_t blue[24];
+} RAM_image_t;
+void bus_take(void);
+int64_t bus_give(void);
+void translate_view_to_RAM(const view_frame_t*, RAM_image_t*);
+
+#define BENCH_CLOCK_HZ      200000
+#define NUM_CHIPS           (2 * LED_NUM_PANELS)
+
+typedef struct {
+    uint32_t num_transactions;
+    uint64_t busy_us;
+} interaction_t;
+
+// Until the transmit task went idle: no new command streams or frames for a few ticks
+static void wait_idle(void) {
+    led_driver_stats_t stats;
+    uint32_t last = UINT32_MAX;
+    for (uint8_t quiet = 0; quiet < 3; ) {
+        vTaskDelay(2);
+        Led_driver__Get_stats(&stats);
+        uint32_t now = stats.num_command_streams + stats.num_frames;
+        quiet = (now == last) ? quiet + 1 : 0;
+        last = now;
+    }
+}
+
+static void begin(void) {
+    wait_idle();
+    host_spi_reset_stats();
+}
+
+static void end(interaction_t *interaction) {
+    host_spi_stats_t bus;
+    wait_idle();
+    host_spi_get_stats(&bus);
+    interaction->num_transactions = bus.num_transactions;
+    interaction->busy_us = bus.busy_us;
+}
+
+// A few lit LEDs, well inside any current budget
+static void sparse_frame(view_frame_t *frame, uint16_t pattern) {
+    memset(frame, 0, sizeof(*frame));
+    frame->red[3] = pattern;
+    frame->blue[9] = (uint16_t)(pattern << 1);
+}
+
+static void check_chips(const view_frame_t *frame, uint8_t pwm_duty, uint8_t led_on) {
+    RAM_image_t expected;
+    uint16_t rows[LED_EMULATOR_RAM_ROWS];
+    translate_view_to_RAM(frame, &expected);
+    Led_emulator__Get_RAM_rows(CS_RED, rows);
+    CHECK(memcmp(rows, expected.red, sizeof(rows)) == 0);
+    Led_emulator__Get_RAM_rows(CS_BLUE, rows);
+    CHECK(memcmp(rows, expected.blue, sizeof(rows)) == 0);
+    CHECK_EQ(Led_emulator__Get_chip(CS_RED)->pwm_duty, pwm_duty);
+    CHECK_EQ(Led_emulator__Get_chip(CS_BLUE)->pwm_duty, pwm_duty);
+    CHECK_EQ(Led_emulator__Get_chip(CS_RED)->led_on, led_on);
+    CHECK_EQ(Led_emulator__Get_chip(CS_BLUE)->led_on, led_on);
+}
+
+// Wake from sleep: three brightness steps, LED on, new frame.
+// Batched: everything is requested while the transmit task is busy on the bus.
+// One at a time: each request is sent before the next one is made.
+static void test_wake(void) {
+    view_frame_t frame;
+    led_driver_stats_t before;
+    led_driver_stats_t after;
+    interaction_t batched;
+    interaction_t separate;
+
+    Led_driver__Toggle_LED(0);
+    sparse_frame(&frame, 0x0180);
+    Led_driver__Update_RAM(&frame);
+
+    begin();
+    Led_driver__Get_stats(&before);
+    bus_take();
+    Led_driver__Set_brightness(3);
+    Led_driver__Set_brightness(5);
+    Led_driver__Set_brightness(7);
+    Led_driver__Toggle_LED(1);
+    sparse_frame(&frame, 0x0240);
+    Led_driver__Update_RAM(&frame);
+    bus_give();
+    end(&batched);
+    Led_driver__Get_stats(&after);
+
+    check_chips(&frame, 7, 1);
+    CHECK_EQ(after.num_commands - before.num_commands, 4);
+    CHECK_EQ(after.num_commands_coalesced - before.num_commands_coalesced, 2);
+    CHECK_EQ(after.num_command_streams - before.num_command_streams, NUM_CHIPS);
+    // One command stream and one RAM write per chip
+    CHECK_EQ(batched.num_transactions, 2 * NUM_CHIPS);
+
+    Led_driver__Toggle_LED(0);
+    sparse_frame(&frame, 0x0180);
+    Led_driver__Update_RAM(&frame);
+
+    begin();
+    Led_driver__Set_brightness(3);
+    wait_idle();
+    Led_driver__Set_brightness(5);
+    wait_idle();
+    Led_driver__Set_brightness(7);
+    wait_idle();
+    Led_driver__Toggle_LED(1);
+    wait_idle();
+    sparse_frame(&frame, 0x0240);
+    Led_driver__Update_RAM(&frame);
+    end(&separate);
+
+    check_chips(&frame, 7, 1);
+    CHECK_EQ(separate.num_transactions, 5 * NUM_CHIPS);
+    CHECK(batched.busy_us < separate.busy_us);
+
+    printf("wake (3 brightness steps, LED on, frame) at %u Hz:\n", BENCH_CLOCK_HZ);
+    printf("  batched:    %2lu transactions, %5llu us on the bus\n",
+           (unsigned long)batched.num_transactions, (unsigned long long)batched.busy_us);
+    printf("  one by one: %2lu transactions, %5llu us on the bus\n",
+           (unsigned long)separate.num_transactions, (unsigned long long)separate.busy_us);
+}
+
+// Encoder brightness step with no frame pending: one command stream per chip on its own
+static void test_brightness_step(void) {
+    interaction_t step;
+    led_driver_stats_t before;
+    led_driver_stats_t after;
+
+    begin();
+    Led_driver__Get_stats(&before);
+    Led_driver__Set_brightness(9);
+    end(&step);
+    Led_driver__Get_stats(&after);
+
+    CHECK_EQ(step.num_transactions, NUM_CHIPS);
+    CHECK_EQ(after.num_frames, before.num_frames);
+    CHECK_EQ(Led_emulator__Get_chip(CS_RED)->pwm_duty, 9);
+    printf("  brightness step: %lu transactions, %llu us on the bus\n",
+           (unsigned long)step.num_transactions, (unsigned long long)step.busy_us);
+}
+
+int main(void) {
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+    Led_driver__Set_clock_hz(BENCH_CLOCK_HZ);
+
+    test_wake();
+    test_brightness_step();
+    return TEST_RESULT();
+}
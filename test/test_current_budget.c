@@ -0,0 +1,106 @@
+/* Current budget: off by default, and when set the duty the chips get follows the lit LED
+    count of the frame (max_level_for), eg. 300 mA leaves up to 240 lit LEDs alone. A brighter
+    level still queued when a heavy frame arrives must not reach the chips ahead of it.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+
+// led_driver.c internals
+uint8_t max_level_for(uint16_t);
+void batch_level(uint8_t);
+
+static void show_frame(const view_frame_t *frame) {
+    led_driver_stats_t stats;
+    Led_driver__Get_stats(&stats);
+    uint32_t num_frames = stats.num_frames;
+    Led_driver__Update_RAM((view_frame_t *)frame);
+    int64_t give_up_us = esp_timer_get_time() + 5000000;
+    while (stats.num_frames == num_frames && esp_timer_get_time() < give_up_us) {
+        Led_driver__Get_stats(&stats);
+    }
+    vTaskDelay(2);
+}
+
+// First num_lit LEDs of the frame, red then green then blue
+static void lit_frame(view_frame_t *frame, uint16_t num_lit) {
+    memset(frame, 0, sizeof(*frame));
+    for (uint16_t led = 0; led < num_lit; led++) {
+        frame->rows[led / 16] |= (uint16_t)(1 << (led % 16));
+    }
+}
+
+static void test_levels(void) {
+    Led_driver__Set_current_budget(300);
+    CHECK_EQ(max_level_for(0), 15);
+    CHECK_EQ(max_level_for(240), 15);
+    CHECK_EQ(max_level_for(241), 14);
+    CHECK_EQ(max_level_for(768), 4);
+    Led_driver__Set_current_budget(0);
+    CHECK_EQ(max_level_for(768), 15);
+}
+
+static void test_duty(void) {
+    view_frame_t frame;
+
+    Led_driver__Set_brightness(15);
+    lit_frame(&frame, 768);
+    show_frame(&frame);
+    CHECK_EQ(Led_emulator__Get_chip(CS_RED)->pwm_duty, 15);
+
+    Led_driver__Set_current_budget(300);
+    lit_frame(&frame, 767);
+    show_frame(&frame);
+    CHECK_EQ(Led_emulator__Get_chip(CS_RED)->pwm_duty, 4);
+    CHECK_EQ(Led_emulator__Get_chip(CS_BLUE)->pwm_duty, 4);
+
+    lit_frame(&frame, 240);
+    show_frame(&frame);
+    CHECK_EQ(Led_emulator__Get_chip(CS_RED)->pwm_duty, 15);
+}
+
+// Brightness raised while a light frame is on, the command still in the batch (as when
+// Led_driver__Set_brightness loses the race to the next frame), then a frame capped at 5
+static void test_queued_level(void) {
+    view_frame_t frame;
+
+    Led_driver__Set_current_budget(300);
+    Led_driver__Set_brightness(3);
+    lit_frame(&frame, 16);
+    show_frame(&frame);
+    CHECK_EQ(Led_emulator__Get_chip(CS_RED)->pwm_duty, 3);
+
+    Led_emulator__Start_duty_capture();
+    batch_level(15);
+    lit_frame(&frame, 640);
+    CHECK_EQ(max_level_for(640), 5);
+    show_frame(&frame);
+    CHECK_EQ(Led_emulator__Get_chip(CS_RED)->pwm_duty, 5);
+    CHECK_EQ(Led_emulator__Get_chip(CS_BLUE)->pwm_duty, 5);
+    CHECK(Led_emulator__Get_chip(CS_RED)->pwm_duty_peak <= 5);
+    CHECK(Led_emulator__Get_chip(CS_BLUE)->pwm_duty_peak <= 5);
+
+    // Light again: back up to the requested level
+    lit_frame(&frame, 16);
+    show_frame(&frame);
+    CHECK_EQ(Led_emulator__Get_chip(CS_RED)->pwm_duty, 15);
+}
+
+int main(void) {
+    CHECK_EQ(LED_CURRENT_BUDGET_MA, 0);
+    CHECK_EQ(Led_driver__Get_current_budget(), 0);
+
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+    test_levels();
+    test_duty();
+    test_queued_level();
+    return TEST_RESULT();
+}
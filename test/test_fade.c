@@ -0,0 +1,122 @@
+/* Brightness fades against what the emulated chips end up with: a fade on (wake, encoder)
+    that arrives while a fade off is still running must turn it around and leave the LEDs on,
+    a second fade off must not take the half faded level as the one to restore, and a
+    brightness change during a fade off keeps the display on without leaving the fade state
+    stuck for the next fade off.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+
+#define LEVEL           10
+#define FADE_MS         200
+
+static void wait_ms(uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+static void check_chips(uint8_t led_on, uint8_t pwm_duty, const char *what) {
+    for (uint8_t i = 0; i < 2; i++) {
+        const led_emulator_chip_t *chip = Led_emulator__Get_chip(i ? CS_BLUE : CS_RED);
+        if (chip->led_on != led_on || (led_on && chip->pwm_duty != pwm_duty)) {
+            printf("FAIL %s: chip %u led_on %u duty %u, expected %u / %u\n", what, i, chip->led_on,
+                   chip->pwm_duty, led_on, pwm_duty);
+            Test_failures++;
+        }
+    }
+}
+
+static void reset_on(void) {
+    Led_driver__Toggle_LED(1);
+    Led_driver__Set_brightness(LEVEL);
+    wait_ms(50);
+    check_chips(1, LEVEL, "reset");
+}
+
+// Wake halfway through going to sleep
+static void test_wake_during_fade_off(void) {
+    reset_on();
+    Led_driver__Fade_LED(0, FADE_MS);
+    wait_ms(FADE_MS / 2);
+    Led_driver__Fade_LED(1, FADE_MS);
+    wait_ms(2 * FADE_MS);
+    check_chips(1, LEVEL, "wake during fade off");
+}
+
+// Sleep asked twice: the level restored on wake is the one before the first
+static void test_second_fade_off(void) {
+    reset_on();
+    Led_driver__Fade_LED(0, FADE_MS);
+    wait_ms(FADE_MS / 2);
+    Led_driver__Fade_LED(0, FADE_MS);
+    wait_ms(2 * FADE_MS);
+    check_chips(0, 0, "second fade off");
+
+    Led_driver__Fade_LED(1, FADE_MS);
+    wait_ms(2 * FADE_MS);
+    check_chips(1, LEVEL, "wake after second fade off");
+}
+
+// Encoder brightness change while fading off: stays on at that level
+static void test_brightness_during_fade_off(void) {
+    reset_on();
+    Led_driver__Fade_LED(0, FADE_MS);
+    wait_ms(FADE_MS / 2);
+    Led_driver__Fade_brightness(7, FADE_MS / 4);
+    wait_ms(2 * FADE_MS);
+    check_chips(1, 7, "fade brightness during fade off");
+
+    // Nothing left pending: the next sleep goes through
+    Led_driver__Fade_LED(0, FADE_MS);
+    wait_ms(2 * FADE_MS);
+    check_chips(0, 0, "fade off after brightness change");
+
+    reset_on();
+    Led_driver__Fade_LED(0, FADE_MS);
+    wait_ms(FADE_MS / 2);
+    Led_driver__Set_brightness(12);
+    wait_ms(2 * FADE_MS);
+    check_chips(1, 12, "set brightness during fade off");
+
+    Led_driver__Fade_LED(0, FADE_MS);
+    wait_ms(2 * FADE_MS);
+    check_chips(0, 0, "fade off after set brightness");
+}
+
+// Plain round trip, and waking when already on does nothing
+static void test_round_trip(void) {
+    led_driver_stats_t before;
+    led_driver_stats_t after;
+
+    reset_on();
+    Led_driver__Fade_LED(0, FADE_MS);
+    wait_ms(2 * FADE_MS);
+    check_chips(0, 0, "fade off");
+    Led_driver__Fade_LED(1, FADE_MS);
+    wait_ms(2 * FADE_MS);
+    check_chips(1, LEVEL, "fade on");
+
+    Led_driver__Get_stats(&before);
+    Led_driver__Fade_LED(1, FADE_MS);
+    wait_ms(FADE_MS);
+    Led_driver__Get_stats(&after);
+    CHECK_EQ(after.num_fade_steps, before.num_fade_steps);
+    check_chips(1, LEVEL, "fade on while on");
+}
+
+int main(void) {
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+
+    test_round_trip();
+    test_wake_during_fade_off();
+    test_second_fade_off();
+    test_brightness_during_fade_off();
+    return TEST_RESULT();
+}
@@ -0,0 +1,227 @@
+/* Unchanged frame skip (push_view_to_display): a render with the same hash as the last frame
+    sent is counted skipped and never reaches the driver, a changed one (pixels or orientation)
+    is sent, and the chips hold it. View__Force_refresh sends the next frame even though it is
+    unchanged and rewrites every chip in full, which is what repairs RAM the chips lost behind
+    the driver's back. No single-bit change of a frame keeps its hash.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+#include "view.h"
+#include "menu.h"
+
+// view.c / led_driver.c internals
+typedef struct {
+    uint16_t red[24];
+    uint16_t blue[24];
+} RAM_image_t;
+void build_new_view(void);
+void push_view_to_display(void);
+uint64_t hash_frame(const view_frame_t*, uint8_t, uint64_t);
+void translate_view_to_RAM(const view_frame_t*, RAM_image_t*);
+
+#define FULL_REWRITE_BITS   788     // One panel, led_driver.h
+#define NUM_REPLAY_RENDERS  200
+#define REPLAY_CHANGE_EVERY 5
+
+// One pass of the display task, then until the transmit task has written a frame sent
+static void show_frame(void) {
+    led_driver_stats_t stats;
+    view_sched_stats_t sched;
+    Led_driver__Get_stats(&stats);
+    View__Get_sched_stats(&sched);
+    uint32_t num_frames = stats.num_frames;
+    uint32_t num_sent = sched.num_frames_sent;
+
+    View__Request_update();
+    build_new_view();
+    push_view_to_display();
+    View__Get_sched_stats(&sched);
+    if (sched.num_frames_sent == num_sent) {
+        return;
+    }
+    int64_t give_up_us = esp_timer_get_time() + 5000000;
+    while (stats.num_frames == num_frames && esp_timer_get_time() < give_up_us) {
+        Led_driver__Get_stats(&stats);
+    }
+}
+
+static uint8_t chips_hold(const view_frame_t *frame) {
+    RAM_image_t expected;
+    uint16_t rows[LED_EMULATOR_RAM_ROWS];
+
+    translate_view_to_RAM(frame, &expected);
+    Led_emulator__Get_RAM_rows(CS_RED, rows);
+    if (memcmp(rows, expected.red, sizeof(rows)) != 0) {
+        return 0;
+    }
+    Led_emulator__Get_RAM_rows(CS_BLUE, rows);
+    return memcmp(rows, expected.blue, sizeof(rows)) == 0;
+}
+
+// Sched and driver counters across one show_frame
+static void show_counted(uint32_t *num_sent, uint32_t *num_skipped, uint32_t *num_driver_frames) {
+    view_sched_stats_t before;
+    view_sched_stats_t after;
+    led_driver_stats_t stats_before;
+    led_driver_stats_t stats_after;
+
+    View__Get_sched_stats(&before);
+    Led_driver__Get_stats(&stats_before);
+    show_frame();
+    vTaskDelay(2);
+    View__Get_sched_stats(&after);
+    Led_driver__Get_stats(&stats_after);
+    *num_sent = after.num_frames_sent - before.num_frames_sent;
+    *num_skipped = after.num_frames_skipped - before.num_frames_skipped;
+    *num_driver_frames = stats_after.num_frames - stats_before.num_frames;
+}
+
+static void test_skip(void) {
+    view_frame_t frame;
+    view_frame_t overlay;
+    uint32_t num_sent;
+    uint32_t num_skipped;
+    uint32_t num_driver_frames;
+
+    show_frame();
+    View__Get_frame(&frame);
+    CHECK(chips_hold(&frame));
+
+    // Same render: skipped, the driver never sees it
+    show_counted(&num_sent, &num_skipped, &num_driver_frames);
+    CHECK_EQ(num_sent, 0);
+    CHECK_EQ(num_skipped, 1);
+    CHECK_EQ(num_driver_frames, 0);
+    CHECK(chips_hold(&frame));
+
+    // One pixel different: sent
+    memset(&overlay, 0, sizeof(overlay));
+    overlay.blue[7] = 0x0100;
+    View__Layer_set(VIEW_LAYER_OVERLAY, &overlay, NULL, VIEW_BLEND_XOR);
+    show_counted(&num_sent, &num_skipped, &num_driver_frames);
+    CHECK_EQ(num_sent, 1);
+    CHECK_EQ(num_skipped, 0);
+    CHECK_EQ(num_driver_frames, 1);
+    View__Get_frame(&frame);
+    CHECK(chips_hold(&frame));
+
+    // Same pixels, new orientation: sent
+    Led_driver__Set_orientation(LED_ORIENT_180);
+    show_counted(&num_sent, &num_skipped, &num_driver_frames);
+    CHECK_EQ(num_sent, 1);
+    CHECK(chips_hold(&frame));
+    Led_driver__Set_orientation(LED_ORIENT_0);
+    show_frame();
+    View__Layer_clear(VIEW_LAYER_OVERLAY);
+    show_frame();
+}
+
+// A chip drops a bit: an unchanged frame leaves it wrong, a forced one rewrites everything
+static void test_force_refresh(void) {
+    view_frame_t frame;
+    view_sched_stats_t before;
+    view_sched_stats_t after;
+    led_driver_stats_t stats;
+    uint32_t num_sent;
+    uint32_t num_skipped;
+    uint32_t num_driver_frames;
+
+    View__Get_frame(&frame);
+    CHECK(chips_hold(&frame));
+    Led_emulator__Flip_RAM_bit(CS_RED, 10, 2);
+    CHECK(!chips_hold(&frame));
+
+    show_counted(&num_sent, &num_skipped, &num_driver_frames);
+    CHECK_EQ(num_skipped, 1);
+    CHECK(!chips_hold(&frame));
+
+    View__Get_sched_stats(&before);
+    View__Force_refresh();
+    build_new_view();
+    push_view_to_display();
+    vTaskDelay(pdMS_TO_TICKS(50));
+    View__Get_sched_stats(&after);
+    Led_driver__Get_stats(&stats);
+
+    CHECK_EQ(after.num_forced - before.num_forced, 1);
+    CHECK_EQ(after.num_frames_sent - before.num_frames_sent, 1);
+    CHECK_EQ(after.num_frames_skipped, before.num_frames_skipped);
+    CHECK_EQ(stats.bits_per_frame, FULL_REWRITE_BITS);
+    CHECK(chips_hold(&frame));
+
+    // Back to skipping after that
+    show_counted(&num_sent, &num_skipped, &num_driver_frames);
+    CHECK_EQ(num_skipped, 1);
+}
+
+// Renders where only every REPLAY_CHANGE_EVERY-th one changes something
+static void test_replay(void) {
+    view_frame_t overlay;
+    view_frame_t frame;
+    view_sched_stats_t before;
+    view_sched_stats_t after;
+    uint32_t seed = 0x4A54;
+
+    memset(&overlay, 0, sizeof(overlay));
+    View__Get_sched_stats(&before);
+    for (uint16_t i = 0; i < NUM_REPLAY_RENDERS; i++) {
+        if (i % REPLAY_CHANGE_EVERY == 0) {
+            overlay.rows[test_random(&seed) % VIEW_FRAME_ROWS] ^= (uint16_t)(1 << (test_random(&seed) % 16));
+            View__Layer_set(VIEW_LAYER_OVERLAY, &overlay, NULL, VIEW_BLEND_XOR);
+        }
+        show_frame();
+    }
+    View__Get_sched_stats(&after);
+    View__Get_frame(&frame);
+
+    uint32_t num_sent = after.num_frames_sent - before.num_frames_sent;
+    uint32_t num_skipped = after.num_frames_skipped - before.num_frames_skipped;
+    printf("replay: %u renders, %lu sent, %lu skipped\n", NUM_REPLAY_RENDERS, (unsigned long)num_sent, (unsigned long)num_skipped);
+    CHECK_EQ(num_sent, NUM_REPLAY_RENDERS / REPLAY_CHANGE_EVERY);
+    CHECK_EQ(num_skipped, NUM_REPLAY_RENDERS - NUM_REPLAY_RENDERS / REPLAY_CHANGE_EVERY);
+    vTaskDelay(2);
+    CHECK(chips_hold(&frame));
+    View__Layer_clear(VIEW_LAYER_OVERLAY);
+}
+
+static void test_single_bit_changes(void) {
+    view_frame_t frame;
+    uint32_t seed = 0x8A54;
+    uint16_t num_same = 0;
+
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        frame.rows[row] = (uint16_t)test_random(&seed);
+    }
+    uint64_t hash = hash_frame(&frame, 1, 0);
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        for (uint8_t col = 0; col < 16; col++) {
+            frame.rows[row] ^= (uint16_t)(1 << col);
+            num_same += (hash_frame(&frame, 1, 0) == hash);
+            frame.rows[row] ^= (uint16_t)(1 << col);
+        }
+    }
+    CHECK_EQ(num_same, 0);
+}
+
+int main(void) {
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+    Led_driver__Set_scrub_budget(0);    // The scrubber would repair the dropped bit on its own
+    View__Set_transition(VIEW_TRANSITION_NONE);
+    Menu__Initialize();
+    View__Set_view(VIEW_MENU);
+
+    test_single_bit_changes();
+    test_skip();
+    test_force_refresh();
+    test_replay();
+    return TEST_RESULT();
+}
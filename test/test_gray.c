@@ -0,0 +1,127 @@
+/* Grayscale frames (Led_driver__Update_RAM_gray): above LED_GRAY_MIN_CLOCK_HZ the planes cycle
+    with plane k on for LED_GRAY_BASE_US << k, and Led_driver__Simulate_gray measures the
+    refresh rate and how far each pixel's on time is from level / VIEW_GRAY_MAX_LEVEL. Below
+    the minimum clock the frame is shown flat (any lit level fully on) and there is nothing
+    to simulate. Duty error is host timer jitter on top of the plane timing.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+
+// led_driver.c internals
+typedef struct {
+    uint16_t red[24];
+    uint16_t blue[24];
+} RAM_image_t;
+void translate_view_to_RAM(const view_frame_t*, RAM_image_t*);
+
+#define WINDOW_MS           1000
+#define CYCLE_US            (LED_GRAY_BASE_US * VIEW_GRAY_MAX_LEVEL)
+#define MIN_REFRESH_HZ      (500000.0f / CYCLE_US)      // Half the plane timers' rate
+#define MAX_MEAN_ERROR      0.05f
+#define MAX_PIXEL_ERROR     0.15f
+
+// Every level on every channel: red by column, green by row, blue by both
+static void make_frame(view_gray_frame_t *frame) {
+    memset(frame, 0, sizeof(*frame));
+    for (uint8_t row = 0; row < 16; row++) {
+        for (uint8_t col = 0; col < 16; col++) {
+            uint8_t red = col % (VIEW_GRAY_MAX_LEVEL + 1);
+            uint8_t green = row % (VIEW_GRAY_MAX_LEVEL + 1);
+            uint8_t blue = (row + col) % (VIEW_GRAY_MAX_LEVEL + 1);
+            for (uint8_t k = 0; k < VIEW_GRAY_BITS; k++) {
+                frame->planes[k].red[row] |= (uint16_t)(((red >> k) & 1) << col);
+                frame->planes[k].green[row] |= (uint16_t)(((green >> k) & 1) << col);
+                frame->planes[k].blue[row] |= (uint16_t)(((blue >> k) & 1) << col);
+            }
+        }
+    }
+}
+
+static void wait_frames(uint32_t num_frames) {
+    led_driver_stats_t stats;
+    int64_t give_up_us = esp_timer_get_time() + 5000000;
+    do {
+        vTaskDelay(1);
+        Led_driver__Get_stats(&stats);
+    } while (stats.num_frames < num_frames && esp_timer_get_time() < give_up_us);
+}
+
+// Slow bus: one flat frame, every lit level fully on, no plane cycling
+static void test_flat(const view_gray_frame_t *frame) {
+    view_gray_frame_t copy = *frame;
+    view_frame_t flat;
+    RAM_image_t expected;
+    uint16_t rows[LED_EMULATOR_RAM_ROWS];
+    led_gray_report_t report;
+    led_driver_stats_t stats;
+
+    memset(&flat, 0, sizeof(flat));
+    for (uint8_t k = 0; k < VIEW_GRAY_BITS; k++) {
+        for (uint8_t i = 0; i < VIEW_FRAME_ROWS; i++) {
+            flat.rows[i] |= frame->planes[k].rows[i];
+        }
+    }
+    translate_view_to_RAM(&flat, &expected);
+
+    Led_driver__Get_stats(&stats);
+    Led_driver__Update_RAM_gray(&copy);
+    wait_frames(stats.num_frames + 1);
+    Led_emulator__Get_RAM_rows(CS_RED, rows);
+    CHECK(memcmp(rows, expected.red, sizeof(rows)) == 0);
+    Led_emulator__Get_RAM_rows(CS_BLUE, rows);
+    CHECK(memcmp(rows, expected.blue, sizeof(rows)) == 0);
+    CHECK_EQ(Led_driver__Simulate_gray(10, &report), -1);
+}
+
+static void test_planes(const view_gray_frame_t *frame) {
+    view_gray_frame_t copy = *frame;
+    led_gray_report_t report;
+    led_driver_stats_t stats;
+
+    Led_driver__Set_clock_hz(LED_GRAY_MIN_CLOCK_HZ * 4);
+    Led_driver__Get_stats(&stats);
+    Led_driver__Update_RAM_gray(&copy);
+    wait_frames(stats.num_frames + 1);
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    CHECK_EQ(Led_driver__Simulate_gray(WINDOW_MS, &report), 0);
+    Led_driver__Get_stats(&stats);
+    printf("gray: %.1f Hz (plane timers alone %.1f Hz), duty error mean %.3f max %.3f, %lu cycles\n",
+           report.refresh_hz, 1000000.0f / CYCLE_US, report.mean_duty_error, report.max_duty_error,
+           (unsigned long)stats.num_gray_cycles);
+    CHECK(report.refresh_hz >= MIN_REFRESH_HZ);
+    CHECK(report.refresh_hz <= 1000000.0f / CYCLE_US);
+    CHECK(report.mean_duty_error <= MAX_MEAN_ERROR);
+    CHECK(report.max_duty_error <= MAX_PIXEL_ERROR);
+    CHECK(stats.num_planes_shown >= stats.num_gray_cycles * VIEW_GRAY_BITS);
+
+    // A flat frame ends the plane cycle
+    view_frame_t off;
+    memset(&off, 0, sizeof(off));
+    Led_driver__Update_RAM(&off);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    CHECK_EQ(Led_driver__Simulate_gray(10, &report), -1);
+}
+
+int main(void) {
+    view_gray_frame_t frame;
+    led_gray_report_t report;
+
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+    CHECK_EQ(Led_driver__Simulate_gray(10, &report), -1);
+    CHECK(Led_driver__Get_clock_hz() < LED_GRAY_MIN_CLOCK_HZ);
+
+    make_frame(&frame);
+    test_flat(&frame);
+    test_planes(&frame);
+    return TEST_RESULT();
+}
@@ -0,0 +1,174 @@
+/* Input-to-photon latency (latency.h) end to end: encoder events go through the real event
+    queue and dispatcher task, the frame is built the way the display task does it and sent
+    by the LED driver transmit task, whose frame-done callback closes the trace. Checks the
+    stages add up to the total, one trace per input, and prints the per-stage histograms
+    (the same lines Latency__Log sends as the MQTT latency report).
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "event_system.h"
+#include "latency.h"
+#include "led_driver.h"
+#include "view.h"
+#include "menu.h"
+#include "mqtt_protocol.h"
+
+// view.c / latency.c internals
+void build_new_view(void);
+void push_view_to_display(void);
+void on_frame_done(int64_t, uint32_t);
+uint8_t bucket_index(uint32_t);
+
+#define NUM_INPUTS          20
+#define DEBOUNCE_US         2000    // Detected this long before it is posted
+#define DISPATCH_WAIT_MS    20      // Display task wakes up this long after the dispatcher
+#define UI_TOP_CW           0x10
+#define UI_TOP_CCW          0x20
+#define UI_SIDE_CW          0x40
+
+// One pass of the display task after it was woken
+static void show_frame(void) {
+    View__Request_update();
+    build_new_view();
+    push_view_to_display();
+}
+
+static uint32_t total_samples(void) {
+    latency_histogram_t histogram;
+    Latency__Get_histogram(LATENCY_STAGE_TOTAL, &histogram);
+    return histogram.num_samples;
+}
+
+static void wait_samples(uint32_t num_samples) {
+    int64_t give_up_us = esp_timer_get_time() + 2000000;
+    while (total_samples() < num_samples && esp_timer_get_time() < give_up_us) {
+        vTaskDelay(1);
+    }
+}
+
+static void test_buckets(void) {
+    CHECK_EQ(bucket_index(0), 0);
+    CHECK_EQ(bucket_index(1), 0);
+    CHECK_EQ(bucket_index(2), 1);
+    CHECK_EQ(bucket_index(3), 1);
+    CHECK_EQ(bucket_index(1024), 10);
+    CHECK_EQ(bucket_index(262143), 17);
+    CHECK_EQ(bucket_index(262144), LATENCY_NUM_BUCKETS - 1);
+    CHECK_EQ(bucket_index(UINT32_MAX), LATENCY_NUM_BUCKETS - 1);
+}
+
+// Encoder turns through the dispatcher, one frame each. Back and forth between two menu
+// entries so every turn changes the frame.
+static void test_inputs(void) {
+    Latency__Reset();
+    for (uint8_t i = 0; i < NUM_INPUTS; i++) {
+        uint32_t detect_us = (uint32_t)esp_timer_get_time() - DEBOUNCE_US;
+        EventSystem_PostEventAt(EVENT_UI_ENCODER, (i & 1) ? UI_TOP_CCW : UI_TOP_CW, NULL, detect_us);
+        vTaskDelay(pdMS_TO_TICKS(DISPATCH_WAIT_MS));
+        show_frame();
+        wait_samples(i + 1);
+    }
+
+    latency_histogram_t stages[LATENCY_NUM_STAGES];
+    uint64_t stage_sum_us = 0;
+    for (uint8_t stage = 0; stage < LATENCY_NUM_STAGES; stage++) {
+        Latency__Get_histogram(stage, &stages[stage]);
+        CHECK_EQ(stages[stage].num_samples, NUM_INPUTS);
+
+        uint32_t num_bucketed = 0;
+        for (uint8_t bucket = 0; bucket < LATENCY_NUM_BUCKETS; bucket++) {
+            num_bucketed += stages[stage].bucket[bucket];
+        }
+        CHECK_EQ(num_bucketed, NUM_INPUTS);
+        if (stage != LATENCY_STAGE_TOTAL) {
+            stage_sum_us += stages[stage].total_us;
+        }
+    }
+    // Each sample's stages telescope to its total
+    CHECK_EQ(stage_sum_us, stages[LATENCY_STAGE_TOTAL].total_us);
+    CHECK(stages[LATENCY_STAGE_QUEUE].total_us >= (uint64_t)NUM_INPUTS * DEBOUNCE_US);
+    CHECK(stages[LATENCY_STAGE_DISPATCH].total_us >= (uint64_t)NUM_INPUTS * DISPATCH_WAIT_MS * 1000 / 2);
+
+    host_log_level = ESP_LOG_INFO;
+    Latency__Log();
+    host_log_level = ESP_LOG_WARN;
+}
+
+// A second input while the first is in flight rides along: one sample, timed from the first
+static void test_ride_along(void) {
+    Latency__Reset();
+    uint32_t first_us = (uint32_t)esp_timer_get_time() - 50000;
+    Latency__Mark_dispatch(first_us);
+    Latency__Mark_dispatch(first_us + 40000);
+    View__Process_UI(UI_TOP_CW);
+    show_frame();
+    wait_samples(1);
+
+    latency_histogram_t total;
+    Latency__Get_histogram(LATENCY_STAGE_TOTAL, &total);
+    CHECK_EQ(total.num_samples, 1);
+    CHECK(total.max_us >= 50000);
+
+    // No trace in flight: frames alone record nothing
+    View__Process_UI(UI_TOP_CW);
+    show_frame();
+    vTaskDelay(pdMS_TO_TICKS(DISPATCH_WAIT_MS));
+    CHECK_EQ(total_samples(), 1);
+}
+
+// Brightness in the menu changes nothing on the frame: the trace ends as unchanged, right
+// away, so the next input is traced again
+static void test_unchanged(void) {
+    Latency__Reset();
+    EventSystem_PostEventAt(EVENT_UI_ENCODER, UI_SIDE_CW, NULL, (uint32_t)esp_timer_get_time());
+    vTaskDelay(pdMS_TO_TICKS(DISPATCH_WAIT_MS));
+    show_frame();
+    CHECK_EQ(Latency__Get_num_unchanged(), 1);
+    CHECK_EQ(total_samples(), 0);
+
+    EventSystem_PostEventAt(EVENT_UI_ENCODER, UI_TOP_CW, NULL, (uint32_t)esp_timer_get_time());
+    vTaskDelay(pdMS_TO_TICKS(DISPATCH_WAIT_MS));
+    show_frame();
+    wait_samples(1);
+    CHECK_EQ(total_samples(), 1);
+    CHECK_EQ(Latency__Get_num_unchanged(), 1);
+
+    // Reported after the histograms
+    latency_histogram_t histograms[LATENCY_NUM_STAGES];
+    uint8_t report[MQTT_PROTOCOL_HEADER_SIZE + MQTT_PROTOCOL_MAX_PAYLOAD];
+    for (uint8_t stage = 0; stage < LATENCY_NUM_STAGES; stage++) {
+        Latency__Get_histogram(stage, &histograms[stage]);
+    }
+    int len = mqtt_protocol_build_latency_report(histograms, Latency__Get_num_unchanged(), report, sizeof(report));
+    CHECK_EQ(len, MQTT_PROTOCOL_HEADER_SIZE + 2 + LATENCY_NUM_STAGES * (8 + 2 * LATENCY_NUM_BUCKETS) + 4);
+    if (len > 4) {
+        CHECK_EQ(report[len - 1], 1);
+        CHECK_EQ(report[len - 4] | report[len - 3] | report[len - 2], 0);
+    }
+}
+
+int main(void) {
+    test_buckets();
+
+    Led_driver__Initialize();
+    Led_driver__Set_frame_done_callback(on_frame_done);
+    View__Set_transition(VIEW_TRANSITION_NONE);
+    Menu__Initialize();
+    View__Set_view(VIEW_MENU);
+    show_frame();
+
+    EventSystem_Initialize();
+    EventSystem_StartTasks();
+
+    test_inputs();
+    test_ride_along();
+    test_unchanged();
+    return TEST_RESULT();
+}
@@ -0,0 +1,212 @@
+/* Compositor layers (view.h VIEW_LAYER_*) over the menu, end to end: each blend mode under a
+    mask, all three layers stacked bottom up, and clearing them. Frames go the way the display
+    task sends them (build_new_view, push_view_to_display), and the chip RAM the emulator ends
+    up with is checked against a per pixel blend written straight from the view.h comments.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+#include "view.h"
+#include "menu.h"
+
+// view.c / led_driver.c internals
+typedef struct {
+    uint16_t red[24];
+    uint16_t blue[24];
+} RAM_image_t;
+void build_new_view(void);
+void push_view_to_display(void);
+void translate_view_to_RAM(const view_frame_t*, RAM_image_t*);
+
+typedef struct {
+    view_layer_t layer;
+    view_frame_t pixels;
+    view_frame_t mask;
+    view_blend_t blend;
+} layer_t;
+
+// One pass of the display task, then until the transmit task has written the chips (unless
+// the frame was the same as the last one and never went out)
+static void show_frame(void) {
+    led_driver_stats_t stats;
+    view_sched_stats_t sched;
+    Led_driver__Get_stats(&stats);
+    View__Get_sched_stats(&sched);
+    uint32_t num_frames = stats.num_frames;
+    uint32_t num_sent = sched.num_frames_sent;
+
+    build_new_view();
+    push_view_to_display();
+    View__Get_sched_stats(&sched);
+    if (sched.num_frames_sent == num_sent) {
+        return;
+    }
+    int64_t give_up_us = esp_timer_get_time() + 5000000;
+    while (stats.num_frames == num_frames && esp_timer_get_time() < give_up_us) {
+        Led_driver__Get_stats(&stats);
+    }
+}
+
+static void random_frame(view_frame_t *frame, uint32_t *seed) {
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        frame->rows[row] = (uint16_t)test_random(seed);
+    }
+}
+
+static void blend_naive(view_frame_t *frame, const layer_t *layer) {
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        for (uint8_t col = 0; col < 16; col++) {
+            uint16_t bit = (uint16_t)(1 << col);
+            if (!(layer->mask.rows[row] & bit)) {
+                continue;
+            }
+            uint8_t lit = (layer->pixels.rows[row] & bit) != 0;
+            uint8_t below = (frame->rows[row] & bit) != 0;
+            uint8_t out = below;
+            switch (layer->blend) {
+                case VIEW_BLEND_OR:      out = below | lit; break;
+                case VIEW_BLEND_REPLACE: out = lit;         break;
+                case VIEW_BLEND_XOR:     out = below ^ lit; break;
+            }
+            frame->rows[row] = out ? (frame->rows[row] | bit) : (frame->rows[row] & ~bit);
+        }
+    }
+}
+
+// Both the frame the view module reports and what the chips hold
+static void check_shown(const view_frame_t *expected, const char *what) {
+    view_frame_t frame;
+    RAM_image_t ram;
+    uint16_t rows[LED_EMULATOR_RAM_ROWS];
+
+    View__Get_frame(&frame);
+    if (memcmp(&frame, expected, sizeof(frame)) != 0) {
+        printf("FAIL %s: composed frame differs\n", what);
+        Test_failures++;
+    }
+    translate_view_to_RAM(expected, &ram);
+    Led_emulator__Get_RAM_rows(CS_RED, rows);
+    if (memcmp(rows, ram.red, sizeof(rows)) != 0) {
+        printf("FAIL %s: red chip RAM differs\n", what);
+        Test_failures++;
+    }
+    Led_emulator__Get_RAM_rows(CS_BLUE, rows);
+    if (memcmp(rows, ram.blue, sizeof(rows)) != 0) {
+        printf("FAIL %s: blue chip RAM differs\n", what);
+        Test_failures++;
+    }
+}
+
+// Each blend on its own, with a random mask and with none (whole frame)
+static void test_blends(const view_frame_t *base) {
+    static const view_blend_t Blends[] = {VIEW_BLEND_OR, VIEW_BLEND_REPLACE, VIEW_BLEND_XOR};
+    uint32_t seed = 0xB1E4D;
+    layer_t layer;
+    view_frame_t expected;
+    char what[48];
+
+    layer.layer = VIEW_LAYER_OVERLAY;
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t masked = 0; masked < 2; masked++) {
+            layer.blend = Blends[i];
+            random_frame(&layer.pixels, &seed);
+            if (masked) {
+                random_frame(&layer.mask, &seed);
+            } else {
+                memset(&layer.mask, 0xFF, sizeof(layer.mask));
+            }
+            View__Layer_set(layer.layer, &layer.pixels, masked ? &layer.mask : NULL, layer.blend);
+            show_frame();
+
+            expected = *base;
+            blend_naive(&expected, &layer);
+            snprintf(what, sizeof(what), "blend %u%s", Blends[i], masked ? " masked" : "");
+            check_shown(&expected, what);
+        }
+    }
+    View__Layer_clear(VIEW_LAYER_OVERLAY);
+    show_frame();
+    check_shown(base, "overlay cleared");
+}
+
+// Overlay, cursor and notification together: applied bottom up, whatever order they were set in
+static void test_stack(const view_frame_t *base) {
+    static const view_layer_t Set_order[] = {VIEW_LAYER_NOTIFICATION, VIEW_LAYER_OVERLAY, VIEW_LAYER_CURSOR};
+    uint32_t seed = 0x57AC;
+    layer_t layers[VIEW_NUM_LAYERS];
+    view_frame_t expected;
+
+    layers[VIEW_LAYER_OVERLAY].blend = VIEW_BLEND_REPLACE;
+    layers[VIEW_LAYER_CURSOR].blend = VIEW_BLEND_XOR;
+    layers[VIEW_LAYER_NOTIFICATION].blend = VIEW_BLEND_OR;
+    for (uint8_t layer = VIEW_LAYER_OVERLAY; layer < VIEW_NUM_LAYERS; layer++) {
+        layers[layer].layer = layer;
+        random_frame(&layers[layer].pixels, &seed);
+        random_frame(&layers[layer].mask, &seed);
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        const layer_t *layer = &layers[Set_order[i]];
+        View__Layer_set(layer->layer, &layer->pixels, &layer->mask, layer->blend);
+    }
+    show_frame();
+
+    expected = *base;
+    for (uint8_t layer = VIEW_LAYER_OVERLAY; layer < VIEW_NUM_LAYERS; layer++) {
+        blend_naive(&expected, &layers[layer]);
+    }
+    check_shown(&expected, "stacked layers");
+
+    // Middle one gone: the other two still blend over the base
+    View__Layer_clear(VIEW_LAYER_CURSOR);
+    show_frame();
+    expected = *base;
+    blend_naive(&expected, &layers[VIEW_LAYER_OVERLAY]);
+    blend_naive(&expected, &layers[VIEW_LAYER_NOTIFICATION]);
+    check_shown(&expected, "cursor cleared");
+
+    // The view re-rendering underneath keeps the layers on top
+    View__Request_update();
+    show_frame();
+    check_shown(&expected, "re-rendered base");
+
+    View__Layer_clear(VIEW_LAYER_OVERLAY);
+    View__Layer_clear(VIEW_LAYER_NOTIFICATION);
+    show_frame();
+    check_shown(base, "all cleared");
+}
+
+// The base is not a layer that can be set or cleared
+static void test_base_untouchable(const view_frame_t *base) {
+    view_frame_t pixels;
+    memset(&pixels, 0xFF, sizeof(pixels));
+    View__Layer_set(VIEW_LAYER_BASE, &pixels, NULL, VIEW_BLEND_OR);
+    View__Layer_clear(VIEW_LAYER_BASE);
+    View__Request_update();
+    show_frame();
+    check_shown(base, "base layer set");
+}
+
+int main(void) {
+    view_frame_t base;
+
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+    View__Set_transition(VIEW_TRANSITION_NONE);
+    Menu__Initialize();
+    View__Set_view(VIEW_MENU);
+    show_frame();
+    View__Get_frame(&base);
+    check_shown(&base, "menu");
+
+    test_blends(&base);
+    test_stack(&base);
+    test_base_untouchable(&base);
+    return TEST_RESULT();
+}
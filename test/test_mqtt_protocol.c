@@ -0,0 +1,70 @@
+/* MQTT message builders against the byte layout documented in mqtt_protocol.h.
+    Render profile (0x13): [cpu_mhz: 2][num_views: 1] then per view num_samples, min, avg, max
+    and p99 cycles, 4 bytes each, all big endian. Refused when it would not fit the buffer or
+    the 255 byte payload.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "mqtt_protocol.h"
+
+#define NUM_PROFILE_VIEWS   3
+#define MAX_PROFILE_VIEWS   ((MQTT_PROTOCOL_MAX_PAYLOAD - 3) / 20)
+
+static uint32_t be32(const uint8_t *bytes) {
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+static void test_render_profile(void) {
+    mqtt_render_profile_t profiles[MAX_PROFILE_VIEWS + 1];
+    uint8_t msg[MQTT_PROTOCOL_HEADER_SIZE + MQTT_PROTOCOL_MAX_PAYLOAD + 20];
+
+    for (uint8_t view = 0; view <= MAX_PROFILE_VIEWS; view++) {
+        profiles[view].num_samples = 0x01020304 + view;
+        profiles[view].min_cycles = 1000 * view;
+        profiles[view].avg_cycles = 0x00ABCDEF;
+        profiles[view].max_cycles = 0xFEDCBA98;
+        profiles[view].p99_cycles = 70000 + view;
+    }
+
+    int len = mqtt_protocol_build_render_profile(profiles, NUM_PROFILE_VIEWS, 240, msg, sizeof(msg));
+    CHECK_EQ(len, MQTT_PROTOCOL_HEADER_SIZE + 3 + (NUM_PROFILE_VIEWS * 20));
+    CHECK_EQ(msg[0], MSG_TYPE_RENDER_PROFILE);
+    CHECK_EQ(msg[0], 0x13);
+    CHECK_EQ(msg[1], len - MQTT_PROTOCOL_HEADER_SIZE);
+    CHECK_EQ((msg[2] << 8) | msg[3], 240);
+    CHECK_EQ(msg[4], NUM_PROFILE_VIEWS);
+    for (uint8_t view = 0; view < NUM_PROFILE_VIEWS; view++) {
+        const uint8_t *entry = &msg[5 + (view * 20)];
+        CHECK_EQ(be32(&entry[0]), profiles[view].num_samples);
+        CHECK_EQ(be32(&entry[4]), profiles[view].min_cycles);
+        CHECK_EQ(be32(&entry[8]), profiles[view].avg_cycles);
+        CHECK_EQ(be32(&entry[12]), profiles[view].max_cycles);
+        CHECK_EQ(be32(&entry[16]), profiles[view].p99_cycles);
+    }
+    CHECK_EQ(msg[5], 0x01);
+    CHECK_EQ(msg[5 + 12], 0xFE);
+
+    // No views: just the clock and the count
+    CHECK_EQ(mqtt_protocol_build_render_profile(profiles, 0, 160, msg, sizeof(msg)), MQTT_PROTOCOL_HEADER_SIZE + 3);
+    CHECK_EQ(msg[4], 0);
+
+    // As many views as the payload holds, and one more
+    len = mqtt_protocol_build_render_profile(profiles, MAX_PROFILE_VIEWS, 240, msg, sizeof(msg));
+    CHECK_EQ(len, MQTT_PROTOCOL_HEADER_SIZE + 3 + (MAX_PROFILE_VIEWS * 20));
+    CHECK(len - MQTT_PROTOCOL_HEADER_SIZE <= MQTT_PROTOCOL_MAX_PAYLOAD);
+    CHECK_EQ(mqtt_protocol_build_render_profile(profiles, MAX_PROFILE_VIEWS + 1, 240, msg, sizeof(msg)), -1);
+
+    // Buffer one byte short, NULL arguments
+    CHECK_EQ(mqtt_protocol_build_render_profile(profiles, NUM_PROFILE_VIEWS, 240, msg,
+                                                MQTT_PROTOCOL_HEADER_SIZE + 3 + (NUM_PROFILE_VIEWS * 20) - 1), -1);
+    CHECK_EQ(mqtt_protocol_build_render_profile(NULL, NUM_PROFILE_VIEWS, 240, msg, sizeof(msg)), -1);
+    CHECK_EQ(mqtt_protocol_build_render_profile(profiles, NUM_PROFILE_VIEWS, 240, NULL, sizeof(msg)), -1);
+}
+
+int main(void) {
+    test_render_profile();
+    return TEST_RESULT();
+}
@@ -0,0 +1,163 @@
+/* Mounting orientation (led_driver.h LED_ORIENT_*): orient_frame against a naive per pixel
+    rotate written straight from the mapping in the header, for all 4 turns with and without
+    mirror. Every single pixel of every channel is checked (the transform moves pixels, so
+    that covers it), then random frames. Benchmarks orient_frame (transpose_16x16 for the
+    quarter turns) against the naive loop.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "led_driver.h"
+
+// led_driver.c internals
+void orient_frame(const view_frame_t*, view_frame_t*, uint8_t);
+
+#define NUM_RANDOM_FRAMES   2000
+#define BENCH_FRAMES        200000
+#define NUM_ORIENTATIONS    8
+
+static const uint8_t Orientations[NUM_ORIENTATIONS] = {
+    LED_ORIENT_0, LED_ORIENT_90, LED_ORIENT_180, LED_ORIENT_270,
+    LED_ORIENT_0 | LED_ORIENT_MIRROR, LED_ORIENT_90 | LED_ORIENT_MIRROR,
+    LED_ORIENT_180 | LED_ORIENT_MIRROR, LED_ORIENT_270 | LED_ORIENT_MIRROR,
+};
+
+// (r, c) is bit c of row r
+static void naive_rows(const uint16_t *in, uint16_t *out, uint8_t orientation) {
+    memset(out, 0, 16 * sizeof(uint16_t));
+    for (uint8_t r = 0; r < 16; r++) {
+        for (uint8_t c = 0; c < 16; c++) {
+            if (!((in[r] >> c) & 1)) {
+                continue;
+            }
+            uint8_t to_r = r;
+            uint8_t to_c = c;
+            switch (orientation & LED_ORIENT_270) {
+                case LED_ORIENT_90:  to_r = c;      to_c = 15 - r; break;
+                case LED_ORIENT_180: to_r = 15 - r; to_c = 15 - c; break;
+                case LED_ORIENT_270: to_r = 15 - c; to_c = r;      break;
+            }
+            if (orientation & LED_ORIENT_MIRROR) {
+                to_c = 15 - to_c;
+            }
+            out[to_r] |= (uint16_t)(1 << to_c);
+        }
+    }
+}
+
+static void naive_frame(const view_frame_t *in, view_frame_t *out, uint8_t orientation) {
+    naive_rows(in->red, out->red, orientation);
+    naive_rows(in->green, out->green, orientation);
+    naive_rows(in->blue, out->blue, orientation);
+}
+
+static uint8_t check_equal(const view_frame_t *frame, uint8_t orientation) {
+    view_frame_t expected;
+    view_frame_t actual;
+    naive_frame(frame, &expected, orientation);
+    memset(&actual, 0xEE, sizeof(actual));
+    orient_frame(frame, &actual, orientation);
+    if (memcmp(&actual, &expected, sizeof(actual)) != 0) {
+        Test_failures++;
+        return 0;
+    }
+    return 1;
+}
+
+static void test_single_pixels(void) {
+    view_frame_t frame;
+    for (uint8_t i = 0; i < NUM_ORIENTATIONS; i++) {
+        uint16_t num_bad = 0;
+        for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+            for (uint8_t col = 0; col < 16; col++) {
+                memset(&frame, 0, sizeof(frame));
+                frame.rows[row] = (uint16_t)(1 << col);
+                num_bad += !check_equal(&frame, Orientations[i]);
+            }
+        }
+        if (num_bad) {
+            printf("FAIL orientation 0x%02x: %u of %u pixels misplaced\n", Orientations[i], num_bad, VIEW_FRAME_ROWS * 16);
+        }
+    }
+}
+
+static void test_random_frames(void) {
+    view_frame_t frame;
+    uint32_t seed = 0xACE1;
+    for (uint8_t i = 0; i < NUM_ORIENTATIONS; i++) {
+        uint16_t num_bad = 0;
+        for (uint16_t n = 0; n < NUM_RANDOM_FRAMES; n++) {
+            for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+                frame.rows[row] = (uint16_t)test_random(&seed);
+            }
+            num_bad += !check_equal(&frame, Orientations[i]);
+        }
+        if (num_bad) {
+            printf("FAIL orientation 0x%02x: %u random frames differ\n", Orientations[i], num_bad);
+        }
+    }
+}
+
+// Four quarter turns and two mirrors get back to the start
+static void test_round_trip(void) {
+    view_frame_t frame;
+    view_frame_t turned;
+    view_frame_t back;
+    uint32_t seed = 42;
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        frame.rows[row] = (uint16_t)test_random(&seed);
+    }
+    turned = frame;
+    for (uint8_t i = 0; i < 4; i++) {
+        orient_frame(&turned, &back, LED_ORIENT_90);
+        turned = back;
+    }
+    CHECK(memcmp(&turned, &frame, sizeof(frame)) == 0);
+
+    orient_frame(&frame, &turned, LED_ORIENT_0 | LED_ORIENT_MIRROR);
+    orient_frame(&turned, &back, LED_ORIENT_0 | LED_ORIENT_MIRROR);
+    CHECK(memcmp(&back, &frame, sizeof(frame)) == 0);
+}
+
+static void bench(void) {
+    view_frame_t frame;
+    view_frame_t out;
+    uint32_t seed = 7;
+    volatile uint16_t sink = 0;
+
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        frame.rows[row] = (uint16_t)test_random(&seed);
+    }
+    printf("orient one frame (3 channels), ns: orientation  naive  orient_frame\n");
+    for (uint8_t i = 0; i < NUM_ORIENTATIONS; i++) {
+        uint64_t start_ns = test_now_ns();
+        for (uint32_t n = 0; n < BENCH_FRAMES / 10; n++) {
+            frame.rows[n % VIEW_FRAME_ROWS] ^= (uint16_t)n;
+            naive_frame(&frame, &out, Orientations[i]);
+            sink ^= out.rows[n % VIEW_FRAME_ROWS];
+        }
+        uint64_t naive_ns = (test_now_ns() - start_ns) / (BENCH_FRAMES / 10);
+
+        start_ns = test_now_ns();
+        for (uint32_t n = 0; n < BENCH_FRAMES; n++) {
+            frame.rows[n % VIEW_FRAME_ROWS] ^= (uint16_t)n;
+            orient_frame(&frame, &out, Orientations[i]);
+            sink ^= out.rows[n % VIEW_FRAME_ROWS];
+        }
+        uint64_t fast_ns = (test_now_ns() - start_ns) / BENCH_FRAMES;
+
+        printf("  0x%02x  %6llu  %6llu\n", Orientations[i], (unsigned long long)naive_ns, (unsigned long long)fast_ns);
+        CHECK(fast_ns < naive_ns);
+    }
+    (void)sink;
+}
+
+int main(void) {
+    test_single_pixels();
+    test_random_frames();
+    test_round_trip();
+    bench();
+    return TEST_RESULT();
+}
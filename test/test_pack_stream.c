@@ -0,0 +1,202 @@
+/* pack_RAM_stream against the packer it replaced: the old update_RAM built the stream one
+    nibble at a time with insert_bits_MSB_buffer from the top bit of a zeroed 50 byte buffer
+    down, and Spi__Write then reversed the bytes into wire order. Both must give the same 50
+    bytes for any RAM image, including the 6 padding bits of the last byte (394 = 49 * 8 + 2).
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+
+// led_driver.c internals
+uint16_t pack_RAM_stream(uint8_t*, const uint16_t*);
+
+#define STREAM_BITS         394
+#define STREAM_BYTES        50
+#define NUM_RANDOM_FRAMES   10000
+#define BENCH_PACKS         200000
+
+// Old packer, verbatim apart from names
+static uint16_t old_insert_bits_MSB_buffer(uint8_t *tx_buffer, uint16_t current_idx, uint8_t data, uint8_t num_bits_data) {
+    uint8_t current_byte = current_idx / 8;
+    uint8_t curr_idx_in_byte = current_idx % 8;
+    uint8_t empty_bits_byte1 = curr_idx_in_byte + 1;
+
+    if(num_bits_data < empty_bits_byte1) {
+        data <<= (empty_bits_byte1 - num_bits_data);
+        tx_buffer[current_byte] |= data;
+    } else {
+        uint8_t shifted_data_first_byte = data >> (num_bits_data - empty_bits_byte1);
+        tx_buffer[current_byte] |= shifted_data_first_byte;
+
+        uint8_t bits_left_in_data = num_bits_data - empty_bits_byte1;
+        uint8_t shifted_data_second_byte = data << (8 - bits_left_in_data);
+        tx_buffer[current_byte - 1] |= shifted_data_second_byte;
+    }
+    return (current_idx - num_bits_data);
+}
+
+static uint16_t old_add_payload_to_buf(uint8_t *tx_buffer, uint16_t curr_idx, uint16_t payload, uint8_t num_bits_payload) {
+    uint8_t byte1 = (payload >> 8) & 0xFF;
+    uint8_t byte2 = payload & 0xFF;
+
+    if(num_bits_payload <= 8) {
+        curr_idx = old_insert_bits_MSB_buffer(tx_buffer, curr_idx, byte2, num_bits_payload);
+    } else {
+        curr_idx = old_insert_bits_MSB_buffer(tx_buffer, curr_idx, byte1, (num_bits_payload - 8));
+        curr_idx = old_insert_bits_MSB_buffer(tx_buffer, curr_idx, byte2, 8);
+    }
+    return curr_idx;
+}
+
+// update_RAM + the byte reversal of Spi__Write
+static void old_pack(uint8_t *wire, const uint16_t *RAM_mem) {
+    uint8_t tx_buffer[STREAM_BYTES];
+    memset(tx_buffer, 0, sizeof(tx_buffer));
+    uint16_t current_idx = STREAM_BYTES * 8 - 1;
+
+    current_idx = old_add_payload_to_buf(tx_buffer, current_idx, SET_WRITE_MODE, SET_WRITE_LEN);
+    for(uint8_t row = 0; row < 24; row++) {
+        uint16_t data_row = RAM_mem[row];
+        for(uint8_t addr = 4; addr > 0; addr--) {
+            uint8_t masked_data = (data_row >> ((addr - 1) * 4)) & 0xF;
+            current_idx = old_insert_bits_MSB_buffer(tx_buffer, current_idx, masked_data, 4);
+        }
+    }
+    for(uint8_t i_byte = 0; i_byte < STREAM_BYTES; i_byte++) {
+        wire[i_byte] = tx_buffer[(STREAM_BYTES - 1) - i_byte];
+    }
+}
+
+static void check_equal(const uint16_t *RAM, const char *what) {
+    uint8_t expected[STREAM_BYTES];
+    uint8_t actual[STREAM_BYTES + 2];
+
+    // Garbage in the buffer: every byte must be written, none past the stream
+    memset(actual, 0xEE, sizeof(actual));
+    old_pack(expected, RAM);
+    CHECK_EQ(pack_RAM_stream(actual, RAM), STREAM_BITS);
+    if (memcmp(actual, expected, STREAM_BYTES) != 0) {
+        printf("FAIL %s: streams differ\n", what);
+        Test_failures++;
+    }
+    CHECK_EQ(actual[STREAM_BYTES], 0xEE);
+    CHECK_EQ(actual[STREAM_BYTES + 1], 0xEE);
+}
+
+static void test_random_frames(void) {
+    uint16_t RAM[24];
+    uint32_t seed = 0x2545F491;
+    for (uint32_t i = 0; i < NUM_RANDOM_FRAMES; i++) {
+        for (uint8_t row = 0; row < 24; row++) {
+            RAM[row] = (uint16_t)test_random(&seed);
+        }
+        check_equal(RAM, "random frame");
+    }
+}
+
+// One bit at a time through every position, so each row boundary and the 64-bit word
+// boundaries of the packer are hit with a lone bit
+static void test_single_bits(void) {
+    uint16_t RAM[24];
+    for (uint16_t bit = 0; bit < 24 * 16; bit++) {
+        memset(RAM, 0, sizeof(RAM));
+        RAM[bit / 16] = (uint16_t)(0x8000 >> (bit % 16));
+        check_equal(RAM, "single bit");
+
+        // Stream bit 10 + bit is that bit
+        uint8_t stream[STREAM_BYTES];
+        pack_RAM_stream(stream, RAM);
+        uint16_t stream_bit = SET_WRITE_LEN + bit;
+        CHECK(stream[stream_bit / 8] & (0x80 >> (stream_bit % 8)));
+    }
+}
+
+// 394 bits end 2 bits into byte 49: those are the last 2 bits of row 23, the other 6 are padding
+static void test_last_byte(void) {
+    uint16_t RAM[24];
+    uint8_t stream[STREAM_BYTES];
+
+    memset(RAM, 0xFF, sizeof(RAM));
+    pack_RAM_stream(stream, RAM);
+    CHECK_EQ(stream[STREAM_BYTES - 1], 0xC0);
+    check_equal(RAM, "all ones");
+
+    memset(RAM, 0, sizeof(RAM));
+    RAM[23] = 0x0001;
+    pack_RAM_stream(stream, RAM);
+    CHECK_EQ(stream[STREAM_BYTES - 1], 0x40);
+    CHECK_EQ(stream[STREAM_BYTES - 2], 0x00);
+    RAM[23] = 0x0004;
+    pack_RAM_stream(stream, RAM);
+    CHECK_EQ(stream[STREAM_BYTES - 1], 0x00);
+    CHECK_EQ(stream[STREAM_BYTES - 2], 0x01);
+
+    // Header: 101 then address 0
+    memset(RAM, 0, sizeof(RAM));
+    pack_RAM_stream(stream, RAM);
+    CHECK_EQ(stream[0], 0xA0);
+    CHECK_EQ(stream[1] & 0xC0, 0x00);
+}
+
+// What the chip makes of it: clock exactly 394 bits into the emulator and read RAM back
+static void test_emulator_decode(void) {
+    uint16_t RAM[24];
+    uint16_t rows[LED_EMULATOR_RAM_ROWS];
+    uint8_t stream[STREAM_BYTES];
+    uint32_t seed = 77;
+
+    Led_emulator__Reset();
+    Led_emulator__Set_error_clock_hz(0);
+    for (uint8_t row = 0; row < 24; row++) {
+        RAM[row] = (uint16_t)test_random(&seed);
+    }
+    Led_emulator__Write(CS_RED, stream, pack_RAM_stream(stream, RAM));
+    Led_emulator__Get_RAM_rows(CS_RED, rows);
+    CHECK(memcmp(rows, RAM, sizeof(rows)) == 0);
+    CHECK_EQ(Led_emulator__Get_chip(CS_RED)->num_errors, 0);
+}
+
+static void bench(void) {
+    uint16_t RAM[24];
+    uint8_t stream[STREAM_BYTES];
+    uint32_t seed = 1;
+    volatile uint8_t sink = 0;
+
+    for (uint8_t row = 0; row < 24; row++) {
+        RAM[row] = (uint16_t)test_random(&seed);
+    }
+    uint64_t start_ns = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_PACKS; i++) {
+        RAM[i % 24] ^= (uint16_t)i;
+        old_pack(stream, RAM);
+        sink ^= stream[i % STREAM_BYTES];
+    }
+    uint64_t old_ns = test_now_ns() - start_ns;
+
+    start_ns = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_PACKS; i++) {
+        RAM[i % 24] ^= (uint16_t)i;
+        pack_RAM_stream(stream, RAM);
+        sink ^= stream[i % STREAM_BYTES];
+    }
+    uint64_t new_ns = test_now_ns() - start_ns;
+    (void)sink;
+
+    printf("pack 394 bit stream: per nibble + reverse %llu ns, 64-bit shift %llu ns (%.1fx)\n",
+           (unsigned long long)(old_ns / BENCH_PACKS), (unsigned long long)(new_ns / BENCH_PACKS),
+           (double)old_ns / (double)(new_ns ? new_ns : 1));
+    CHECK(new_ns < old_ns);
+}
+
+int main(void) {
+    test_last_byte();
+    test_single_bits();
+    test_random_frames();
+    test_emulator_decode();
+    bench();
+    return TEST_RESULT();
+}
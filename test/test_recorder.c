@@ -0,0 +1,224 @@
+/* Flight recorder (View__Recorder_dump): the dump decodes back to exactly the last frames sent,
+    whether the ring is limited by VIEW_RECORDER_FRAMES or by VIEW_RECORDER_BYTES. Then with
+    the display task running (View__Initialize), a second task dumps over and over while
+    frames are being recorded; every dump must decode to whole frames in order, never a
+    half written entry. Prints how long a full dump takes (host clock).
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "led_driver.h"
+#include "view.h"
+
+// view.c internals
+void record_frame(const view_frame_t*, View_type);
+
+#define NUM_FRAMES          100
+#define NUM_LIVE_FRAMES     80
+#define TAG_ROW(row)        ((uint16_t)(0x5A5A ^ (row)))
+
+typedef struct {
+    view_frame_t frames[VIEW_RECORDER_FRAMES];
+    uint8_t views[VIEW_RECORDER_FRAMES];
+    uint32_t times_ms[VIEW_RECORDER_FRAMES];
+    uint16_t num_frames;
+} decoded_t;
+
+static uint8_t Dump[VIEW_RECORDER_DUMP_LEN];
+static volatile uint8_t Live_done;
+static uint32_t Num_dumps;
+static uint32_t Num_bad_dumps;
+static uint64_t Max_dump_ns;
+
+static uint32_t be32(const uint8_t *bytes) {
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+// Layout as documented at View__Recorder_dump. 0 if the lengths do not add up.
+static uint8_t decode(const uint8_t *dump, int len, decoded_t *out) {
+    if (len < 2) {
+        return 0;
+    }
+    out->num_frames = (uint16_t)((dump[0] << 8) | dump[1]);
+    if (out->num_frames == 0) {
+        return len == 2;
+    }
+    if (out->num_frames > VIEW_RECORDER_FRAMES || len < 7 + 2 * VIEW_FRAME_ROWS) {
+        return 0;
+    }
+    int idx = 2;
+    out->times_ms[0] = be32(&dump[idx]);
+    out->views[0] = dump[idx + 4];
+    idx += 5;
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        out->frames[0].rows[row] = (uint16_t)((dump[idx] << 8) | dump[idx + 1]);
+        idx += 2;
+    }
+    for (uint16_t n = 1; n < out->num_frames; n++) {
+        if (idx + 6 > len) {
+            return 0;
+        }
+        out->times_ms[n] = be32(&dump[idx]);
+        out->views[n] = dump[idx + 4];
+        uint8_t num_rows = dump[idx + 5];
+        idx += 6;
+        if (num_rows > VIEW_FRAME_ROWS || idx + 3 * num_rows > len) {
+            return 0;
+        }
+        out->frames[n] = out->frames[n - 1];
+        for (uint8_t i = 0; i < num_rows; i++) {
+            uint8_t row = dump[idx];
+            if (row >= VIEW_FRAME_ROWS) {
+                return 0;
+            }
+            out->frames[n].rows[row] ^= (uint16_t)((dump[idx + 1] << 8) | dump[idx + 2]);
+            idx += 3;
+        }
+    }
+    return idx == len;
+}
+
+// Sequence number in row 0, its complement in row 1, a fixed pattern in the rest
+static void tagged_frame(view_frame_t *frame, uint16_t seq) {
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        frame->rows[row] = TAG_ROW(row);
+    }
+    frame->rows[0] = seq;
+    frame->rows[1] = (uint16_t)~seq;
+}
+
+static uint8_t is_tagged(const view_frame_t *frame) {
+    if (frame->rows[1] != (uint16_t)~frame->rows[0]) {
+        return 0;
+    }
+    for (uint8_t row = 2; row < VIEW_FRAME_ROWS; row++) {
+        if (frame->rows[row] != TAG_ROW(row)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void check_recorded(const view_frame_t *sent, const uint8_t *views, uint16_t num_sent, uint16_t expect_frames) {
+    static decoded_t decoded;
+    int len = View__Recorder_dump(Dump, sizeof(Dump));
+    CHECK(decode(Dump, len, &decoded));
+    CHECK_EQ(decoded.num_frames, expect_frames);
+    if (decoded.num_frames != expect_frames) {
+        return;
+    }
+    for (uint16_t n = 0; n < expect_frames; n++) {
+        uint16_t i = num_sent - expect_frames + n;
+        if (memcmp(&decoded.frames[n], &sent[i], sizeof(view_frame_t)) != 0 || decoded.views[n] != views[i]) {
+            printf("FAIL recorded frame %u of %u differs from frame %u sent\n", n, expect_frames, i);
+            Test_failures++;
+            return;
+        }
+        if (n > 0 && decoded.times_ms[n] < decoded.times_ms[n - 1]) {
+            printf("FAIL recorded frame %u older than the one before\n", n);
+            Test_failures++;
+        }
+    }
+}
+
+// Every row changes: 150 byte entries, the byte budget runs out before the frame count
+static void test_byte_budget(void) {
+    static view_frame_t sent[NUM_FRAMES];
+    uint8_t views[NUM_FRAMES];
+    uint32_t seed = 99;
+
+    for (uint16_t i = 0; i < NUM_FRAMES; i++) {
+        for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+            sent[i].rows[row] = (uint16_t)test_random(&seed);
+            if (i > 0 && sent[i].rows[row] == sent[i - 1].rows[row]) {
+                sent[i].rows[row] ^= 1;
+            }
+        }
+        views[i] = (uint8_t)(i % NUM_MAIN_VIEWS);
+        record_frame(&sent[i], views[i]);
+    }
+    check_recorded(sent, views, NUM_FRAMES, 1 + VIEW_RECORDER_BYTES / (6 + 3 * VIEW_FRAME_ROWS));
+}
+
+// Two rows change per frame: the frame count is the limit
+static void test_frame_limit(void) {
+    static view_frame_t sent[NUM_FRAMES];
+    uint8_t views[NUM_FRAMES];
+
+    for (uint16_t i = 0; i < NUM_FRAMES; i++) {
+        tagged_frame(&sent[i], i);
+        views[i] = VIEW_MENU;
+        record_frame(&sent[i], views[i]);
+    }
+    check_recorded(sent, views, NUM_FRAMES, VIEW_RECORDER_FRAMES);
+}
+
+static void dump_task(void *arg) {
+    static decoded_t decoded;
+    while (!Live_done) {
+        uint64_t start_ns = test_now_ns();
+        int len = View__Recorder_dump(Dump, sizeof(Dump));
+        uint64_t dump_ns = test_now_ns() - start_ns;
+        Max_dump_ns = (dump_ns > Max_dump_ns) ? dump_ns : Max_dump_ns;
+
+        uint8_t ok = decode(Dump, len, &decoded);
+        for (uint16_t n = 0; ok && n < decoded.num_frames; n++) {
+            ok = is_tagged(&decoded.frames[n]) && (n == 0 || decoded.frames[n].rows[0] > decoded.frames[n - 1].rows[0]);
+        }
+        Num_dumps++;
+        Num_bad_dumps += !ok;
+        vTaskDelay(1);
+    }
+    Live_done = 2;
+    vTaskDelete(NULL);
+}
+
+// Display task records (it is the only writer), this task and the dump task read
+static void test_live(void) {
+    view_frame_t frame;
+    static decoded_t decoded;
+    uint16_t seq = NUM_FRAMES;
+
+    tagged_frame(&frame, seq);
+    View__Layer_set(VIEW_LAYER_OVERLAY, &frame, NULL, VIEW_BLEND_REPLACE);
+    Led_driver__Initialize();
+    View__Initialize();
+    xTaskCreate(dump_task, "recorder_dump", 4096, NULL, 1, NULL);
+
+    for (uint16_t i = 0; i < NUM_LIVE_FRAMES; i++) {
+        tagged_frame(&frame, ++seq);
+        View__Layer_set(VIEW_LAYER_OVERLAY, &frame, NULL, VIEW_BLEND_REPLACE);
+        View__Request_compose();
+        vTaskDelay(pdMS_TO_TICKS(VIEW_MIN_FRAME_INTERVAL_MS + 10));
+    }
+    Live_done = 1;
+    while (Live_done != 2) {
+        vTaskDelay(1);
+    }
+
+    int len = View__Recorder_dump(Dump, sizeof(Dump));
+    CHECK(decode(Dump, len, &decoded));
+    CHECK_EQ(decoded.num_frames, VIEW_RECORDER_FRAMES);
+    CHECK_EQ(decoded.frames[decoded.num_frames - 1].rows[0], seq);
+
+    printf("%lu dumps while recording, %lu bad, longest %llu us (host clock)\n", (unsigned long)Num_dumps,
+           (unsigned long)Num_bad_dumps, (unsigned long long)(Max_dump_ns / 1000));
+    CHECK(Num_dumps > NUM_LIVE_FRAMES);
+    CHECK_EQ(Num_bad_dumps, 0);
+}
+
+int main(void) {
+    uint8_t small[16];
+    CHECK_EQ(View__Recorder_dump(small, sizeof(small)), -1);
+    CHECK_EQ(View__Recorder_dump(Dump, sizeof(Dump)), 2);
+
+    test_byte_budget();
+    test_frame_limit();
+    test_live();
+    return TEST_RESULT();
+}
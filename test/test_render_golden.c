@@ -0,0 +1,215 @@
+/* Render every view from a fixed seed and compare the frames with test/golden.
+    Frames are rendered the way the display task does it (build_new_view), but synchronously:
+    View__Initialize is never called, so there is no display task and View__Request_update
+    only marks the view dirty. Each frame is exported with View__Frame_to_json and compared
+    as text with golden/<scenario>_<frame>.json, the tools/view_creator format, so a golden
+    can be opened in visualize_display.py and a failing frame diffed.
+
+    GOLDEN_UPDATE=1 rewrites the goldens instead of comparing (after an intended change).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "esp_random.h"
+#include "view.h"
+#include "menu.h"
+#include "weather.h"
+#include "conway.h"
+#include "etchsketch.h"
+#include "music.h"
+#include "provisioning_view.h"
+#include "bootup_view.h"
+#include "mqtt_protocol.h"
+
+// view.c internals
+void build_new_view(void);
+
+#define MAX_STEPS       6
+
+// UI events as View__Process_UI takes them (see view.c)
+#define UI_BTN1         0x01
+#define UI_BTN2         0x02
+#define UI_BTN3         0x04
+#define UI_BTN4         0x08
+#define UI_TOP_CW       0x10
+#define UI_TOP_CCW      0x20
+#define UI_SIDE_CW      0x40
+#define UI_SIDE_CCW     0x80
+#define UI_UP           0x100
+
+typedef struct {
+    const char *name;
+    View_type view;
+    uint32_t seed;
+    void (*initialize)(void);
+    void (*setup)(void);
+    uint8_t num_steps;
+    uint16_t events[MAX_STEPS];     // Fed before the frame of that step, 0 = none
+} scenario_t;
+
+static int Update_goldens;
+
+static void weather_setup(void) {
+    uint8_t current[1] = {TEMP_OFFSET + 72};
+    uint8_t forecast[10] = {0, 85, 40, 3, 79, 10, 4, 68, 90, 5};
+    Weather__Update_values(0, current, sizeof(current));
+    Weather__Update_values(1, forecast, sizeof(forecast));
+}
+
+static const scenario_t Scenarios[] = {
+    {"bootup", VIEW_BOOTUP, 0x1234, Bootup_View__Initialize, NULL, 3, {0}},
+    {"menu", VIEW_MENU, 1, Menu__Initialize, NULL, 4, {0, UI_TOP_CW, UI_TOP_CW, UI_TOP_CCW}},
+    {"weather", VIEW_WEATHER, 1, Weather__Initialize, weather_setup, 2, {0, UI_SIDE_CW}},
+    {"conway", VIEW_CONWAY, 0xC0FFEE, Conway__Initialize, NULL, 5, {0}},
+    {"etchsketch", VIEW_ETCHSKETCH, 1, Etchsketch__Initialize, NULL, 5,
+        {0, UI_TOP_CW, UI_SIDE_CW, UI_BTN2, UI_BTN2 | UI_UP}},
+    {"music", VIEW_MUSIC, 1, Music__Initialize, NULL, 3, {0, UI_TOP_CW, UI_SIDE_CW}},
+    {"provisioning", VIEW_PROVISIONING, 1, Provisioning_View__Initialize, NULL, 2, {0, UI_TOP_CW}},
+};
+#define NUM_SCENARIOS   (sizeof(Scenarios) / sizeof(Scenarios[0]))
+
+static int read_file(const char *path, char *buffer, size_t buffer_size) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    size_t len = fread(buffer, 1, buffer_size - 1, file);
+    fclose(file);
+    buffer[len] = '\0';
+    return (int)len;
+}
+
+static int write_file(const char *path, const char *text) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        return -1;
+    }
+    fputs(text, file);
+    fclose(file);
+    return 0;
+}
+
+static void check_frame(const char *scenario, uint8_t step, const view_frame_t *frame) {
+    char json[VIEW_FRAME_JSON_LEN];
+    char golden[2 * VIEW_FRAME_JSON_LEN];
+    char path[512];
+
+    int len = View__Frame_to_json(frame, json, sizeof(json));
+    CHECK(len > 0);
+    if (len <= 0) {
+        return;
+    }
+    snprintf(path, sizeof(path), "%s/%s_%u.json", GOLDEN_DIR, scenario, step);
+
+    if (Update_goldens) {
+        CHECK_EQ(write_file(path, json), 0);
+        return;
+    }
+    if (read_file(path, golden, sizeof(golden)) < 0) {
+        printf("FAIL missing golden %s (run with GOLDEN_UPDATE=1)\n", path);
+        Test_failures++;
+        return;
+    }
+    if (strcmp(json, golden) != 0) {
+        printf("FAIL %s frame %u differs from %s, rendered:\n%s", scenario, step, path, json);
+        Test_failures++;
+    }
+}
+
+static void run_scenario(const scenario_t *scenario) {
+    // Hardware random too, for views that draw from esp_random directly
+    host_random_seed(scenario->seed);
+    View__Seed_random(scenario->seed);
+    scenario->initialize();
+    if (scenario->setup) {
+        scenario->setup();
+    }
+    View__Set_view(scenario->view);
+
+    for (uint8_t step = 0; step < scenario->num_steps; step++) {
+        if (scenario->events[step]) {
+            View__Process_UI(scenario->events[step]);
+        }
+        View__Request_update();
+        build_new_view();
+
+        view_frame_t frame;
+        View__Get_frame(&frame);
+        check_frame(scenario->name, step, &frame);
+    }
+}
+
+// Same seed, same frames: the property the goldens rest on
+static void test_seed_repeats(void) {
+    view_frame_t first;
+    view_frame_t second;
+
+    View__Seed_random(42);
+    Conway__Initialize();
+    View__Set_view(VIEW_CONWAY);
+    View__Request_update();
+    build_new_view();
+    View__Get_frame(&first);
+
+    View__Seed_random(42);
+    Conway__Initialize();
+    View__Request_update();
+    build_new_view();
+    View__Get_frame(&second);
+    CHECK(memcmp(&first, &second, sizeof(first)) == 0);
+
+    View__Seed_random(43);
+    Conway__Initialize();
+    View__Request_update();
+    build_new_view();
+    View__Get_frame(&second);
+    CHECK(memcmp(&first, &second, sizeof(first)) != 0);
+}
+
+static void test_json_format(void) {
+    view_frame_t frame;
+    char json[VIEW_FRAME_JSON_LEN];
+
+    memset(&frame, 0, sizeof(frame));
+    frame.red[0] = 0x8001;
+    frame.green[15] = 0xFFFF;
+    frame.blue[7] = 0x00A5;
+    int len = View__Frame_to_json(&frame, json, sizeof(json));
+    CHECK(len > 0);
+    CHECK_EQ(len, (int)strlen(json));
+    CHECK(strncmp(json, "{\n  \"red\":   [\"0x8001\", \"0x0000\"", 32) == 0);
+    CHECK(strstr(json, "\"0xFFFF\"]") != NULL);
+    CHECK(strstr(json, "\"0x00A5\"") != NULL);
+
+    // Too small is an error, not a truncated document
+    CHECK_EQ(View__Frame_to_json(&frame, json, 100), -1);
+}
+
+static void print_render_times(void) {
+    for (uint8_t i = 0; i < NUM_SCENARIOS; i++) {
+        view_render_times_t times;
+        memset(&times, 0, sizeof(times));
+        View__Get_render_times(Scenarios[i].view, &times);
+        printf("%-13s renders %3lu cycles p50 %6lu p90 %6lu p99 %6lu (host clock)\n", Scenarios[i].name,
+               (unsigned long)times.num_samples, (unsigned long)times.p50_cycles,
+               (unsigned long)times.p90_cycles, (unsigned long)times.p99_cycles);
+    }
+}
+
+int main(void) {
+    const char *update = getenv("GOLDEN_UPDATE");
+    Update_goldens = update && update[0] == '1';
+    View__Set_transition(VIEW_TRANSITION_NONE);
+
+    test_json_format();
+    for (uint8_t i = 0; i < NUM_SCENARIOS; i++) {
+        run_scenario(&Scenarios[i]);
+    }
+    test_seed_repeats();
+
+    print_render_times();
+    return TEST_RESULT();
+}
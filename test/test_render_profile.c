@@ -0,0 +1,115 @@
+/* Render profiler (view.h VIEW_PROFILE, View__Get_render_times). Known samples give known
+    min / avg / max and p50 / p90 / p99 (nearest rank). Once the VIEW_RENDER_SAMPLES ring has
+    wrapped the percentiles cover only the newest samples and the rest everything, and views
+    do not share samples. Every build_new_view adds one. Also built with VIEW_PROFILE=0, where
+    nothing is recorded and the report stays zero.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "led_driver.h"
+#include "view.h"
+#include "menu.h"
+
+// view.c internals
+void build_new_view(void);
+#if VIEW_PROFILE
+void record_render_cycles(View_type, uint32_t);
+#endif
+
+#define NUM_RENDERS     10
+
+#if VIEW_PROFILE
+// 1..100 in a scrambled order (37 is coprime with 100)
+static void test_known_samples(void) {
+    view_render_times_t times;
+
+    for (uint32_t i = 0; i < 100; i++) {
+        record_render_cycles(VIEW_WEATHER, 1 + ((i * 37) % 100));
+    }
+    View__Get_render_times(VIEW_WEATHER, &times);
+    CHECK_EQ(times.num_samples, 100);
+    CHECK_EQ(times.min_cycles, 1);
+    CHECK_EQ(times.max_cycles, 100);
+    CHECK_EQ(times.avg_cycles, 50);
+    // The ring keeps the last VIEW_RENDER_SAMPLES of them
+    uint32_t kept[VIEW_RENDER_SAMPLES];
+    for (uint32_t n = 0; n < VIEW_RENDER_SAMPLES; n++) {
+        kept[n] = 1 + (((100 - VIEW_RENDER_SAMPLES + n) * 37) % 100);
+    }
+    for (uint32_t i = 1; i < VIEW_RENDER_SAMPLES; i++) {
+        for (uint32_t j = i; j > 0 && kept[j - 1] > kept[j]; j--) {
+            uint32_t swap = kept[j];
+            kept[j] = kept[j - 1];
+            kept[j - 1] = swap;
+        }
+    }
+    CHECK_EQ(times.p50_cycles, kept[(VIEW_RENDER_SAMPLES * 50 + 99) / 100 - 1]);
+    CHECK_EQ(times.p90_cycles, kept[(VIEW_RENDER_SAMPLES * 90 + 99) / 100 - 1]);
+    CHECK_EQ(times.p99_cycles, kept[(VIEW_RENDER_SAMPLES * 99 + 99) / 100 - 1]);
+}
+
+// Fewer samples than the ring: exact nearest rank over all of them
+static void test_small_ring(void) {
+    static const uint32_t Samples[] = {700, 100, 300, 900, 500, 200, 800, 400, 1000, 600};
+    view_render_times_t times;
+
+    for (uint8_t i = 0; i < 10; i++) {
+        record_render_cycles(VIEW_CONWAY, Samples[i]);
+    }
+    View__Get_render_times(VIEW_CONWAY, &times);
+    CHECK_EQ(times.num_samples, 10);
+    CHECK_EQ(times.min_cycles, 100);
+    CHECK_EQ(times.max_cycles, 1000);
+    CHECK_EQ(times.avg_cycles, 550);
+    CHECK_EQ(times.p50_cycles, 500);
+    CHECK_EQ(times.p90_cycles, 900);
+    CHECK_EQ(times.p99_cycles, 1000);
+
+    // One sample: every figure is that sample
+    record_render_cycles(VIEW_MUSIC, 1234);
+    View__Get_render_times(VIEW_MUSIC, &times);
+    CHECK_EQ(times.num_samples, 1);
+    CHECK_EQ(times.min_cycles, 1234);
+    CHECK_EQ(times.p50_cycles, 1234);
+    CHECK_EQ(times.p99_cycles, 1234);
+}
+#endif
+
+static void test_renders(void) {
+    view_render_times_t times;
+
+    View__Get_render_times(VIEW_MENU, &times);
+    CHECK_EQ(times.num_samples, 0);
+    CHECK_EQ(times.max_cycles, 0);
+
+    for (uint8_t i = 0; i < NUM_RENDERS; i++) {
+        View__Request_update();
+        build_new_view();
+    }
+    View__Get_render_times(VIEW_MENU, &times);
+    CHECK_EQ(times.num_samples, VIEW_PROFILE ? NUM_RENDERS : 0);
+    CHECK(VIEW_PROFILE ? (times.max_cycles >= times.p50_cycles && times.p50_cycles >= times.min_cycles) : (times.max_cycles == 0));
+    printf("menu render, VIEW_PROFILE %u: %lu samples, p50 %lu cycles\n", VIEW_PROFILE,
+           (unsigned long)times.num_samples, (unsigned long)times.p50_cycles);
+}
+
+int main(void) {
+    view_render_times_t times;
+
+    Led_driver__Initialize();
+    View__Set_transition(VIEW_TRANSITION_NONE);
+    Menu__Initialize();
+    View__Set_view(VIEW_MENU);
+
+    test_renders();
+#if VIEW_PROFILE
+    test_known_samples();
+    test_small_ring();
+#endif
+    View__Get_render_times(VIEW_ETCHSKETCH, &times);
+    CHECK_EQ(times.num_samples, 0);
+    return TEST_RESULT();
+}
@@ -0,0 +1,158 @@
+/* Display task scheduling (view.h VIEW_MIN_FRAME_INTERVAL_MS, View__Get_sched_stats), with the
+    task running from View__Initialize. A burst of View__Request_update calls merges into one
+    or two renders, and a steady stream faster than the cap renders at most once per
+    VIEW_MIN_FRAME_INTERVAL_MS; either way every request is a render or a merge. With no
+    requests a view is rendered on its refresh deadline, none missed. A transition stalled
+    past its next frame's deadline (the test holding the critical section, as a higher
+    priority task hogging the core would) counts a miss.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+#include "view.h"
+#include "conway.h"
+
+#define BURST_REQUESTS      50
+#define STREAM_MS           600
+#define CONWAY_REFRESH_MS   400     // Fastest Conway refresh, 3 presses of button 3 from 1000
+#define DEADLINE_WINDOW_MS  2100
+#define STALL_MS            200
+
+#define UI_BTN1             0x01
+
+static void sched_delta(const view_sched_stats_t *before, view_sched_stats_t *delta) {
+    view_sched_stats_t after;
+    View__Get_sched_stats(&after);
+    delta->num_requests = after.num_requests - before->num_requests;
+    delta->num_merged_requests = after.num_merged_requests - before->num_merged_requests;
+    delta->num_renders = after.num_renders - before->num_renders;
+    delta->num_deadline_renders = after.num_deadline_renders - before->num_deadline_renders;
+    delta->num_deadline_misses = after.num_deadline_misses - before->num_deadline_misses;
+}
+
+// Every request either triggered a render or was merged into one
+static void check_accounted(const view_sched_stats_t *delta, const char *what) {
+    uint32_t request_renders = delta->num_renders - delta->num_deadline_renders;
+    if (delta->num_merged_requests + request_renders != delta->num_requests) {
+        printf("FAIL %s: %lu requests, %lu merged + %lu renders\n", what, (unsigned long)delta->num_requests,
+               (unsigned long)delta->num_merged_requests, (unsigned long)request_renders);
+        Test_failures++;
+    }
+}
+
+static void test_burst(void) {
+    view_sched_stats_t before;
+    view_sched_stats_t delta;
+
+    View__Get_sched_stats(&before);
+    for (uint8_t i = 0; i < BURST_REQUESTS; i++) {
+        View__Request_update();
+    }
+    vTaskDelay(pdMS_TO_TICKS(4 * VIEW_MIN_FRAME_INTERVAL_MS));
+    sched_delta(&before, &delta);
+
+    printf("burst: %lu requests, %lu renders\n", (unsigned long)delta.num_requests, (unsigned long)delta.num_renders);
+    CHECK_EQ(delta.num_requests, BURST_REQUESTS);
+    CHECK(delta.num_renders >= 1);
+    CHECK(delta.num_renders <= 2);
+    CHECK_EQ(delta.num_deadline_renders, 0);
+    check_accounted(&delta, "burst");
+}
+
+static void test_rate_cap(void) {
+    view_sched_stats_t before;
+    view_sched_stats_t delta;
+
+    View__Get_sched_stats(&before);
+    int64_t start_us = esp_timer_get_time();
+    uint32_t num_sent = 0;
+    while (esp_timer_get_time() - start_us < STREAM_MS * 1000) {
+        View__Request_update();
+        num_sent++;
+        vTaskDelay(1);      // One tick, a third of the frame interval
+    }
+    vTaskDelay(pdMS_TO_TICKS(2 * VIEW_MIN_FRAME_INTERVAL_MS));
+    sched_delta(&before, &delta);
+
+    printf("stream: %lu requests over %u ms, %lu renders (cap %u)\n", (unsigned long)delta.num_requests, STREAM_MS,
+           (unsigned long)delta.num_renders, STREAM_MS / VIEW_MIN_FRAME_INTERVAL_MS + 1);
+    CHECK_EQ(delta.num_requests, num_sent);
+    CHECK(delta.num_renders <= STREAM_MS / VIEW_MIN_FRAME_INTERVAL_MS + 2);
+    CHECK(delta.num_renders >= STREAM_MS / (2 * VIEW_MIN_FRAME_INTERVAL_MS));
+    CHECK(delta.num_merged_requests > 0);
+    check_accounted(&delta, "stream");
+}
+
+// Conway at its fastest refresh and nothing else: renders come from the deadline only
+static void test_deadlines(void) {
+    view_sched_stats_t before;
+    view_sched_stats_t delta;
+
+    View__Set_view(VIEW_CONWAY);
+    for (uint8_t i = 0; i < 3; i++) {
+        Conway__UI_Button(2);
+    }
+    CHECK_EQ(Conway__Get_refresh_rate_ms(), CONWAY_REFRESH_MS);
+    View__Request_update();
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    View__Get_sched_stats(&before);
+    vTaskDelay(pdMS_TO_TICKS(DEADLINE_WINDOW_MS));
+    sched_delta(&before, &delta);
+
+    printf("deadlines: %lu renders in %u ms at %u ms refresh, %lu missed\n", (unsigned long)delta.num_deadline_renders,
+           DEADLINE_WINDOW_MS, CONWAY_REFRESH_MS, (unsigned long)delta.num_deadline_misses);
+    CHECK_EQ(delta.num_requests, 0);
+    CHECK_EQ(delta.num_renders, delta.num_deadline_renders);
+    CHECK(delta.num_deadline_renders >= DEADLINE_WINDOW_MS / CONWAY_REFRESH_MS - 1);
+    CHECK(delta.num_deadline_renders <= DEADLINE_WINDOW_MS / CONWAY_REFRESH_MS + 1);
+    CHECK_EQ(delta.num_deadline_misses, 0);
+}
+
+// Transition frames are due VIEW_MIN_FRAME_INTERVAL_MS apart: stall the display task mid way
+static void test_miss(void) {
+    static portMUX_TYPE stall_lock = portMUX_INITIALIZER_UNLOCKED;
+    view_sched_stats_t before;
+    view_sched_stats_t delta;
+
+    View__Set_view(VIEW_MENU);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    View__Set_transition(VIEW_TRANSITION_SLIDE);
+    View__Get_sched_stats(&before);
+    View__Process_UI(UI_BTN1);
+    vTaskDelay(pdMS_TO_TICKS(3 * VIEW_MIN_FRAME_INTERVAL_MS));
+
+    portENTER_CRITICAL(&stall_lock);
+    int64_t stall_end_us = esp_timer_get_time() + (STALL_MS * 1000);
+    while (esp_timer_get_time() < stall_end_us) {
+    }
+    portEXIT_CRITICAL(&stall_lock);
+
+    vTaskDelay(pdMS_TO_TICKS(VIEW_TRANSITION_FRAMES * VIEW_MIN_FRAME_INTERVAL_MS));
+    sched_delta(&before, &delta);
+    printf("stalled transition: %lu missed\n", (unsigned long)delta.num_deadline_misses);
+    CHECK(delta.num_deadline_misses >= 1);
+    View__Set_transition(VIEW_TRANSITION_NONE);
+}
+
+int main(void) {
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+    View__Set_transition(VIEW_TRANSITION_NONE);
+    View__Initialize();
+    View__Set_view(VIEW_MENU);
+    vTaskDelay(pdMS_TO_TICKS(200));
+
+    test_burst();
+    test_rate_cap();
+    test_deadlines();
+    test_miss();
+    return TEST_RESULT();
+}
@@ -0,0 +1,124 @@
+/* RAM scrubber: on a transport with read-back (emulator) a flipped RAM bit is found and
+    rewritten, and a bus clock so fast that a window costs under 1 us still gives bounded
+    passes. Built for SPI too (test_scrub_spi): with RD not wired there is no read-back, so
+    the scrub task must not exist at all.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+
+// led_driver.c internals
+typedef struct {
+    uint16_t red[24];
+    uint16_t blue[24];
+} RAM_image_t;
+void translate_view_to_RAM(const view_frame_t*, RAM_image_t*);
+
+#define SCRUB_TASK_NAME     "LedDriver_Scrub"
+#define MAX_TASKS           32
+
+static uint8_t scrub_task_exists(void) {
+    TaskStatus_t status[MAX_TASKS];
+    UBaseType_t num_tasks = uxTaskGetSystemState(status, MAX_TASKS, NULL);
+    for (UBaseType_t i = 0; i < num_tasks; i++) {
+        if (strcmp(status[i].pcTaskName, SCRUB_TASK_NAME) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void show_frame(view_frame_t *frame) {
+    led_driver_stats_t stats;
+    uint32_t seed = 11;
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        frame->rows[row] = (uint16_t)test_random(&seed);
+    }
+    Led_driver__Get_stats(&stats);
+    uint32_t num_frames = stats.num_frames;
+    Led_driver__Update_RAM(frame);
+    int64_t give_up_us = esp_timer_get_time() + 5000000;
+    while (stats.num_frames == num_frames && esp_timer_get_time() < give_up_us) {
+        Led_driver__Get_stats(&stats);
+    }
+}
+
+#if LED_CLOCK_CALIBRATION
+static void wait_scrub_passes(uint32_t num_passes) {
+    led_driver_stats_t stats;
+    int64_t give_up_us = esp_timer_get_time() + 10000000;
+    do {
+        vTaskDelay(pdMS_TO_TICKS(LED_SCRUB_PERIOD_MS));
+        Led_driver__Get_stats(&stats);
+    } while (stats.num_scrub_passes < num_passes && esp_timer_get_time() < give_up_us);
+}
+
+// Whole bus for scrubbing: a bit flipped on the blue chip is back within a pass
+static void test_repair(const view_frame_t *frame) {
+    RAM_image_t expected;
+    uint16_t rows[LED_EMULATOR_RAM_ROWS];
+    led_driver_stats_t stats;
+
+    Led_emulator__Flip_RAM_bit(CS_BLUE, 37, 2);
+    Led_driver__Set_scrub_budget(1000000);
+    Led_driver__Get_stats(&stats);
+    wait_scrub_passes(stats.num_scrub_passes + 1);
+
+    Led_driver__Get_stats(&stats);
+    CHECK_EQ(stats.num_scrub_repairs, 1);
+    translate_view_to_RAM(frame, &expected);
+    Led_emulator__Get_RAM_rows(CS_BLUE, rows);
+    CHECK(memcmp(rows, expected.blue, sizeof(rows)) == 0);
+    Led_emulator__Get_RAM_rows(CS_RED, rows);
+    CHECK(memcmp(rows, expected.red, sizeof(rows)) == 0);
+}
+
+// 100 MHz: a window is well under 1 us of wire time. Each period still reads at most one pass.
+static void test_fast_clock(void) {
+    led_driver_stats_t before;
+    led_driver_stats_t after;
+    uint32_t windows_per_pass = ((96 + LED_SCRUB_WINDOW_ADDR - 1) / LED_SCRUB_WINDOW_ADDR) * LED_NUM_PANELS * 2;
+
+    Led_driver__Set_clock_hz(100000000);
+    vTaskDelay(pdMS_TO_TICKS(LED_SCRUB_PERIOD_MS));
+    Led_driver__Get_stats(&before);
+    vTaskDelay(pdMS_TO_TICKS(4 * LED_SCRUB_PERIOD_MS));
+    Led_driver__Get_stats(&after);
+
+    uint32_t num_windows = after.num_scrub_windows - before.num_scrub_windows;
+    printf("%lu windows in 4 periods at 100 MHz (%lu per pass)\n", (unsigned long)num_windows, (unsigned long)windows_per_pass);
+    CHECK(num_windows > 0);
+    CHECK(num_windows <= 5 * windows_per_pass);
+    CHECK_EQ(after.num_scrub_repairs, before.num_scrub_repairs);
+}
+#endif
+
+int main(void) {
+    view_frame_t frame;
+
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+    show_frame(&frame);
+
+#if LED_CLOCK_CALIBRATION
+    CHECK(scrub_task_exists());
+    test_repair(&frame);
+    test_fast_clock();
+#else
+    // No read-back: no task, nothing read
+    led_driver_stats_t stats;
+    Led_driver__Set_scrub_budget(1000000);
+    vTaskDelay(pdMS_TO_TICKS(2 * LED_SCRUB_PERIOD_MS));
+    Led_driver__Get_stats(&stats);
+    CHECK(!scrub_task_exists());
+    CHECK_EQ(stats.num_scrub_windows, 0);
+#endif
+    return TEST_RESULT();
+}
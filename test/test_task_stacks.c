@@ -0,0 +1,120 @@
+/* Stack high water marks of the Task_table tasks that build on the host: display, LED
+    transmit, LED scrub, event dispatcher and the etchsketch flush worker, read through
+    Tasks__Get_stats as the heartbeat reads them on the target. Input goes through the event
+    queue into every menu entry and back, with transitions, paint mode, a sleep / wake fade and
+    INFO logging on, then each task must report its table stack size and have STACK_MARGIN
+    bytes it never touched. Host x86-64 frames are not Xtensa frames, so this only catches a
+    change that blows a stack; the table sizes come from target readings (tasks.c). Button /
+    encoder polling, the periodic network tasks, OTA and BLE do not build here.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "tasks.h"
+#include "event_system.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+#include "view.h"
+
+#define STACK_MARGIN        512
+#define EVENT_GAP_MS        60
+#define NUM_MENU_ENTRIES    5
+
+#define UI_BTN1             0x01
+#define UI_BTN2             0x02
+#define UI_TOP_CW           0x10
+#define UI_SIDE_CW          0x40
+#define UI_SIDE_CCW         0x80
+
+static const char *Measured[] = {
+    "BlockingTask_UpdateDisplay",
+    "LedDriver_Transmit",
+    "LedDriver_Scrub",
+    "EventDispatcher",
+    "FlushWorker",
+};
+#define NUM_MEASURED    (sizeof(Measured) / sizeof(Measured[0]))
+
+static void post(event_type_t type, uint32_t data) {
+    EventSystem_PostEvent(type, data, NULL);
+    vTaskDelay(pdMS_TO_TICKS(EVENT_GAP_MS));
+}
+
+static void press(uint32_t button) {
+    post(EVENT_UI_BUTTON_DOWN, button);
+    post(EVENT_UI_BUTTON_UP, button);
+}
+
+// Into each view from the menu, a few turns and buttons there, and back out
+static void workload(void) {
+    View__Set_view(VIEW_MENU);
+    vTaskDelay(pdMS_TO_TICKS(EVENT_GAP_MS));
+
+    for (uint8_t entry = 0; entry < NUM_MENU_ENTRIES; entry++) {
+        press(UI_BTN1);
+        vTaskDelay(pdMS_TO_TICKS(VIEW_TRANSITION_FRAMES * VIEW_MIN_FRAME_INTERVAL_MS));
+        post(EVENT_UI_ENCODER, UI_TOP_CW);
+        post(EVENT_UI_ENCODER, UI_SIDE_CW);
+        post(EVENT_UI_BUTTON_DOWN, UI_BTN2);
+        post(EVENT_UI_ENCODER, UI_TOP_CW);
+        post(EVENT_UI_ENCODER, UI_SIDE_CCW);
+        post(EVENT_UI_BUTTON_UP, UI_BTN2);
+        press(UI_BTN1);
+        vTaskDelay(pdMS_TO_TICKS(VIEW_TRANSITION_FRAMES * VIEW_MIN_FRAME_INTERVAL_MS));
+        post(EVENT_UI_ENCODER, UI_TOP_CW);
+    }
+
+    View__Set_display_state(0);
+    vTaskDelay(pdMS_TO_TICKS(1500));
+    View__Set_display_state(1);
+    vTaskDelay(pdMS_TO_TICKS(1500));
+}
+
+static void check_stacks(void) {
+    task_stats_t stats[TASKS_MAX_STATS];
+    int num_stats = Tasks__Get_stats(stats, TASKS_MAX_STATS);
+    CHECK(num_stats > 0);
+
+    printf("stack never used, bytes (host frames):\n");
+    for (uint8_t i = 0; i < NUM_MEASURED; i++) {
+        uint8_t found = 0;
+        for (int k = 0; k < num_stats; k++) {
+            // Names are cut to configMAX_TASK_NAME_LEN, as on the target
+            if (strncmp(stats[k].name, Measured[i], configMAX_TASK_NAME_LEN - 1) != 0) {
+                continue;
+            }
+            found = 1;
+            printf("  %-28s %5lu of %5lu\n", Measured[i], (unsigned long)stats[k].stack_free,
+                   (unsigned long)stats[k].stack_size);
+            CHECK(stats[k].stack_size > 0);
+            if (stats[k].stack_free < STACK_MARGIN) {
+                printf("FAIL %s: %lu bytes left, want %u\n", Measured[i], (unsigned long)stats[k].stack_free, STACK_MARGIN);
+                Test_failures++;
+            }
+        }
+        if (!found) {
+            printf("FAIL %s not running\n", Measured[i]);
+            Test_failures++;
+        }
+    }
+}
+
+int main(void) {
+    host_log_level = ESP_LOG_INFO;
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+    EventSystem_Initialize();
+    EventSystem_StartTasks();
+    View__Initialize();
+    vTaskDelay(pdMS_TO_TICKS(500));
+
+    workload();
+    check_stacks();
+    Tasks__Log_stats();
+    return TEST_RESULT();
+}
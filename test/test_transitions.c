@@ -0,0 +1,195 @@
+/* Menu <-> view transitions (view.h VIEW_TRANSITION_*), driven the way a user does it: BTN1
+    on the menu opens the weather view and BTN1 again goes back. Every frame the display task
+    builds is checked against the two views mixed per pixel, from the mapping each transition
+    describes, for both directions: VIEW_TRANSITION_FRAMES - 1 mixed frames, then the new view.
+    Input during a transition cuts it short, releasing the button that started it does not,
+    and the transition stats count both.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "led_driver.h"
+#include "view.h"
+#include "menu.h"
+#include "weather.h"
+#include "mqtt_protocol.h"
+
+// view.c internals
+void build_new_view(void);
+void push_view_to_display(void);
+uint8_t dissolve_order(uint8_t);
+
+#define UI_BTN1         0x01
+#define UI_SIDE_CW      0x40
+#define UI_UP           0x100
+
+// One pass of the display task, paced like it
+static void show_frame(view_frame_t *frame) {
+    vTaskDelay(pdMS_TO_TICKS(VIEW_MIN_FRAME_INTERVAL_MS));
+    build_new_view();
+    push_view_to_display();
+    View__Get_frame(frame);
+}
+
+// Pixel (row, col) of one channel, row 0-15
+static uint8_t pixel(const uint16_t *rows, int8_t row, int8_t col) {
+    if (col < 0 || col > 15) {
+        return 0;
+    }
+    return (rows[row] >> col) & 1;
+}
+
+// Frame 1 to VIEW_TRANSITION_FRAMES - 1 of a transition, one pixel at a time.
+// Forward is menu to view: slide to the left, wipe top down.
+static void mix_naive(view_transition_t type, uint8_t reverse, const view_frame_t *from,
+                      const view_frame_t *to, uint8_t frame, view_frame_t *out) {
+    memset(out, 0, sizeof(*out));
+    for (uint8_t channel = 0; channel < 3; channel++) {
+        const uint16_t *old_rows = &from->rows[channel * 16];
+        const uint16_t *new_rows = &to->rows[channel * 16];
+        uint16_t *out_rows = &out->rows[channel * 16];
+
+        for (int8_t row = 0; row < 16; row++) {
+            for (int8_t col = 0; col < 16; col++) {
+                uint8_t lit = 0;
+                if (type == VIEW_TRANSITION_SLIDE) {
+                    int8_t shift = (int8_t)((frame * 16) / VIEW_TRANSITION_FRAMES);
+                    if (!reverse) {
+                        lit = (col < 16 - shift) ? pixel(old_rows, row, col + shift) : pixel(new_rows, row, col - (16 - shift));
+                    } else {
+                        lit = (col >= shift) ? pixel(old_rows, row, col - shift) : pixel(new_rows, row, col + (16 - shift));
+                    }
+                } else if (type == VIEW_TRANSITION_WIPE) {
+                    uint8_t num_rows = (uint8_t)((frame * 16) / VIEW_TRANSITION_FRAMES);
+                    uint8_t from_new = reverse ? (row >= 16 - num_rows) : (row < num_rows);
+                    lit = pixel(from_new ? new_rows : old_rows, row, col);
+                } else {
+                    uint16_t threshold = (uint16_t)((frame * 256) / VIEW_TRANSITION_FRAMES);
+                    uint8_t from_new = dissolve_order((uint8_t)(row * 16 + col)) < threshold;
+                    lit = pixel(from_new ? new_rows : old_rows, row, col);
+                }
+                out_rows[row] |= (uint16_t)(lit << col);
+            }
+        }
+    }
+}
+
+static void check_frame(const view_frame_t *frame, const view_frame_t *expected, const char *what, uint8_t n) {
+    if (memcmp(frame, expected, sizeof(*frame)) != 0) {
+        printf("FAIL %s frame %u differs\n", what, n);
+        Test_failures++;
+    }
+}
+
+// BTN1, then every frame until the new view is shown as is
+static void run_transition(view_transition_t type, uint8_t reverse, const view_frame_t *from,
+                           const view_frame_t *to, const char *what) {
+    view_frame_t frame;
+    view_frame_t expected;
+    view_sched_stats_t before;
+    view_sched_stats_t after;
+
+    View__Set_transition(type);
+    View__Get_sched_stats(&before);
+    View__Process_UI(UI_BTN1);
+    for (uint8_t n = 1; n < VIEW_TRANSITION_FRAMES; n++) {
+        show_frame(&frame);
+        mix_naive(type, reverse, from, to, n, &expected);
+        check_frame(&frame, &expected, what, n);
+        if (n == 1) {
+            View__Process_UI(UI_BTN1 | UI_UP);
+        }
+    }
+    show_frame(&frame);
+    check_frame(&frame, to, what, VIEW_TRANSITION_FRAMES);
+    View__Get_sched_stats(&after);
+
+    CHECK_EQ(after.num_transitions - before.num_transitions, 1);
+    CHECK_EQ(after.num_transitions_cancelled, before.num_transitions_cancelled);
+    // Frames VIEW_MIN_FRAME_INTERVAL_MS apart: about 33 fps
+    printf("%s: %u.%u fps\n", what, after.transition_fps_x10 / 10, after.transition_fps_x10 % 10);
+    CHECK(after.transition_fps_x10 > 150);
+    CHECK(after.transition_fps_x10 <= 10000 / VIEW_MIN_FRAME_INTERVAL_MS);
+
+    // Over: nothing changes from here on
+    show_frame(&frame);
+    check_frame(&frame, to, what, VIEW_TRANSITION_FRAMES + 1);
+}
+
+// Side encoder on the weather view a few frames in: the next frame is the view, no more mixing
+static void test_cancel(const view_frame_t *menu) {
+    view_frame_t frame;
+    view_frame_t expected;
+    view_sched_stats_t before;
+    view_sched_stats_t after;
+
+    View__Set_transition(VIEW_TRANSITION_WIPE);
+    View__Get_sched_stats(&before);
+    View__Process_UI(UI_BTN1);
+    for (uint8_t n = 0; n < 3; n++) {
+        show_frame(&frame);
+    }
+    View__Process_UI(UI_SIDE_CW);
+    show_frame(&frame);
+    View__Get_sched_stats(&after);
+
+    // What the weather view renders after the turn, without a transition
+    View__Set_transition(VIEW_TRANSITION_NONE);
+    View__Request_update();
+    show_frame(&expected);
+    check_frame(&frame, &expected, "cancelled", 4);
+    CHECK(memcmp(&frame, menu, sizeof(frame)) != 0);
+    CHECK_EQ(after.num_transitions - before.num_transitions, 1);
+    CHECK_EQ(after.num_transitions_cancelled - before.num_transitions_cancelled, 1);
+}
+
+// Every pixel switches over exactly once in a dissolve
+static void test_dissolve_order(void) {
+    uint8_t seen[256];
+    memset(seen, 0, sizeof(seen));
+    for (uint16_t i = 0; i < 256; i++) {
+        seen[dissolve_order((uint8_t)i)]++;
+    }
+    for (uint16_t i = 0; i < 256; i++) {
+        CHECK_EQ(seen[i], 1);
+    }
+}
+
+int main(void) {
+    static const view_transition_t Types[] = {VIEW_TRANSITION_SLIDE, VIEW_TRANSITION_WIPE, VIEW_TRANSITION_DISSOLVE};
+    static const char *Names[] = {"slide", "wipe", "dissolve"};
+    uint8_t current[1] = {TEMP_OFFSET + 72};
+    uint8_t forecast[10] = {0, 85, 40, 3, 79, 10, 4, 68, 90, 5};
+    view_frame_t menu;
+    view_frame_t weather;
+    char what[32];
+
+    test_dissolve_order();
+
+    Led_driver__Initialize();
+    Menu__Initialize();
+    Weather__Initialize();
+    Weather__Update_values(0, current, sizeof(current));
+    Weather__Update_values(1, forecast, sizeof(forecast));
+
+    // Both ends of every transition, snapped to
+    View__Set_transition(VIEW_TRANSITION_NONE);
+    View__Set_view(VIEW_WEATHER);
+    show_frame(&weather);
+    View__Set_view(VIEW_MENU);
+    show_frame(&menu);
+    CHECK(memcmp(&menu, &weather, sizeof(menu)) != 0);
+
+    for (uint8_t i = 0; i < 3; i++) {
+        snprintf(what, sizeof(what), "%s to view", Names[i]);
+        run_transition(Types[i], 0, &menu, &weather, what);
+        snprintf(what, sizeof(what), "%s to menu", Names[i]);
+        run_transition(Types[i], 1, &weather, &menu, what);
+    }
+    test_cancel(&menu);
+    return TEST_RESULT();
+}
@@ -0,0 +1,50 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Minimal assertions for the host tests: a failed CHECK reports and counts, the test keeps
+    going, and TEST_RESULT() turns the count into the exit code ctest looks at.
+*/
+
+static int Test_failures;
+
+#define CHECK(cond) do {                                                                    \
+        if (!(cond)) {                                                                      \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);                          \
+            Test_failures++;                                                                \
+        }                                                                                   \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) do {                                                     \
+        long long actual_ = (long long)(actual);                                            \
+        long long expected_ = (long long)(expected);                                        \
+        if (actual_ != expected_) {                                                         \
+            printf("FAIL %s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual,  \
+                   actual_, expected_);                                                     \
+            Test_failures++;                                                                \
+        }                                                                                   \
+    } while (0)
+
+#define TEST_RESULT() (printf("%s\n", Test_failures ? "FAILED" : "OK"), Test_failures ? 1 : 0)
+
+// Wall clock ns for microbenchmarks
+static inline uint64_t test_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+// Deterministic test data, independent of esp_random and View__Random
+static inline uint32_t test_random(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+#endif
@@ -0,0 +1,161 @@
+/* Weather view's retained scene: each sprite is rasterized once per value and color and ORed
+    in from its cache after that. Random MQTT updates, comm losses and day switches are fed in,
+    and every frame rendered with the warm cache must equal the frame a freshly initialized view
+    renders after the same inputs (empty cache, every sprite rasterized). Benchmarks a cached
+    sprite merge against rasterizing it.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "view.h"
+#include "weather.h"
+#include "sprite.h"
+#include "mqtt_protocol.h"
+
+// weather.c internals
+void add_scene_sprite(uint8_t, SPRITE_TYPE, COLOR_TYPE, uint8_t, view_frame_t *);
+
+#define NUM_STEPS           300
+#define BENCH_RENDERS       200000
+#define SCENE_MAX_TEMP      0       // Slot of weather.c Scene_sprite_type
+
+typedef enum {
+    STEP_CURRENT,
+    STEP_FORECAST,
+    STEP_COMM_LOSS,
+    STEP_DAY,
+    NUM_STEP_TYPES
+} step_type_t;
+
+typedef struct {
+    step_type_t type;
+    uint8_t payload[10];
+} step_t;
+
+static step_t Steps[NUM_STEPS];
+
+static void apply(const step_t *step) {
+    uint8_t payload[10];
+    memcpy(payload, step->payload, sizeof(payload));
+    switch (step->type) {
+        case STEP_CURRENT:   Weather__Update_values(0, payload, 1);                 break;
+        case STEP_FORECAST:  Weather__Update_values(1, payload, sizeof(payload));   break;
+        case STEP_COMM_LOSS: Weather__Set_view_comm_loss();                         break;
+        default:             Weather__UI_Encoder_Top(step->payload[0] & 1);         break;
+    }
+}
+
+static void render(view_frame_t *frame) {
+    memset(frame, 0, sizeof(*frame));
+    Weather__Get_view(frame);
+}
+
+// Mostly small changes, like the real feed: one value moves, the rest repeat
+static void make_steps(void) {
+    uint32_t seed = 0x5EA7;
+    uint8_t forecast[10] = {0, 85, 40, 1, 79, 10, 2, 68, 100, 0};
+
+    for (uint16_t i = 0; i < NUM_STEPS; i++) {
+        step_t *step = &Steps[i];
+        uint32_t r = test_random(&seed);
+        step->type = (r % 16 == 0) ? STEP_COMM_LOSS : (step_type_t)(r % 4 == 3 ? STEP_DAY : r % 2);
+        if (step->type == STEP_CURRENT) {
+            step->payload[0] = (uint8_t)(TEMP_OFFSET - 20 + (test_random(&seed) % 130));
+        } else if (step->type == STEP_FORECAST) {
+            uint8_t field = 1 + (uint8_t)(test_random(&seed) % 9);
+            uint8_t value = (uint8_t)test_random(&seed);
+            switch (field % 3) {
+                case 1: forecast[field] = value % 110; break;   // max temp
+                case 2: forecast[field] = value % 102; break;   // precip, 100 and 101 drawn differently
+                case 0: forecast[field] = value % 3;   break;   // moon
+            }
+            memcpy(step->payload, forecast, sizeof(forecast));
+        } else {
+            step->payload[0] = (uint8_t)test_random(&seed);
+        }
+    }
+}
+
+static void test_against_cold(void) {
+    static view_frame_t warm[NUM_STEPS];
+    view_frame_t cold;
+    uint16_t num_bad = 0;
+
+    Weather__Initialize();
+    for (uint16_t i = 0; i < NUM_STEPS; i++) {
+        apply(&Steps[i]);
+        render(&warm[i]);
+    }
+
+    for (uint16_t i = 0; i < NUM_STEPS; i++) {
+        Weather__Initialize();
+        for (uint16_t j = 0; j <= i; j++) {
+            apply(&Steps[j]);
+        }
+        render(&cold);
+        if (memcmp(&cold, &warm[i], sizeof(cold)) != 0) {
+            if (num_bad == 0) {
+                printf("FAIL step %u (type %u): cached frame differs from a fresh render\n", i, Steps[i].type);
+            }
+            num_bad++;
+        }
+    }
+    CHECK_EQ(num_bad, 0);
+
+    // Rendering again with nothing changed gives the same frame, and ORs rather than overwrites
+    view_frame_t again;
+    render(&again);
+    CHECK(memcmp(&again, &warm[NUM_STEPS - 1], sizeof(again)) == 0);
+    memset(&again, 0, sizeof(again));
+    again.rows[47] = 0x8001;
+    Weather__Get_view(&again);
+    CHECK_EQ(again.rows[47], warm[NUM_STEPS - 1].rows[47] | 0x8001);
+}
+
+// Same slot, a colour change alone redraws it
+static void test_color_key(void) {
+    view_frame_t red;
+    view_frame_t green;
+    memset(&red, 0, sizeof(red));
+    memset(&green, 0, sizeof(green));
+    Weather__Initialize();
+    add_scene_sprite(SCENE_MAX_TEMP, MAX_TEMP, RED, 42, &red);
+    add_scene_sprite(SCENE_MAX_TEMP, MAX_TEMP, GREEN, 42, &green);
+    CHECK(memcmp(red.red, green.green, sizeof(red.red)) == 0);
+    CHECK_EQ(green.red[0] | green.red[5], 0);
+}
+
+static void bench(void) {
+    view_frame_t frame;
+    volatile uint16_t sink = 0;
+
+    Weather__Initialize();
+    uint64_t start_ns = test_now_ns();
+    for (uint32_t n = 0; n < BENCH_RENDERS; n++) {
+        add_scene_sprite(SCENE_MAX_TEMP, MAX_TEMP, RED, 42, &frame);
+        sink ^= frame.rows[n % VIEW_FRAME_ROWS];
+    }
+    uint64_t cached_ns = (test_now_ns() - start_ns) / BENCH_RENDERS;
+
+    start_ns = test_now_ns();
+    for (uint32_t n = 0; n < BENCH_RENDERS; n++) {
+        add_scene_sprite(SCENE_MAX_TEMP, MAX_TEMP, RED, 42 + (n & 1), &frame);
+        sink ^= frame.rows[n % VIEW_FRAME_ROWS];
+    }
+    uint64_t raster_ns = (test_now_ns() - start_ns) / BENCH_RENDERS;
+
+    printf("max temp sprite, ns: cached %llu, rasterized %llu (host clock)\n",
+           (unsigned long long)cached_ns, (unsigned long long)raster_ns);
+    CHECK(cached_ns < raster_ns);
+    (void)sink;
+}
+
+int main(void) {
+    make_steps();
+    test_against_cold();
+    test_color_key();
+    bench();
+    return TEST_RESULT();
+}
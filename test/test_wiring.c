@@ -0,0 +1,202 @@
+/* Panel wiring tables (panel_wiring.h) against the hand-written translate functions they
+    replaced, for the original PCB: same 48 RAM rows for any frame, every view line lands on
+    exactly the row the old code put it, and the chips decode that image from the wire.
+    Also built with both mirrored mount options (test_wiring_flipped) to check the flips
+    are applied on top of the same table.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "esp_timer.h"
+#include "led_driver.h"
+#include "led_emulator.h"
+
+// led_driver.c internals
+typedef struct {
+    uint16_t red[24];
+    uint16_t blue[24];
+} RAM_image_t;
+void translate_view_to_RAM(const view_frame_t*, RAM_image_t*);
+
+#define NUM_RANDOM_FRAMES   10000
+
+// Old translate functions, verbatim
+static void old_translate_views_to_RAM_red(uint16_t *view_red, uint16_t *view_green, uint16_t *ret_RAM_red) {
+    ret_RAM_red[0] = view_green[2];     //col14
+    ret_RAM_red[1] = view_red[3];
+    ret_RAM_red[2] = view_green[3];
+    ret_RAM_red[3] = view_green[4];
+    ret_RAM_red[4] = view_red[5];
+    ret_RAM_red[5] = view_green[1];
+    ret_RAM_red[6] = view_red[1];
+    ret_RAM_red[7] = view_red[0];
+    ret_RAM_red[8] = view_green[5];
+    ret_RAM_red[9] = view_red[6];
+    ret_RAM_red[10] = view_green[6];
+    ret_RAM_red[11] = view_green[7];
+    ret_RAM_red[12] = view_red[8];
+    ret_RAM_red[13] = view_red[9];
+    ret_RAM_red[14] = view_green[9];
+    ret_RAM_red[15] = view_red[10];
+    ret_RAM_red[16] = view_red[11];
+    ret_RAM_red[17] = view_green[11];
+    ret_RAM_red[18] = view_red[12];
+    ret_RAM_red[19] = view_green[12];
+    ret_RAM_red[20] = view_green[13];
+    ret_RAM_red[21] = view_green[15];
+    ret_RAM_red[22] = view_green[14];
+    ret_RAM_red[23] = view_red[15];
+}
+
+static void old_translate_views_to_RAM_blue(uint16_t *view_red, uint16_t *view_green, uint16_t *view_blue, uint16_t *ret_RAM_blue) {
+    ret_RAM_blue[0] = view_green[10];
+    ret_RAM_blue[1] = view_blue[11];
+    ret_RAM_blue[2] = view_blue[12];
+    ret_RAM_blue[3] = view_red[13];
+    ret_RAM_blue[4] = view_blue[13];
+    ret_RAM_blue[5] = view_red[14];
+    ret_RAM_blue[6] = view_blue[14];
+    ret_RAM_blue[7] = view_blue[15];
+    ret_RAM_blue[8] = view_blue[10];
+    ret_RAM_blue[9] = view_blue[9];
+    ret_RAM_blue[10] = view_green[8];
+    ret_RAM_blue[11] = view_blue[8];
+    ret_RAM_blue[12] = view_blue[7];
+    ret_RAM_blue[13] = view_red[7];
+    ret_RAM_blue[14] = view_blue[6];
+    ret_RAM_blue[15] = view_blue[5];
+    ret_RAM_blue[16] = view_red[4];
+    ret_RAM_blue[17] = view_blue[4];
+    ret_RAM_blue[18] = view_blue[3];
+    ret_RAM_blue[19] = view_red[2];
+    ret_RAM_blue[20] = view_blue[2];
+    ret_RAM_blue[21] = view_green[0];
+    ret_RAM_blue[22] = view_blue[1];
+    ret_RAM_blue[23] = view_blue[0];
+}
+
+#if CONFIG_LED_PANEL_FLIP_Y
+static uint16_t reverse_16(uint16_t bits) {
+    uint16_t out = 0;
+    for (uint8_t bit = 0; bit < 16; bit++) {
+        if (bits & (1u << bit)) {
+            out |= (uint16_t)(0x8000 >> bit);
+        }
+    }
+    return out;
+}
+#endif
+
+// Old mapping with the mount options applied the obvious way: lines reversed, then bits
+static void old_translate(const view_frame_t *frame, RAM_image_t *RAM) {
+    view_frame_t mounted;
+    for (uint8_t line = 0; line < 16; line++) {
+#if CONFIG_LED_PANEL_FLIP_X
+        uint8_t src = 15 - line;
+#else
+        uint8_t src = line;
+#endif
+        mounted.red[line] = frame->red[src];
+        mounted.green[line] = frame->green[src];
+        mounted.blue[line] = frame->blue[src];
+#if CONFIG_LED_PANEL_FLIP_Y
+        mounted.red[line] = reverse_16(mounted.red[line]);
+        mounted.green[line] = reverse_16(mounted.green[line]);
+        mounted.blue[line] = reverse_16(mounted.blue[line]);
+#endif
+    }
+    old_translate_views_to_RAM_red(mounted.red, mounted.green, RAM->red);
+    old_translate_views_to_RAM_blue(mounted.red, mounted.green, mounted.blue, RAM->blue);
+}
+
+static void check_equal(const view_frame_t *frame, const char *what) {
+    RAM_image_t expected;
+    RAM_image_t actual;
+    old_translate(frame, &expected);
+    memset(&actual, 0xEE, sizeof(actual));
+    translate_view_to_RAM(frame, &actual);
+    if (memcmp(&actual, &expected, sizeof(actual)) != 0) {
+        printf("FAIL %s: RAM images differ\n", what);
+        Test_failures++;
+    }
+}
+
+static void test_random_frames(void) {
+    view_frame_t frame;
+    uint32_t seed = 0xC0FFEE;
+    for (uint32_t i = 0; i < NUM_RANDOM_FRAMES; i++) {
+        for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+            frame.rows[row] = (uint16_t)test_random(&seed);
+        }
+        check_equal(&frame, "random frame");
+    }
+}
+
+// One full line at a time: it must show up in exactly one RAM row, and the 48 lines must
+// cover all 48 rows (the table is a permutation)
+static void test_lines(void) {
+    view_frame_t frame;
+    RAM_image_t RAM;
+    uint8_t hits[48];
+    memset(hits, 0, sizeof(hits));
+
+    for (uint8_t line = 0; line < VIEW_FRAME_ROWS; line++) {
+        memset(&frame, 0, sizeof(frame));
+        frame.rows[line] = 0xFFFF;
+        check_equal(&frame, "single line");
+
+        translate_view_to_RAM(&frame, &RAM);
+        uint8_t num_rows = 0;
+        for (uint8_t row = 0; row < 24; row++) {
+            if (RAM.red[row]) {
+                num_rows++;
+                hits[row]++;
+            }
+            if (RAM.blue[row]) {
+                num_rows++;
+                hits[24 + row]++;
+            }
+        }
+        CHECK_EQ(num_rows, 1);
+    }
+    for (uint8_t row = 0; row < 48; row++) {
+        CHECK_EQ(hits[row], 1);
+    }
+}
+
+// Through the driver and the wire: the emulated chips hold the old mapping
+static void test_emulator(void) {
+    view_frame_t frame;
+    RAM_image_t expected;
+    uint16_t rows[LED_EMULATOR_RAM_ROWS];
+    led_driver_stats_t stats;
+    uint32_t seed = 3;
+
+    Led_emulator__Set_error_clock_hz(0);
+    Led_driver__Initialize();
+    for (uint8_t row = 0; row < VIEW_FRAME_ROWS; row++) {
+        frame.rows[row] = (uint16_t)test_random(&seed);
+    }
+    Led_driver__Get_stats(&stats);
+    uint32_t num_frames = stats.num_frames;
+    Led_driver__Update_RAM(&frame);
+    int64_t give_up_us = esp_timer_get_time() + 5000000;
+    while (stats.num_frames == num_frames && esp_timer_get_time() < give_up_us) {
+        Led_driver__Get_stats(&stats);
+    }
+
+    old_translate(&frame, &expected);
+    Led_emulator__Get_RAM_rows(CS_RED, rows);
+    CHECK(memcmp(rows, expected.red, sizeof(rows)) == 0);
+    Led_emulator__Get_RAM_rows(CS_BLUE, rows);
+    CHECK(memcmp(rows, expected.blue, sizeof(rows)) == 0);
+}
+
+int main(void) {
+    test_lines();
+    test_random_frames();
+    test_emulator();
+    return TEST_RESULT();
+}
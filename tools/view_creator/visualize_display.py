@@ -17,12 +17,19 @@ Examples:
   python tools/visualize_display.py --input examples/sample.json --show
   python tools/visualize_display.py --input examples/sample.json --outfile out.png --scale 20
   python tools/visualize_display.py --input examples/sample.json --ascii
+
+Frame flight recorder (device dump, see docs/MQTT_PROTOCOL.md 0x32/0x33):
+  python tools/visualize_display.py recorder.bin --replay
+  python tools/visualize_display.py recorder.bin --replay --speed 4
+  python tools/visualize_display.py recorder.bin --replay --outfile replay.gif
+The file is either the reassembled dump or the raw 0x33 chunk messages back to back.
 """
 
 import argparse
 import json
 import os
 import sys
+import time
 from typing import List, Tuple
 
 # Optional Pillow import for image output
@@ -34,6 +41,8 @@ except Exception:
 WIDTH = 16
 HEIGHT = 16
 
+MSG_TYPE_RECORDER_CHUNK = 0x33
+
 def _ensure_16_rows(name: str, arr: List[int]) -> List[int]:
     if len(arr) != HEIGHT:
         raise ValueError(f"{name} must have {HEIGHT} elements (rows), got {len(arr)}")
@@ -189,6 +198,93 @@ def load_input_json(path: str) -> Tuple[List[int], List[int], List[int]]:
         raise ValueError(f"Missing key in JSON: {e}")
     return red, green, blue
 
+def _reassemble_recorder_chunks(data: bytes) -> bytes:
+    chunks = {}
+    num_chunks = 0
+    idx = 0
+    while idx + 2 <= len(data):
+        msg_type, length = data[idx], data[idx + 1]
+        payload = data[idx + 2: idx + 2 + length]
+        idx += 2 + length
+        if msg_type != MSG_TYPE_RECORDER_CHUNK or len(payload) < 2:
+            raise ValueError(f"Unexpected message 0x{msg_type:02X} in recorder chunks")
+        chunks[payload[0]] = payload[2:]
+        num_chunks = payload[1]
+    missing = [i for i in range(num_chunks) if i not in chunks]
+    if missing:
+        raise ValueError(f"Recorder dump incomplete, missing chunks {missing}")
+    return b''.join(chunks[i] for i in range(num_chunks))
+
+def load_recorder_dump(path: str) -> List[Tuple[int, int, List[int], List[int], List[int]]]:
+    """Frames as (time_ms, view, red, green, blue), oldest first."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    # A dump starts with num_frames (uint16, far below 0x3300): 0x33 first means chunk messages
+    if data and data[0] == MSG_TYPE_RECORDER_CHUNK:
+        data = _reassemble_recorder_chunks(data)
+    if len(data) < 2:
+        raise ValueError("Recorder dump too short")
+
+    num_frames = int.from_bytes(data[0:2], 'big')
+    if num_frames == 0:
+        return []
+    idx = 2
+    time_ms = int.from_bytes(data[idx:idx + 4], 'big')
+    view = data[idx + 4]
+    idx += 5
+    rows = [int.from_bytes(data[idx + 2 * i: idx + 2 * i + 2], 'big') for i in range(3 * HEIGHT)]
+    idx += 2 * 3 * HEIGHT
+    frames = [(time_ms, view, rows[0:16], rows[16:32], rows[32:48])]
+
+    for _ in range(num_frames - 1):
+        time_ms = int.from_bytes(data[idx:idx + 4], 'big')
+        view = data[idx + 4]
+        num_rows = data[idx + 5]
+        idx += 6
+        rows = list(rows)
+        for _ in range(num_rows):
+            row = data[idx]
+            rows[row] ^= int.from_bytes(data[idx + 1:idx + 3], 'big')
+            idx += 3
+        frames.append((time_ms, view, rows[0:16], rows[16:32], rows[32:48]))
+    return frames
+
+def replay(frames, msb_left: bool, use_color: bool, speed: float, outfile: str = None, scale: int = 16) -> None:
+    """Play recorded frames at their original spacing (divided by speed)."""
+    if not frames:
+        print('Recorder dump holds no frames.', file=sys.stderr)
+        return
+
+    if outfile:
+        if Image is None:
+            print("Pillow (PIL) not available. Install with: pip install pillow", file=sys.stderr)
+            return
+        images = []
+        durations = []
+        for i, (time_ms, view, red, green, blue) in enumerate(frames):
+            matrix = build_rgb_matrix(red, green, blue, msb_left=msb_left)
+            img = Image.new('RGB', (WIDTH, HEIGHT))
+            for y in range(HEIGHT):
+                for x in range(WIDTH):
+                    img.putpixel((x, y), matrix[y][x])
+            images.append(img.resize((WIDTH * scale, HEIGHT * scale), resample=Image.NEAREST))
+            next_ms = frames[i + 1][0] if i + 1 < len(frames) else time_ms + 1000
+            durations.append(max(20, int((next_ms - time_ms) / speed)))
+        images[0].save(outfile, save_all=True, append_images=images[1:], duration=durations, loop=0)
+        print(f"Saved {len(images)} frames to {outfile}")
+        return
+
+    first_ms = frames[0][0]
+    start = time.monotonic()
+    for i, (time_ms, view, red, green, blue) in enumerate(frames):
+        delay = (time_ms - first_ms) / 1000.0 / speed - (time.monotonic() - start)
+        if delay > 0:
+            time.sleep(delay)
+        if use_color:
+            print('\033[H\033[2J', end='')
+        print(f"frame {i + 1}/{len(frames)}  t={time_ms} ms  view={view}")
+        render_ascii(build_rgb_matrix(red, green, blue, msb_left=msb_left), use_color=use_color)
+
 def main():
     parser = argparse.ArgumentParser(description='Visualize 16x16 RGB matrix from three 16-bit row arrays')
     parser.add_argument('input', nargs='?', default=None, help='Path to JSON file with keys red/green/blue (each 16-element list)')
@@ -198,9 +294,18 @@ def main():
     parser.add_argument('--scale', type=int, default=16, help='Pixel scaling factor for image output (default: 16)')
     parser.add_argument('--outfile', type=str, help='Output image path (PNG recommended)')
     parser.add_argument('--show', action='store_true', help='Open image viewer after rendering')
+    parser.add_argument('--replay', action='store_true', help='Input is a frame recorder dump: play it back (ASCII, or animated GIF with --outfile)')
+    parser.add_argument('--speed', type=float, default=1.0, help='Replay speed factor (default: 1.0 = original timing)')
 
     args = parser.parse_args()
 
+    if args.replay:
+        if args.input is None:
+            parser.error('--replay needs a recorder dump file')
+        replay(load_recorder_dump(args.input), msb_left=args.msb_left, use_color=not args.no_color,
+               speed=args.speed, outfile=args.outfile, scale=args.scale)
+        return
+
     if args.input is None:
         print('No input file provided. Using a simple demo pattern.', file=sys.stderr)
         # Demo: diagonal red, anti-diagonal green, border blue